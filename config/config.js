@@ -1,14 +1,9 @@
-// Get query parameters
+// Get query parameters. They are read from the whole URL: when the page is
+// opened as a data: URI (bundled with the app) there is no location.search,
+// and the parameters and the emulator's return_to follow the page text
 function getQueryParam(param) {
-  var query = location.search.substring(1);
-  var vars = query.split('&');
-  for (var i = 0; i < vars.length; i++) {
-    var pair = vars[i].split('=');
-    if (decodeURIComponent(pair[0]) == param) {
-      return decodeURIComponent(pair[1]);
-    }
-  }
-  return null;
+  var match = location.href.match(new RegExp('[?&]' + param + '=([^&#]*)'));
+  return match ? decodeURIComponent(match[1]) : null;
 }
 
 // Default values
@@ -24,10 +19,69 @@ var baseUrl = getQueryParam('base_url');
 var model = getQueryParam('model');
 var systemMessage = getQueryParam('system_message');
 var webSearchEnabled = getQueryParam('web_search_enabled');
+var captureEnabled = getQueryParam('capture_enabled');
+var latencyBudget = getQueryParam('latency_budget_ms');
+var skipConfirmation = getQueryParam('skip_dictation_confirmation');
+var responseCacheEnabled = getQueryParam('response_cache_enabled');
+var perfStats = getQueryParam('perf_stats');
 
 // Get return_to for emulator support (falls back to pebblejs://close# for real hardware)
 var returnTo = getQueryParam('return_to') || 'pebblejs://close#';
 
+// Upper bound of the bucket holding the given percentile ("> last bound" for the overflow bucket)
+function percentileLabel(counts, buckets, percentile, unit) {
+  var total = counts.reduce(function(sum, count) { return sum + count; }, 0);
+  if (total === 0) {
+    return '-';
+  }
+
+  var cumulative = 0;
+  for (var i = 0; i < counts.length; i++) {
+    cumulative += counts[i];
+    if (cumulative >= total * percentile) {
+      return i < buckets.length ? '\u2264 ' + buckets[i] + ' ' + unit : '> ' + buckets[buckets.length - 1] + ' ' + unit;
+    }
+  }
+  return '-';
+}
+
+// Render the performance statistics passed by the app (one table per model and endpoint)
+function renderStats(container, stats) {
+  var rows = [
+    ['Time to first byte', 'ttfb', 'ms'],
+    ['API time', 'total', 'ms'],
+    ['Bluetooth transfer', 'transfer', 'ms'],
+    ['Response size', 'bytes', 'B']
+  ];
+
+  Object.keys(stats.entries).forEach(function(key) {
+    var entry = stats.entries[key];
+    var heading = document.createElement('h3');
+    heading.textContent = key;
+    container.appendChild(heading);
+
+    var table = document.createElement('table');
+    table.className = 'stats';
+    var addRow = function(label, value) {
+      var row = table.insertRow();
+      row.insertCell().textContent = label;
+      row.insertCell().textContent = value;
+    };
+
+    addRow('Requests', Math.round(entry.requests) + ' (' + Math.round(entry.errors) + ' errors, ' + Math.round(entry.timeouts) + ' timeouts)');
+    var lookups = (entry.cacheHits || 0) + (entry.cacheMisses || 0);
+    if (lookups > 0) {
+      addRow('Cache hits', Math.round(100 * entry.cacheHits / lookups) + '% of ' + Math.round(lookups) + ' questions');
+    }
+    rows.forEach(function(row) {
+      var counts = entry[row[1]] || [];
+      var buckets = stats.buckets[row[1]];
+      addRow(row[0], percentileLabel(counts, buckets, 0.5, row[2]) + ' / ' + percentileLabel(counts, buckets, 0.95, row[2]));
+    });
+    container.appendChild(table);
+  });
+}
+
 // Initialize form when DOM is loaded
 document.addEventListener('DOMContentLoaded', function() {
   var apiKeyInput = document.getElementById('api-key');
@@ -41,6 +95,10 @@ document.addEventListener('DOMContentLoaded', function() {
   document.getElementById('model').value = model || defaults.model;
   document.getElementById('system-message').value = systemMessage || defaults.system_message;
   document.getElementById('web-search').checked = webSearchEnabled === 'true';
+  document.getElementById('capture').checked = captureEnabled === 'true';
+  document.getElementById('latency-budget').value = latencyBudget || '';
+  document.getElementById('skip-confirmation').checked = skipConfirmation === 'true';
+  document.getElementById('response-cache').checked = responseCacheEnabled === 'true';
 
   // Function to toggle advanced fields visibility
   function toggleAdvancedFields() {
@@ -56,21 +114,52 @@ document.addEventListener('DOMContentLoaded', function() {
   // Listen for API key changes
   apiKeyInput.addEventListener('input', toggleAdvancedFields);
 
-  // Save button handler
-  document.getElementById('save-button').addEventListener('click', function() {
-    var settings = {
+  // Settings as currently entered in the form
+  function getFormSettings() {
+    return {
       api_key: apiKeyInput.value.trim(),
       base_url: document.getElementById('base-url').value.trim(),
       model: document.getElementById('model').value.trim(),
       system_message: document.getElementById('system-message').value.trim(),
-      web_search_enabled: document.getElementById('web-search').checked.toString()
+      web_search_enabled: document.getElementById('web-search').checked.toString(),
+      capture_enabled: document.getElementById('capture').checked.toString(),
+      latency_budget_ms: document.getElementById('latency-budget').value.trim(),
+      skip_dictation_confirmation: document.getElementById('skip-confirmation').checked.toString(),
+      response_cache_enabled: document.getElementById('response-cache').checked.toString()
     };
+  }
+
+  // Save button handler
+  document.getElementById('save-button').addEventListener('click', function() {
+    var settings = getFormSettings();
 
     // Send settings back to Pebble (works for both emulator and real hardware)
     var url = returnTo + encodeURIComponent(JSON.stringify(settings));
     document.location = url;
   });
 
+  // Performance statistics (only passed by the app, not when the page is opened elsewhere)
+  if (perfStats) {
+    try {
+      var stats = JSON.parse(perfStats);
+      if (Object.keys(stats.entries).length > 0) {
+        renderStats(document.getElementById('stats'), stats);
+        document.getElementById('stats-section').style.display = '';
+      }
+    } catch (e) {
+      console.log('Invalid performance statistics: ' + e);
+    }
+  }
+
+  // Reset statistics button handler (the entered settings are saved along)
+  document.getElementById('reset-stats-button').addEventListener('click', function() {
+    var settings = getFormSettings();
+    settings.reset_stats = 'true';
+
+    var url = returnTo + encodeURIComponent(JSON.stringify(settings));
+    document.location = url;
+  });
+
   // Reset button handler
   document.getElementById('reset-button').addEventListener('click', function() {
     // Clear all form fields
@@ -79,6 +168,10 @@ document.addEventListener('DOMContentLoaded', function() {
     document.getElementById('model').value = defaults.model;
     document.getElementById('system-message').value = defaults.system_message;
     document.getElementById('web-search').checked = false;
+    document.getElementById('capture').checked = false;
+    document.getElementById('latency-budget').value = '';
+    document.getElementById('skip-confirmation').checked = false;
+    document.getElementById('response-cache').checked = false;
 
     // Toggle advanced fields visibility
     toggleAdvancedFields();
@@ -89,7 +182,11 @@ document.addEventListener('DOMContentLoaded', function() {
       base_url: defaults.base_url,
       model: defaults.model,
       system_message: defaults.system_message,
-      web_search_enabled: 'false'
+      web_search_enabled: 'false',
+      capture_enabled: 'false',
+      latency_budget_ms: '',
+      skip_dictation_confirmation: 'false',
+      response_cache_enabled: 'false'
     };
 
     var url = returnTo + encodeURIComponent(JSON.stringify(settings));
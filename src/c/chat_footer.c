@@ -9,6 +9,7 @@ struct ChatFooter {
   Layer *layer;
   ClaudeSparkLayer *spark;
   TextLayer *text_layer;
+  char status[CHAT_FOOTER_STATUS_SIZE];
   int height;
 };
 
@@ -52,6 +53,7 @@ ChatFooter* chat_footer_create(int width) {
   footer->text_layer = text_layer_create(GRect(text_x, text_y, text_width, text_size.h));
   text_layer_set_text(footer->text_layer, CHAT_FOOTER_DISCLAIMER_TEXT);
   text_layer_set_font(footer->text_layer, fonts_get_system_font(TEXT_FONT));
+  text_layer_set_overflow_mode(footer->text_layer, GTextOverflowModeTrailingEllipsis);
   text_layer_set_text_alignment(footer->text_layer, GTextAlignmentLeft);
   text_layer_set_text_color(footer->text_layer, GColorDarkGray);
   text_layer_set_background_color(footer->text_layer, GColorClear);
@@ -97,6 +99,23 @@ void chat_footer_stop_animation(ChatFooter *footer) {
   }
 }
 
+void chat_footer_set_status(ChatFooter *footer, const char *status) {
+  if (!footer || !footer->text_layer) {
+    return;
+  }
+
+  if (!status || !*status) {
+    footer->status[0] = '\0';
+    text_layer_set_text(footer->text_layer, CHAT_FOOTER_DISCLAIMER_TEXT);
+    return;
+  }
+
+  // Only the text layer is redrawn; the footer frame (and so the layout) stays
+  strncpy(footer->status, status, sizeof(footer->status) - 1);
+  footer->status[sizeof(footer->status) - 1] = '\0';
+  text_layer_set_text(footer->text_layer, footer->status);
+}
+
 int chat_footer_get_height(ChatFooter *footer) {
   return footer ? footer->height : 0;
 }
@@ -5,11 +5,15 @@
  * Chat Footer Component
  *
  * Displays a small Claude spark icon with "Claude can make mistakes." disclaimer.
- * Shown at the bottom of the chat conversation.
+ * Shown at the bottom of the chat conversation. While a response is on its
+ * way, a short status (e.g. web search progress) can replace the disclaimer.
  */
 
 #define CHAT_FOOTER_DISCLAIMER_TEXT "Claude\ncan make\nmistakes."
 
+// Maximum size of a status including the terminating NUL
+#define CHAT_FOOTER_STATUS_SIZE 48
+
 typedef struct ChatFooter ChatFooter;
 
 /**
@@ -44,6 +48,14 @@ void chat_footer_start_animation(ChatFooter *footer);
  */
 void chat_footer_stop_animation(ChatFooter *footer);
 
+/**
+ * Show a status in place of the disclaimer.
+ * The footer keeps its size; a status that does not fit is cut with an ellipsis.
+ * @param footer The chat footer
+ * @param status The status text, or NULL to show the disclaimer again
+ */
+void chat_footer_set_status(ChatFooter *footer, const char *status);
+
 /**
  * Get the height of the footer (for layout calculations).
  * @param footer The chat footer
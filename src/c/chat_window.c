@@ -1,16 +1,49 @@
 #include "chat_window.h"
 #include "message_bubble.h"
+#include "message_pages.h"
+#include "text_pool.h"
+#include "conversation_store.h"
+#include "thread_index.h"
+#include "history_window.h"
+#include "reply_window.h"
+#include "request_queue.h"
+#include "conversation_codec.h"
 #include "chat_footer.h"
+#include "persist_keys.h"
+#include "memory_profile.h"
+#include "sniff_governor.h"
 #include "claude_spark.h"
 
-#define MAX_MESSAGES 10
 #define SCROLL_OFFSET 60
-#define MESSAGE_BUFFER_SIZE 4096
-
-// Message data structure
+#define SCROLL_REPEAT_INTERVAL 100
+#define SCROLL_ACCELERATION_REPEATS 4
+#define SCROLL_MAX_MULTIPLIER 4
+#define MULTI_CLICK_TIMEOUT 300
+#define RESTORE_BATCH_SIZE 2
+#define RESTORE_BATCH_INTERVAL 50
+#define FRAME_INTERVAL 100
+#define HISTORY_LONG_CLICK_DELAY 500
+#define REQUEST_RETRY_INTERVAL 3000
+#define THREAD_REQUEST_TIMEOUT 10000
+#define REQUEST_TUPLE_OVERHEAD 64
+#define MESSAGE_BUFFER_SIZE (APP_MESSAGE_OUTBOX_SIZE - REQUEST_TUPLE_OVERHEAD)
+#define MESSAGE_TEXT_SIZE 512
+#define TEXT_POOL_MIN_SIZE (2 * MESSAGE_TEXT_SIZE)
+#define SKIPPED_TEXT_MARKER "\n..."
+
+// Message data structure (y and height cache the layout in the content layer).
+// The in-RAM part of the text (up to s_message_text_size bytes) is allocated from
+// the text pool; text that does not fit continues in overflow pages.
 typedef struct {
-  char text[512];
+  char *text;
   bool is_user;
+  int16_t y;
+  int16_t height;
+  int16_t text_height;
+  uint8_t first_page;
+  uint8_t page_count;
+  bool queued;
+  bool skipped;
 } Message;
 
 // Global state for the chat window
@@ -21,20 +54,73 @@ static Layer *s_content_layer;
 static Layer *s_action_button_layer;
 static ChatFooter *s_footer;
 static DictationSession *s_dictation_session;
+static Window *s_history_window;
+static Window *s_reply_window;
 
-// Message storage (designed for dynamic updates)
-static Message s_messages[MAX_MESSAGES];
+// Message storage (designed for dynamic updates). How many messages are kept
+// follows the size of the text pool; MESSAGE_SLOT_COUNT only bounds the slot array.
+static Message s_messages[MESSAGE_SLOT_COUNT];
 static int s_message_count = 0;
 
-// Current UI state (bubble instances)
-static MessageBubble *s_bubbles[MAX_MESSAGES];
-static int s_bubble_count = 0;
+// Overflow pages are allocated as a ring, oldest message first
+static int16_t s_page_heights[MESSAGE_PAGE_COUNT];
+static int s_next_page = 0;
+static int s_pages_in_use = 0;
 
 static int s_content_width = 0;
 
+// Longest in-RAM part of a message text: MESSAGE_TEXT_SIZE, or the whole
+// text pool when the heap left room for less
+static size_t s_message_text_size = MESSAGE_TEXT_SIZE;
+
+// Background restore of older messages (index of the newest one not measured yet)
+static AppTimer *s_restore_timer;
+static int s_restore_index = -1;
+static uint32_t s_restore_start_ms;
+
+// Number of consecutive repeats of the held scroll button (drives acceleration)
+static int s_scroll_repeat_count = 0;
+
 // Chat state
 static bool s_waiting_for_response = false;
 
+// A response arrives in one or more RESPONSE_TEXT chunks until RESPONSE_END
+static bool s_response_open = false;
+
+// Frame scheduler: layout and redraw for incoming text run at most once per
+// FRAME_INTERVAL, so back-to-back chunks are appended without a pass each
+static AppTimer *s_frame_timer;
+static bool s_frame_pending = false;
+
+// Layout of the block of the response that is still growing (0 is the in-RAM
+// text, n is the n-th overflow page), so a frame only lays out its last line
+// and the new text
+static MessageBubbleLayout s_stream_layout;
+static int s_stream_block = 0;
+
+// Streaming statistics for the current response
+static uint32_t s_stream_start_ms;
+static uint32_t s_stream_handling_ms;
+static int s_stream_chars;
+static int s_stream_chunks;
+static int s_stream_frames;
+
+// Thread the conversation belongs to (0 until the first request is sent)
+static uint32_t s_thread_id = 0;
+
+// Outbound requests (queued in request_queue until answered)
+static bool s_request_in_flight = false;
+static uint32_t s_last_request_id = 0;
+static AppTimer *s_request_retry_timer;
+
+// Pending THREAD_REQUEST (the wait for the thread is released if no answer comes)
+static AppTimer *s_thread_request_timer;
+
+// Voice turn latency: time from the end of dictation until the request is sent
+static uint32_t s_dictation_end_ms = 0;
+static uint32_t s_send_latency_total_ms = 0;
+static int s_send_latency_count = 0;
+
 // Forward declarations
 static void rebuild_scroll_content(void);
 static void dictation_session_callback(DictationSession *session, DictationSessionStatus status, char *transcription, void *context);
@@ -42,10 +128,21 @@ static void up_click_handler(ClickRecognizerRef recognizer, void *context);
 static void down_click_handler(ClickRecognizerRef recognizer, void *context);
 static void click_config_provider(void *context);
 static void send_chat_request(void);
+static void start_dictation(void);
+static void flush_request_queue(void);
+static void connection_handler(bool connected);
 static void shift_messages(void);
-static void add_assistant_message(const char *text);
-static void scroll_to_bottom(void);
+static void add_assistant_text(const char *text);
+static void measure_message(Message *message);
+static uint32_t now_ms(void);
+static void scroll_to_bottom(bool animated);
+static void restore_conversation(void);
+static void save_conversation(void);
 static void action_button_update_proc(Layer *layer, GContext *ctx);
+static void content_update_proc(Layer *layer, GContext *ctx);
+static void prefetch_page_at(int content_y);
+static int find_message_at(int content_y);
+static void init_text_pool(void);
 
 static void window_load(Window *window) {
   Layer *window_layer = window_get_root_layer(window);
@@ -68,8 +165,9 @@ static void window_load(Window *window) {
   scroll_layer_set_shadow_hidden(s_scroll_layer, true);
   layer_add_child(window_layer, scroll_layer_get_layer(s_scroll_layer));
 
-  // Create content layer (will be resized in rebuild)
+  // Create content layer (will be resized in rebuild); it draws all messages itself
   s_content_layer = layer_create(GRect(0, 0, s_content_width, 100));
+  layer_set_update_proc(s_content_layer, content_update_proc);
   scroll_layer_add_child(s_scroll_layer, s_content_layer);
 
   // Create footer
@@ -80,15 +178,28 @@ static void window_load(Window *window) {
   layer_set_update_proc(s_action_button_layer, action_button_update_proc);
   layer_add_child(window_layer, s_action_button_layer);
 
+  // Size the message text pool from the heap left once the window is built
+  init_text_pool();
+
+  // Restore the saved conversation (older messages are laid out in the background)
+  restore_conversation();
+
   // Build the UI from message data
   rebuild_scroll_content();
+  scroll_to_bottom(false);
+
+  // Send requests left unanswered (e.g. made while the phone was disconnected)
+  connection_service_subscribe((ConnectionHandlers) {
+    .pebble_app_connection_handler = connection_handler,
+  });
+  if (request_queue_get_count() > 0) {
+    s_waiting_for_response = true;
+    flush_request_queue();
+  }
 
   // Start dictation session automatically when window loads
-  if (!s_waiting_for_response) {
-    s_dictation_session = dictation_session_create(sizeof(char) * 256, dictation_session_callback, NULL);
-    if (s_dictation_session) {
-      dictation_session_start(s_dictation_session);
-    }
+  if (!s_waiting_for_response && PBL_IF_MICROPHONE_ELSE(true, false)) {
+    start_dictation();
   }
 }
 
@@ -96,43 +207,15 @@ static void rebuild_scroll_content(void) {
   // Save current scroll position to restore after rebuild
   GPoint saved_offset = scroll_layer_get_content_offset(s_scroll_layer);
 
-  // Destroy old bubbles
-  for (int i = 0; i < s_bubble_count; i++) {
-    if (s_bubbles[i]) {
-      layer_remove_from_parent(message_bubble_get_layer(s_bubbles[i]));
-      message_bubble_destroy(s_bubbles[i]);
-      s_bubbles[i] = NULL;
-    }
-  }
-  s_bubble_count = 0;
-
   // Remove footer from content layer
   layer_remove_from_parent(chat_footer_get_layer(s_footer));
 
-  // Create new bubbles from message data
+  // Lay out messages from their cached heights (measured once when added)
   int y_offset = 0;
-  int bubble_max_width = s_content_width;
 
   for (int i = 0; i < s_message_count; i++) {
-    MessageBubble *bubble = message_bubble_create(
-      s_messages[i].text,
-      s_messages[i].is_user,
-      bubble_max_width
-    );
-
-    if (bubble) {
-      s_bubbles[s_bubble_count++] = bubble;
-
-      // Position bubble
-      Layer *bubble_layer = message_bubble_get_layer(bubble);
-      GRect frame = layer_get_frame(bubble_layer);
-      frame.origin.x = 0;
-      frame.origin.y = y_offset;
-      layer_set_frame(bubble_layer, frame);
-      layer_add_child(s_content_layer, bubble_layer);
-
-      y_offset += message_bubble_get_height(bubble);
-    }
+    s_messages[i].y = y_offset;
+    y_offset += s_messages[i].height;
   }
 
   // Add footer at the end
@@ -162,6 +245,116 @@ static void rebuild_scroll_content(void) {
 
   // Restore previous scroll position (prevents jumping during rebuilds)
   scroll_layer_set_content_offset(s_scroll_layer, saved_offset, false);
+  layer_mark_dirty(s_content_layer);
+
+  TextPoolStats pool = text_pool_get_stats();
+  APP_LOG(APP_LOG_LEVEL_DEBUG, "Layout: %d messages, %dpx, heap free %d, pool free %d of %d (largest %d)",
+          s_message_count, y_offset, (int)heap_bytes_free(),
+          (int)pool.free_bytes, (int)pool.total_bytes, (int)pool.largest_free_bytes);
+}
+
+static void content_update_proc(Layer *layer, GContext *ctx) {
+  // Only messages (and overflow pages) intersecting the visible part of the scroll layer are drawn
+  GPoint offset = scroll_layer_get_content_offset(s_scroll_layer);
+  GRect scroll_frame = layer_get_frame(scroll_layer_get_layer(s_scroll_layer));
+  int visible_top = -offset.y;
+  int visible_bottom = visible_top + scroll_frame.size.h;
+
+  for (int i = find_message_at(visible_top); i >= 0 && i < s_message_count; i++) {
+    const Message *message = &s_messages[i];
+    if (message->y >= visible_bottom) {
+      break;
+    }
+    if (message->height == 0) {
+      continue;  // Restored but not laid out yet
+    }
+
+    message_bubble_draw_background(ctx, GRect(0, message->y, s_content_width, message->height), message->is_user);
+
+    int block_y = message->y + MESSAGE_BUBBLE_TEXT_OFFSET;
+    message_bubble_draw_text(ctx, GRect(0, block_y, s_content_width, message->text_height), message->text);
+    block_y += message->text_height;
+
+    for (int p = 0; p < message->page_count && block_y < visible_bottom; p++) {
+      int page = (message->first_page + p) % MESSAGE_PAGE_COUNT;
+      if (block_y + s_page_heights[page] > visible_top) {
+        message_bubble_draw_text(ctx, GRect(0, block_y, s_content_width, s_page_heights[page]), message_pages_get(page));
+      }
+      block_y += s_page_heights[page];
+    }
+
+    if (message->queued) {
+      message_bubble_draw_status(ctx, GRect(0, message->y, s_content_width, message->height), "Queued");
+    }
+  }
+}
+
+static int find_message_at(int content_y) {
+  // Binary search over the message y offsets (a prefix sum of their heights).
+  // Returns the message containing content_y, the first one if content_y is
+  // above all messages, or -1 if there are none
+  if (s_message_count == 0) {
+    return -1;
+  }
+
+  int low = 0;
+  int high = s_message_count - 1;
+  while (low < high) {
+    int mid = (low + high + 1) / 2;
+    if (s_messages[mid].y <= content_y) {
+      low = mid;
+    } else {
+      high = mid - 1;
+    }
+  }
+  return low;
+}
+
+static void prefetch_page_at(int content_y) {
+  // Load the overflow page covering content_y (if any) before it scrolls into view
+  int index = find_message_at(content_y);
+  if (index < 0) {
+    return;
+  }
+
+  const Message *message = &s_messages[index];
+  if (content_y < message->y || content_y >= message->y + message->height) {
+    return;
+  }
+
+  int block_y = message->y + MESSAGE_BUBBLE_TEXT_OFFSET + message->text_height;
+  for (int p = 0; p < message->page_count; p++) {
+    int page = (message->first_page + p) % MESSAGE_PAGE_COUNT;
+    block_y += s_page_heights[page];
+    if (content_y < block_y) {
+      message_pages_prefetch(page);
+      return;
+    }
+  }
+}
+
+// Sizes the message text pool from the free heap (the pool must be empty).
+// Message text does not live on the heap, so evicting messages cannot give
+// memory back: the pool is re-sized whenever the conversation is replaced,
+// which is how the history follows the heap actually free.
+static void init_text_pool(void) {
+  text_pool_deinit();
+
+  size_t heap_free = heap_bytes_free();
+  size_t pool_size = heap_free > HEAP_SAFETY_MARGIN ? heap_free - HEAP_SAFETY_MARGIN : 0;
+  if (pool_size > TEXT_POOL_MAX_SIZE) {
+    pool_size = TEXT_POOL_MAX_SIZE;
+  } else if (pool_size < TEXT_POOL_MIN_SIZE) {
+    // The safety margin is kept even so: messages keep a shorter part in RAM
+    // and continue in overflow pages
+    APP_LOG(APP_LOG_LEVEL_WARNING, "Low memory: text pool limited to %d bytes", (int)pool_size);
+  }
+  if (!text_pool_init(pool_size)) {
+    APP_LOG(APP_LOG_LEVEL_ERROR, "Failed to allocate %d byte text pool", (int)pool_size);
+  }
+
+  size_t pool_bytes = text_pool_get_stats().total_bytes;
+  s_message_text_size = pool_bytes < MESSAGE_TEXT_SIZE ? pool_bytes : MESSAGE_TEXT_SIZE;
 }
 
 static void shift_messages(void) {
@@ -169,6 +362,13 @@ static void shift_messages(void) {
     return;
   }
 
+  // Release the text and overflow pages of the oldest message
+  text_pool_free(s_messages[0].text);
+  s_pages_in_use -= s_messages[0].page_count;
+  if (s_restore_index >= 0) {
+    s_restore_index--;
+  }
+
   // Shift all messages one position forward (removing the first/oldest message)
   for (int i = 0; i < s_message_count - 1; i++) {
     s_messages[i] = s_messages[i + 1];
@@ -178,37 +378,611 @@ static void shift_messages(void) {
   s_message_count--;
 }
 
-static void add_user_message(const char *text) {
-  if (s_message_count >= MAX_MESSAGES) {
-    // Message array is full, shift to make room
+// Allocates message text from the text pool, dropping the oldest messages
+// until the text fits (the pool was sized from the free heap at load)
+static char* allocate_message_text(size_t size) {
+  int evicted = 0;
+  char *text = text_pool_alloc(size);
+  while (!text && s_message_count > 0) {
     shift_messages();
+    evicted++;
+    text = text_pool_alloc(size);
   }
 
-  // Add the new message
-  snprintf(s_messages[s_message_count].text, sizeof(s_messages[s_message_count].text), "%s", text);
-  s_messages[s_message_count].is_user = true;
-  s_message_count++;
+  if (evicted > 0) {
+    TextPoolStats stats = text_pool_get_stats();
+    APP_LOG(APP_LOG_LEVEL_DEBUG, "Text pool full: dropped %d old messages, keeping %d (free %d, largest %d)",
+            evicted, s_message_count, (int)stats.free_bytes, (int)stats.largest_free_bytes);
+  }
+  return text;
+}
 
-  // Rebuild the UI to show the new message
-  rebuild_scroll_content();
+// Recycles the oldest overflow page of a message that fills the page ring on
+// its own, so a long message keeps its end. The in-RAM part stays, ending
+// with a marker for the text skipped after it.
+static void skip_first_page(Message *message) {
+  size_t current = strlen(message->text);
+  if (!message->skipped && current >= strlen(SKIPPED_TEXT_MARKER)) {
+    // The marker replaces the tail of the text, so it fits in the same allocation
+    size_t keep = message_pages_split_length(message->text, current, current - strlen(SKIPPED_TEXT_MARKER));
+    strcpy(message->text + keep, SKIPPED_TEXT_MARKER);
+    message->skipped = true;
+    if (s_response_open && !message->is_user) {
+      s_stream_block = 0;
+    }
+  }
+
+  message->first_page = (message->first_page + 1) % MESSAGE_PAGE_COUNT;
+  message->page_count--;
+  s_pages_in_use--;
+
+  // Blocks of the response being received move up by one
+  if (s_response_open && !message->is_user && s_stream_block > 0) {
+    s_stream_block--;
+  }
 }
 
-static void add_assistant_message(const char *text) {
-  if (s_message_count >= MAX_MESSAGES) {
-    // Message array is full, shift to make room
+// Appends text to the overflow pages of the last message: fills its last page,
+// then starts new ones at the head of the ring. Older messages are dropped
+// when the ring is full, then the message's own oldest pages.
+static void append_page_text(const char *text, size_t length) {
+  Message *message = &s_messages[s_message_count - 1];
+
+  while (length > 0) {
+    if (message->page_count > 0) {
+      int last_page = (message->first_page + message->page_count - 1) % MESSAGE_PAGE_COUNT;
+      const char *page_text = message_pages_get(last_page);
+      size_t current = strlen(page_text);
+      size_t take = message_pages_split_length(text, length, MESSAGE_PAGE_SIZE - 1 - current);
+
+      if (take > 0) {
+        char buffer[MESSAGE_PAGE_SIZE];
+        memcpy(buffer, page_text, current);
+        memcpy(buffer + current, text, take);
+        message_pages_write(last_page, buffer, current + take);
+
+        text += take;
+        length -= take;
+        continue;
+      }
+    }
+
+    while (s_pages_in_use >= MESSAGE_PAGE_COUNT && s_message_count > 1) {
+      shift_messages();
+    }
+    message = &s_messages[s_message_count - 1];
+    if (s_pages_in_use >= MESSAGE_PAGE_COUNT) {
+      skip_first_page(message);
+    }
+
+    // The last message's pages always end at the head of the ring
+    size_t take = message_pages_split_length(text, length, MESSAGE_PAGE_SIZE - 1);
+    message_pages_write(s_next_page, text, take);
+    message->page_count++;
+    s_next_page = (s_next_page + 1) % MESSAGE_PAGE_COUNT;
+    s_pages_in_use++;
+
+    text += take;
+    length -= take;
+  }
+}
+
+// Stores a message unmeasured (height 0); callers measure it once the layout is needed
+static bool store_message(const char *text, size_t length, bool is_user) {
+  if (s_message_text_size == 0) {
+    APP_LOG(APP_LOG_LEVEL_ERROR, "No text pool for a %d byte message", (int)length);
+    return false;
+  }
+  size_t text_length = message_pages_split_length(text, length, s_message_text_size - 1);
+
+  // Make room by dropping the oldest messages when the message slots are full
+  while (s_message_count >= MESSAGE_SLOT_COUNT) {
     shift_messages();
   }
 
-  // Add empty or initial assistant message
-  snprintf(s_messages[s_message_count].text, sizeof(s_messages[s_message_count].text), "%s", text);
-  s_messages[s_message_count].is_user = false;
+  char *message_text = allocate_message_text(text_length + 1);
+  if (!message_text) {
+    APP_LOG(APP_LOG_LEVEL_ERROR, "Out of memory for a %d byte message", (int)text_length);
+    return false;
+  }
+  if (s_message_count == 0) {
+    s_next_page = 0;
+  }
+
+  Message *message = &s_messages[s_message_count];
+  message->text = message_text;
+  memcpy(message->text, text, text_length);
+  message->text[text_length] = '\0';
+  message->is_user = is_user;
+  message->queued = false;
+  message->skipped = false;
+  message->y = 0;
+  message->height = 0;
+  message->text_height = 0;
+  message->first_page = s_next_page;
+  message->page_count = 0;
   s_message_count++;
 
-  // Rebuild UI
+  // Spill the rest of the text into overflow pages
+  append_page_text(text + text_length, length - text_length);
+  return true;
+}
+
+// Appends text to the last message (a response arriving in chunks). Older
+// messages are dropped when the text pool or the page ring is full.
+static void append_message_text(const char *text, size_t length) {
+  Message *message = &s_messages[s_message_count - 1];
+
+  // Grow the in-RAM part until it is full. The old text stays intact in the
+  // pool while the new space is found, so it is freed first and moved over.
+  if (message->page_count == 0) {
+    size_t current = strlen(message->text);
+    size_t take = message_pages_split_length(text, length, s_message_text_size - 1 - current);
+
+    if (take > 0) {
+      char *old_text = message->text;
+      text_pool_free(old_text);
+
+      char *grown = text_pool_alloc(current + take + 1);
+      while (!grown && s_message_count > 1) {
+        shift_messages();
+        grown = text_pool_alloc(current + take + 1);
+      }
+      message = &s_messages[s_message_count - 1];
+
+      if (!grown) {
+        // The pool cannot hold more even on its own: keep the text as it was
+        // (it fits in the slabs just freed) and continue in overflow pages
+        grown = text_pool_alloc(current + 1);
+        take = 0;
+      }
+
+      memmove(grown, old_text, current);
+      memcpy(grown + current, text, take);
+      grown[current + take] = '\0';
+      message->text = grown;
+
+      text += take;
+      length -= take;
+    }
+  }
+
+  append_page_text(text, length);
+}
+
+static uint32_t now_ms(void) {
+  time_t seconds;
+  uint16_t milliseconds;
+  time_ms(&seconds, &milliseconds);
+  return (uint32_t)seconds * 1000 + milliseconds;
+}
+
+static void measure_message(Message *message) {
+  message->text_height = message_bubble_measure_text_height(message->text, s_content_width);
+  message->height = message->text_height + MESSAGE_BUBBLE_PADDING_HEIGHT;
+
+  for (int p = 0; p < message->page_count; p++) {
+    int page = (message->first_page + p) % MESSAGE_PAGE_COUNT;
+    s_page_heights[page] = message_bubble_measure_text_height(message_pages_get(page), s_content_width);
+    message->height += s_page_heights[page];
+  }
+
+  if (message->queued) {
+    message->height += MESSAGE_BUBBLE_STATUS_HEIGHT;
+  }
+}
+
+static void restore_message_handler(const char *text, bool is_user, uint8_t first_page, uint8_t page_count, void *context) {
+  if (s_message_count >= MESSAGE_SLOT_COUNT) {
+    shift_messages();
+  }
+
+  size_t size = strlen(text) + 1;
+  char *message_text = allocate_message_text(size);
+  if (!message_text) {
+    return;
+  }
+
+  // Height stays 0 until the message is measured
+  Message *message = &s_messages[s_message_count++];
+  message->text = message_text;
+  memcpy(message->text, text, size);
+  message->is_user = is_user;
+  message->queued = false;
+  message->skipped = false;
+  message->y = 0;
+  message->height = 0;
+  message->text_height = 0;
+  message->first_page = first_page % MESSAGE_PAGE_COUNT;
+  message->page_count = page_count;
+}
+
+static void restore_timer_callback(void *context) {
+  s_restore_timer = NULL;
+
+  // Measure a small batch of older messages per tick to keep the UI responsive
+  int growth = 0;
+  for (int n = 0; n < RESTORE_BATCH_SIZE && s_restore_index >= 0; n++) {
+    measure_message(&s_messages[s_restore_index]);
+    growth += s_messages[s_restore_index].height;
+    s_restore_index--;
+  }
+
+  // Keep the viewport on the same messages while older ones appear above it
+  rebuild_scroll_content();
+  GPoint offset = scroll_layer_get_content_offset(s_scroll_layer);
+  offset.y -= growth;
+  scroll_layer_set_content_offset(s_scroll_layer, offset, false);
+
+  if (s_restore_index >= 0) {
+    s_restore_timer = app_timer_register(RESTORE_BATCH_INTERVAL, restore_timer_callback, NULL);
+  } else {
+    APP_LOG(APP_LOG_LEVEL_DEBUG, "Restore finished in %d ms", (int)(now_ms() - s_restore_start_ms));
+  }
+}
+
+static void restore_conversation(void) {
+  s_restore_start_ms = now_ms();
+
+  int count = conversation_store_load(&s_thread_id, restore_message_handler, NULL);
+  if (count == 0 || s_message_count == 0) {
+    return;
+  }
+
+  // Restored messages are a contiguous run of the page ring
+  const Message *last = &s_messages[s_message_count - 1];
+  s_pages_in_use = 0;
+  for (int i = 0; i < s_message_count; i++) {
+    s_pages_in_use += s_messages[i].page_count;
+  }
+  s_next_page = (last->first_page + last->page_count) % MESSAGE_PAGE_COUNT;
+
+  // Lay out the newest messages until the screen is full, the rest in the background
+  GRect scroll_frame = layer_get_frame(scroll_layer_get_layer(s_scroll_layer));
+  int filled = 0;
+  s_restore_index = s_message_count - 1;
+  while (s_restore_index >= 0 && filled < scroll_frame.size.h) {
+    measure_message(&s_messages[s_restore_index]);
+    filled += s_messages[s_restore_index].height;
+    s_restore_index--;
+  }
+
+  APP_LOG(APP_LOG_LEVEL_DEBUG, "Restored %d messages, first screen in %d ms",
+          s_message_count, (int)(now_ms() - s_restore_start_ms));
+
+  if (s_restore_index >= 0) {
+    s_restore_timer = app_timer_register(RESTORE_BATCH_INTERVAL, restore_timer_callback, NULL);
+  }
+}
+
+static void save_conversation(void) {
+  message_pages_flush();
+
+  // Save the newest messages that fit in the store
+  size_t budget = conversation_store_capacity();
+  int first = s_message_count;
+  while (first > 0) {
+    size_t size = conversation_store_encoded_size(strlen(s_messages[first - 1].text));
+    if (size > budget) {
+      break;
+    }
+    budget -= size;
+    first--;
+  }
+
+  conversation_store_save_begin(s_thread_id);
+  for (int i = first; i < s_message_count; i++) {
+    const Message *message = &s_messages[i];
+    conversation_store_save_message(message->text, message->is_user, message->first_page, message->page_count);
+  }
+  conversation_store_save_end();
+}
+
+static void clear_conversation(void) {
+  if (s_restore_timer) {
+    app_timer_cancel(s_restore_timer);
+    s_restore_timer = NULL;
+  }
+  s_restore_index = -1;
+
+  for (int i = 0; i < s_message_count; i++) {
+    text_pool_free(s_messages[i].text);
+  }
+  s_message_count = 0;
+  s_pages_in_use = 0;
+  s_next_page = 0;
+  message_pages_reset();
+
+  // Suggestions only apply to the response they came with
+  reply_window_set_suggestions(NULL);
+}
+
+static void update_thread_index(void) {
+  if (s_thread_id == 0 || s_message_count == 0) {
+    return;
+  }
+
+  // Title the thread with its first user message
+  const char *title = s_messages[0].text;
+  for (int i = 0; i < s_message_count; i++) {
+    if (s_messages[i].is_user) {
+      title = s_messages[i].text;
+      break;
+    }
+  }
+
+  thread_index_update(s_thread_id, title, s_message_count);
+}
+
+static void add_thread_message(const char *text, size_t length, bool is_user) {
+  if (length > 0 && store_message(text, length, is_user)) {
+    measure_message(&s_messages[s_message_count - 1]);
+  }
+}
+
+static void load_thread(const Tuple *thread_data) {
+  // Replace the conversation with a thread sent by the phone
+  clear_conversation();
+  init_text_pool();
+
+  ConversationDecoder decoder;
+  if (thread_data->type == TUPLE_BYTE_ARRAY &&
+      conversation_decoder_init(&decoder, thread_data->value->data, thread_data->length)) {
+    bool is_user;
+    const char *text;
+    size_t length;
+    while (conversation_decoder_next(&decoder, &is_user, &text, &length)) {
+      add_thread_message(text, length, is_user);
+    }
+  } else {
+    APP_LOG(APP_LOG_LEVEL_WARNING, "Unsupported thread data (%d bytes)", (int)thread_data->length);
+  }
+
+  rebuild_scroll_content();
+  scroll_to_bottom(false);
+  save_conversation();
+  update_thread_index();
+
+  APP_LOG(APP_LOG_LEVEL_DEBUG, "Loaded thread %u: %d messages", (unsigned)s_thread_id, s_message_count);
+}
+
+static void end_thread_request(void) {
+  if (s_thread_request_timer) {
+    app_timer_cancel(s_thread_request_timer);
+    s_thread_request_timer = NULL;
+  }
+
+  sniff_governor_end();
+  s_waiting_for_response = request_queue_get_count() > 0;
+  chat_window_set_footer_animating(false);
+}
+
+static void thread_request_timer_callback(void *context) {
+  s_thread_request_timer = NULL;
+  APP_LOG(APP_LOG_LEVEL_WARNING, "No answer to the thread request");
+  end_thread_request();
+}
+
+static void history_select_handler(uint32_t thread_id) {
+  if (thread_id == 0) {
+    // Start a new conversation (the old one stays in the history)
+    clear_conversation();
+    init_text_pool();
+    s_thread_id = 0;
+    rebuild_scroll_content();
+    save_conversation();
+    return;
+  }
+
+  if (thread_id == s_thread_id) {
+    return;
+  }
+
+  // Ask the phone for the thread's transcript
+  DictionaryIterator *iter;
+  if (app_message_outbox_begin(&iter) != APP_MSG_OK) {
+    APP_LOG(APP_LOG_LEVEL_ERROR, "Failed to request thread %u", (unsigned)thread_id);
+    return;
+  }
+
+  // The phone answers with THREAD_DATA (or just RESPONSE_END if it no longer has the thread)
+  dict_write_uint32(iter, MESSAGE_KEY_THREAD_REQUEST, thread_id);
+  dict_write_uint32(iter, MESSAGE_KEY_INBOX_SIZE, APP_MESSAGE_INBOX_SIZE);
+  if (app_message_outbox_send() == APP_MSG_OK) {
+    sniff_governor_begin();
+    s_waiting_for_response = true;
+    chat_window_set_footer_animating(true);
+    if (s_thread_request_timer) {
+      app_timer_cancel(s_thread_request_timer);
+    }
+    s_thread_request_timer = app_timer_register(THREAD_REQUEST_TIMEOUT, thread_request_timer_callback, NULL);
+  }
+}
+
+static void send_user_message(const char *text) {
+  // Network first: the request only needs the message text, so it is on its
+  // way before the new message is measured, laid out and drawn
+  if (!store_message(text, strlen(text), true)) {
+    return;
+  }
+  send_chat_request();
+
+  measure_message(&s_messages[s_message_count - 1]);
+  rebuild_scroll_content();
+  scroll_to_bottom(true);
+}
+
+static bool is_scrolled_to_bottom(void) {
+  GRect content_bounds = layer_get_bounds(s_content_layer);
+  GRect scroll_bounds = layer_get_bounds(scroll_layer_get_layer(s_scroll_layer));
+  int offset = -scroll_layer_get_content_offset(s_scroll_layer).y;
+
+  return offset >= content_bounds.size.h - scroll_bounds.size.h;
+}
+
+// Lays out the response being received. Blocks that are complete keep their
+// cached heights; only the growing block is measured, from its last line on.
+static void measure_stream_message(Message *message) {
+  int growing = message->page_count;
+  if (growing != s_stream_block) {
+    message_bubble_layout_reset(&s_stream_layout);
+  }
+
+  // Blocks completed since the last frame are measured once more in full
+  for (int block = s_stream_block; block < growing; block++) {
+    if (block == 0) {
+      message->text_height = message_bubble_measure_text_height(message->text, s_content_width);
+    } else {
+      int page = (message->first_page + block - 1) % MESSAGE_PAGE_COUNT;
+      s_page_heights[page] = message_bubble_measure_text_height(message_pages_get(page), s_content_width);
+    }
+  }
+  s_stream_block = growing;
+
+  if (growing == 0) {
+    message->text_height = message_bubble_layout_measure(&s_stream_layout, message->text, s_content_width);
+  } else {
+    // The layout needs writable text, so the page is measured from a copy
+    int page = (message->first_page + growing - 1) % MESSAGE_PAGE_COUNT;
+    char buffer[MESSAGE_PAGE_SIZE];
+    strncpy(buffer, message_pages_get(page), sizeof(buffer) - 1);
+    buffer[sizeof(buffer) - 1] = '\0';
+    s_page_heights[page] = message_bubble_layout_measure(&s_stream_layout, buffer, s_content_width);
+  }
+
+  message->height = message->text_height + MESSAGE_BUBBLE_PADDING_HEIGHT;
+  for (int p = 0; p < message->page_count; p++) {
+    message->height += s_page_heights[(message->first_page + p) % MESSAGE_PAGE_COUNT];
+  }
+
+  if (message->queued) {
+    message->height += MESSAGE_BUBBLE_STATUS_HEIGHT;
+  }
+}
+
+static void render_frame(void) {
+  s_frame_pending = false;
+  if (s_message_count == 0) {
+    return;
+  }
+
+  // Follow the response only if the user has not scrolled away from it
+  bool follow = is_scrolled_to_bottom();
+
+  Message *last = &s_messages[s_message_count - 1];
+  if (s_response_open && !last->is_user) {
+    measure_stream_message(last);
+  } else {
+    measure_message(last);
+  }
   rebuild_scroll_content();
+  if (follow) {
+    scroll_to_bottom(false);
+  }
+  s_stream_frames++;
+}
+
+static void frame_timer_callback(void *context) {
+  s_frame_timer = NULL;
+
+  // Chunks arrived since the last frame: render them, then wait another interval
+  if (s_frame_pending) {
+    render_frame();
+    s_frame_timer = app_timer_register(FRAME_INTERVAL, frame_timer_callback, NULL);
+  }
+}
+
+static void request_frame(void) {
+  s_frame_pending = true;
+  if (s_frame_timer) {
+    // Coalesced into the next frame
+    return;
+  }
+
+  render_frame();
+  s_frame_timer = app_timer_register(FRAME_INTERVAL, frame_timer_callback, NULL);
+}
+
+static void flush_frame(void) {
+  if (s_frame_timer) {
+    app_timer_cancel(s_frame_timer);
+    s_frame_timer = NULL;
+  }
+  if (s_frame_pending) {
+    render_frame();
+  }
 }
 
-static void scroll_to_bottom(void) {
+static void add_assistant_text(const char *text) {
+  uint32_t start_ms = now_ms();
+  size_t length = strlen(text);
+
+  if (s_response_open && s_message_count > 0 && !s_messages[s_message_count - 1].is_user) {
+    // Another chunk of the response being received
+    append_message_text(text, length);
+  } else {
+    // First chunk: start a new assistant message
+    if (!store_message(text, length, false)) {
+      return;
+    }
+    s_response_open = true;
+    message_bubble_layout_reset(&s_stream_layout);
+    s_stream_block = 0;
+    s_stream_start_ms = start_ms;
+    s_stream_handling_ms = 0;
+    s_stream_chars = 0;
+    s_stream_chunks = 0;
+    s_stream_frames = 0;
+  }
+
+  // Lay out and redraw with the next frame
+  request_frame();
+
+  s_stream_chars += length;
+  s_stream_chunks++;
+  s_stream_handling_ms += now_ms() - start_ms;
+}
+
+// Drops the response being received when its request is lost with the link:
+// the request is sent again and the phone answers it in full
+static void discard_open_response(void) {
+  if (s_frame_timer) {
+    app_timer_cancel(s_frame_timer);
+    s_frame_timer = NULL;
+  }
+  s_frame_pending = false;
+  if (!s_response_open) {
+    return;
+  }
+  s_response_open = false;
+  s_stream_chunks = 0;
+
+  if (s_message_count > 0 && !s_messages[s_message_count - 1].is_user) {
+    // The last message's pages end at the head of the ring
+    Message *message = &s_messages[s_message_count - 1];
+    APP_LOG(APP_LOG_LEVEL_DEBUG, "Dropping a partial response of %d pages", message->page_count);
+    text_pool_free(message->text);
+    s_pages_in_use -= message->page_count;
+    s_next_page = message->first_page;
+    s_message_count--;
+    rebuild_scroll_content();
+  }
+}
+
+static void log_stream_stats(void) {
+  if (s_stream_chunks == 0) {
+    return;
+  }
+
+  uint32_t elapsed_ms = now_ms() - s_stream_start_ms;
+  APP_LOG(APP_LOG_LEVEL_DEBUG, "Streamed %d bytes in %d chunks, %d frames over %d ms (%d bytes/s, %d ms per chunk)",
+          s_stream_chars, s_stream_chunks, s_stream_frames, (int)elapsed_ms,
+          elapsed_ms > 0 ? (int)(s_stream_chars * 1000 / elapsed_ms) : s_stream_chars,
+          (int)(s_stream_handling_ms / s_stream_chunks));
+  s_stream_chunks = 0;
+}
+
+static void scroll_to_bottom(bool animated) {
   GRect content_bounds = layer_get_bounds(s_content_layer);
   GRect scroll_bounds = layer_get_bounds(scroll_layer_get_layer(s_scroll_layer));
 
@@ -217,26 +991,117 @@ static void scroll_to_bottom(void) {
     max_offset = 0;
   }
 
-  scroll_layer_set_content_offset(s_scroll_layer, GPoint(0, -max_offset), true);
+  scroll_layer_set_content_offset(s_scroll_layer, GPoint(0, -max_offset), animated);
+}
+
+static void set_queued_indicator(bool queued) {
+  // Show or hide "Queued" on the latest user message
+  for (int i = s_message_count - 1; i >= 0; i--) {
+    Message *message = &s_messages[i];
+    if (!message->is_user) {
+      continue;
+    }
+
+    if (message->queued != queued) {
+      message->queued = queued;
+      if (message->height > 0) {
+        message->height += queued ? MESSAGE_BUBBLE_STATUS_HEIGHT : -MESSAGE_BUBBLE_STATUS_HEIGHT;
+      }
+      rebuild_scroll_content();
+    }
+    return;
+  }
+}
+
+static void request_retry_timer_callback(void *context) {
+  s_request_retry_timer = NULL;
+  flush_request_queue();
 }
 
 static void send_chat_request(void) {
-  // Encode all messages into format: "[U]msg1[A]msg2[U]msg3..."
-  static char encoded_buffer[MESSAGE_BUFFER_SIZE];
-  encoded_buffer[0] = '\0';
+  // New conversations get their thread ID with the first request
+  if (s_thread_id == 0) {
+    s_thread_id = time(NULL);
+  }
 
-  for (int i = 0; i < s_message_count; i++) {
-    const char *prefix = s_messages[i].is_user ? "[U]" : "[A]";
-    size_t current_len = strlen(encoded_buffer);
-    size_t available = MESSAGE_BUFFER_SIZE - current_len - 1;
+  // Request IDs are unique across launches so the phone can skip duplicates
+  uint32_t request_id = time(NULL);
+  if (request_id <= s_last_request_id) {
+    request_id = s_last_request_id + 1;
+  }
+  s_last_request_id = request_id;
 
-    // Add prefix
-    strncat(encoded_buffer, prefix, available);
-    current_len = strlen(encoded_buffer);
-    available = MESSAGE_BUFFER_SIZE - current_len - 1;
+  // Suggestions for the previous response no longer apply
+  reply_window_set_suggestions(NULL);
 
-    // Add message text
-    strncat(encoded_buffer, s_messages[i].text, available);
+  // Queue first so the turn survives a disconnect or the app closing
+  request_queue_push(request_id, s_thread_id);
+  s_waiting_for_response = true;
+  flush_request_queue();
+}
+
+static void flush_request_queue(void) {
+  if (s_request_in_flight) {
+    return;
+  }
+
+  // Requests from another conversation can no longer be answered in this one
+  const RequestQueueEntry *entry = request_queue_peek();
+  while (entry && entry->thread_id != s_thread_id) {
+    APP_LOG(APP_LOG_LEVEL_WARNING, "Dropping request %u from thread %u", (unsigned)entry->request_id, (unsigned)entry->thread_id);
+    request_queue_pop();
+    entry = request_queue_peek();
+  }
+  if (!entry) {
+    return;
+  }
+
+  if (!connection_service_peek_pebble_app_connection()) {
+    APP_LOG(APP_LOG_LEVEL_DEBUG, "Phone disconnected, request %u queued", (unsigned)entry->request_id);
+    set_queued_indicator(true);
+    return;
+  }
+
+  // The request ends with the user's turn (a partial response that came
+  // before a disconnect is not part of it)
+  int end = s_message_count;
+  while (end > 0 && !s_messages[end - 1].is_user) {
+    end--;
+  }
+
+  // Encode the newest messages that fit (overflow pages are counted at their full size)
+  int first = end;
+  size_t encoded_size = conversation_codec_header_size(entry->request_id);
+  while (first > 0) {
+    const Message *message = &s_messages[first - 1];
+    size_t size = CONVERSATION_CODEC_MESSAGE_OVERHEAD + strlen(message->text) + message->page_count * (MESSAGE_PAGE_SIZE - 1);
+    if (first < end && encoded_size + size > MESSAGE_BUFFER_SIZE) {
+      break;
+    }
+    encoded_size += size;
+    first--;
+  }
+
+  // One spare byte for the NUL message_pages_copy writes after the text
+  static uint8_t encoded_buffer[MESSAGE_BUFFER_SIZE + 1];
+  ConversationEncoder encoder;
+  conversation_encoder_init(&encoder, encoded_buffer, MESSAGE_BUFFER_SIZE, entry->request_id);
+
+  for (int i = first; i < end; i++) {
+    char *text = conversation_encoder_begin_message(&encoder);
+    size_t available = conversation_encoder_get_available(&encoder);
+
+    // A message cut to fit ends on a whole character
+    size_t length = message_pages_split_length(s_messages[i].text, strlen(s_messages[i].text), available);
+    memcpy(text, s_messages[i].text, length);
+
+    // Add overflow pages (copied straight from storage so resident pages stay put)
+    for (int p = 0; p < s_messages[i].page_count; p++) {
+      int page = (s_messages[i].first_page + p) % MESSAGE_PAGE_COUNT;
+      length += message_pages_copy(page, text + length, available - length + 1);
+    }
+
+    conversation_encoder_end_message(&encoder, s_messages[i].is_user, length);
   }
 
   // Send via AppMessage
@@ -244,29 +1109,65 @@ static void send_chat_request(void) {
   AppMessageResult result = app_message_outbox_begin(&iter);
 
   if (result == APP_MSG_OK) {
-    dict_write_cstring(iter, MESSAGE_KEY_REQUEST_CHAT, encoded_buffer);
+    dict_write_data(iter, MESSAGE_KEY_REQUEST_CHAT, encoded_buffer, encoder.length);
+    dict_write_uint32(iter, MESSAGE_KEY_THREAD_ID, entry->thread_id);
+    dict_write_uint32(iter, MESSAGE_KEY_INBOX_SIZE, APP_MESSAGE_INBOX_SIZE);
     result = app_message_outbox_send();
 
     if (result == APP_MSG_OK) {
-      APP_LOG(APP_LOG_LEVEL_DEBUG, "Sent REQUEST_CHAT: %d bytes", (int)strlen(encoded_buffer));
-      s_waiting_for_response = true;
+      APP_LOG(APP_LOG_LEVEL_DEBUG, "Sent REQUEST_CHAT: %d bytes", (int)encoder.length);
+      if (s_dictation_end_ms) {
+        uint32_t latency_ms = now_ms() - s_dictation_end_ms;
+        s_send_latency_total_ms += latency_ms;
+        s_send_latency_count++;
+        s_dictation_end_ms = 0;
+        APP_LOG(APP_LOG_LEVEL_DEBUG, "Request sent %d ms after dictation (average %d ms over %d turns)",
+                (int)latency_ms, (int)(s_send_latency_total_ms / s_send_latency_count), s_send_latency_count);
+      }
+      s_request_in_flight = true;
+      sniff_governor_begin();
+      set_queued_indicator(false);
       chat_window_set_footer_animating(true);
-    } else {
-      APP_LOG(APP_LOG_LEVEL_ERROR, "Failed to send REQUEST_CHAT: %d", (int)result);
+      return;
     }
+    APP_LOG(APP_LOG_LEVEL_ERROR, "Failed to send REQUEST_CHAT: %d", (int)result);
   } else {
     APP_LOG(APP_LOG_LEVEL_ERROR, "Failed to begin outbox: %d", (int)result);
   }
+
+  // Keep the request queued and try again shortly
+  set_queued_indicator(true);
+  if (!s_request_retry_timer) {
+    s_request_retry_timer = app_timer_register(REQUEST_RETRY_INTERVAL, request_retry_timer_callback, NULL);
+  }
+}
+
+static void connection_handler(bool connected) {
+  if (connected) {
+    APP_LOG(APP_LOG_LEVEL_DEBUG, "Phone reconnected, flushing %d queued requests", request_queue_get_count());
+    flush_request_queue();
+    return;
+  }
+
+  // A request that was sent but not answered is lost with the link: keep it
+  // queued so it is sent again on reconnect
+  if (s_request_in_flight) {
+    APP_LOG(APP_LOG_LEVEL_DEBUG, "Phone disconnected, request in flight queued again");
+    s_request_in_flight = false;
+    discard_open_response();
+    sniff_governor_end();
+    chat_window_set_footer_animating(false);
+    chat_footer_set_status(s_footer, NULL);
+    set_queued_indicator(true);
+  }
 }
 
+
 static void dictation_session_callback(DictationSession *session, DictationSessionStatus status, char *transcription, void *context) {
   if (status == DictationSessionStatusSuccess && transcription) {
-    // Add the transcription as a user message
-    add_user_message(transcription);
-    scroll_to_bottom();
-
-    // Send chat request to JS
-    send_chat_request();
+    // Send the transcription to JS as a user message
+    s_dictation_end_ms = now_ms();
+    send_user_message(transcription);
   } else {
     // Dictation was canceled or failed
     // If there are no messages, return to welcome screen
@@ -274,24 +1175,120 @@ static void dictation_session_callback(DictationSession *session, DictationSessi
       window_stack_pop(true);
     }
   }
+}
+
+static int scroll_step(ClickRecognizerRef recognizer) {
+  // Held buttons scroll faster the longer they are held
+  if (!click_recognizer_is_repeating(recognizer)) {
+    s_scroll_repeat_count = 0;
+    return SCROLL_OFFSET;
+  }
 
-  // Clean up the dictation session
-  dictation_session_destroy(s_dictation_session);
-  s_dictation_session = NULL;
+  s_scroll_repeat_count++;
+  int multiplier = 1 + s_scroll_repeat_count / SCROLL_ACCELERATION_REPEATS;
+  if (multiplier > SCROLL_MAX_MULTIPLIER) {
+    multiplier = SCROLL_MAX_MULTIPLIER;
+  }
+  return SCROLL_OFFSET * multiplier;
 }
 
 static void up_click_handler(ClickRecognizerRef recognizer, void *context) {
-  // Scroll up
+  // Scroll up (without animation while repeating, so steps don't queue up redraws)
   GPoint offset = scroll_layer_get_content_offset(s_scroll_layer);
-  offset.y += SCROLL_OFFSET;
-  scroll_layer_set_content_offset(s_scroll_layer, offset, true);
+  offset.y += scroll_step(recognizer);
+  scroll_layer_set_content_offset(s_scroll_layer, offset, !click_recognizer_is_repeating(recognizer));
+
+  // Prefetch the page above the new viewport
+  prefetch_page_at(-offset.y - 1);
 }
 
 static void down_click_handler(ClickRecognizerRef recognizer, void *context) {
-  // Scroll down
+  // Scroll down (without animation while repeating, so steps don't queue up redraws)
   GPoint offset = scroll_layer_get_content_offset(s_scroll_layer);
-  offset.y -= SCROLL_OFFSET;
-  scroll_layer_set_content_offset(s_scroll_layer, offset, true);
+  offset.y -= scroll_step(recognizer);
+  scroll_layer_set_content_offset(s_scroll_layer, offset, !click_recognizer_is_repeating(recognizer));
+
+  // Prefetch the page below the new viewport
+  GRect scroll_frame = layer_get_frame(scroll_layer_get_layer(s_scroll_layer));
+  prefetch_page_at(-offset.y + scroll_frame.size.h);
+}
+
+static void up_multi_click_handler(ClickRecognizerRef recognizer, void *context) {
+  // Snap to the start of the message at the top of the screen, or the previous one
+  int visible_top = -scroll_layer_get_content_offset(s_scroll_layer).y;
+  int index = find_message_at(visible_top - 1);
+  if (index < 0) {
+    return;
+  }
+
+  scroll_layer_set_content_offset(s_scroll_layer, GPoint(0, -s_messages[index].y), true);
+}
+
+static void down_multi_click_handler(ClickRecognizerRef recognizer, void *context) {
+  // Snap to the start of the next message, or to the bottom after the last one
+  int visible_top = -scroll_layer_get_content_offset(s_scroll_layer).y;
+  int index = find_message_at(visible_top) + 1;
+  if (index <= 0 || index >= s_message_count) {
+    scroll_to_bottom(true);
+    return;
+  }
+
+  scroll_layer_set_content_offset(s_scroll_layer, GPoint(0, -s_messages[index].y), true);
+}
+
+static void reply_select_handler(const char *suggestion);
+
+static void show_reply_window(void) {
+  if (!s_reply_window) {
+    s_reply_window = reply_window_create(reply_select_handler);
+  }
+  window_stack_push(s_reply_window, true);
+}
+
+static bool dictation_confirmation_enabled(void) {
+  return !persist_exists(PERSIST_KEY_DICTATION_CONFIRM) || persist_read_bool(PERSIST_KEY_DICTATION_CONFIRM);
+}
+
+static void prewarm_connection(void) {
+  // Let the phone open its connection to the API while the user is still speaking
+  if (s_request_in_flight || !connection_service_peek_pebble_app_connection()) {
+    return;
+  }
+
+  DictionaryIterator *iter;
+  if (app_message_outbox_begin(&iter) != APP_MSG_OK) {
+    return;
+  }
+  dict_write_uint8(iter, MESSAGE_KEY_PREWARM, 1);
+  app_message_outbox_send();
+}
+
+static void start_dictation(void) {
+  // One session is kept for the lifetime of the window
+  if (!s_dictation_session) {
+    s_dictation_session = dictation_session_create(sizeof(char) * 256, dictation_session_callback, NULL);
+    if (!s_dictation_session) {
+#if !defined(PBL_MICROPHONE)
+      // No voice input on this watch: pick a prompt instead
+      show_reply_window();
+#endif
+      return;
+    }
+    dictation_session_enable_confirmation(s_dictation_session, dictation_confirmation_enabled());
+  }
+
+  prewarm_connection();
+  dictation_session_start(s_dictation_session);
+}
+
+static void reply_select_handler(const char *suggestion) {
+  if (!suggestion) {
+    start_dictation();
+    return;
+  }
+
+  // Send the suggestion as if it had been dictated
+  send_user_message(suggestion);
 }
 
 static void select_click_handler(ClickRecognizerRef recognizer, void *context) {
@@ -300,12 +1297,26 @@ static void select_click_handler(ClickRecognizerRef recognizer, void *context) {
     return;
   }
 
+  // Offer the suggested follow-ups when the last response came with some
+  if (reply_window_get_suggestion_count() > 0) {
+    show_reply_window();
+    return;
+  }
+
   // Start dictation session
-  s_dictation_session = dictation_session_create(sizeof(char) * 256, dictation_session_callback, NULL);
+  start_dictation();
+}
 
-  if (s_dictation_session) {
-    dictation_session_start(s_dictation_session);
+static void select_long_click_handler(ClickRecognizerRef recognizer, void *context) {
+  // Don't switch conversations while waiting for a response
+  if (s_waiting_for_response) {
+    return;
+  }
+
+  if (!s_history_window) {
+    s_history_window = history_window_create(history_select_handler);
   }
+  window_stack_push(s_history_window, true);
 }
 
 // TODO: Switch to the official action button API once it appears in the SDK
@@ -333,9 +1344,12 @@ static void action_button_update_proc(Layer *layer, GContext *ctx) {
 }
 
 static void click_config_provider(void *context) {
-  window_single_repeating_click_subscribe(BUTTON_ID_UP, 100, up_click_handler);
-  window_single_repeating_click_subscribe(BUTTON_ID_DOWN, 100, down_click_handler);
+  window_single_repeating_click_subscribe(BUTTON_ID_UP, SCROLL_REPEAT_INTERVAL, up_click_handler);
+  window_single_repeating_click_subscribe(BUTTON_ID_DOWN, SCROLL_REPEAT_INTERVAL, down_click_handler);
+  window_multi_click_subscribe(BUTTON_ID_UP, 2, 2, MULTI_CLICK_TIMEOUT, true, up_multi_click_handler);
+  window_multi_click_subscribe(BUTTON_ID_DOWN, 2, 2, MULTI_CLICK_TIMEOUT, true, down_multi_click_handler);
   window_single_click_subscribe(BUTTON_ID_SELECT, select_click_handler);
+  window_long_click_subscribe(BUTTON_ID_SELECT, HISTORY_LONG_CLICK_DELAY, select_long_click_handler, NULL);
 }
 
 static void window_unload(Window *window) {
@@ -345,17 +1359,31 @@ static void window_unload(Window *window) {
     s_dictation_session = NULL;
   }
 
-  // Destroy all bubbles
-  for (int i = 0; i < s_bubble_count; i++) {
-    if (s_bubbles[i]) {
-      message_bubble_destroy(s_bubbles[i]);
-      s_bubbles[i] = NULL;
-    }
+  // Queued requests are sent again on the next load
+  sniff_governor_end();
+  connection_service_unsubscribe();
+  if (s_request_retry_timer) {
+    app_timer_cancel(s_request_retry_timer);
+    s_request_retry_timer = NULL;
+  }
+  if (s_thread_request_timer) {
+    app_timer_cancel(s_thread_request_timer);
+    s_thread_request_timer = NULL;
   }
-  s_bubble_count = 0;
+  s_request_in_flight = false;
+  s_waiting_for_response = false;
+  s_response_open = false;
+  if (s_frame_timer) {
+    app_timer_cancel(s_frame_timer);
+    s_frame_timer = NULL;
+  }
+  s_frame_pending = false;
 
-  // Reset message history
-  s_message_count = 0;
+  // Save the conversation for the next launch, then reset message history
+  // (restored from storage on the next load)
+  save_conversation();
+  clear_conversation();
+  text_pool_deinit();
 
   // Destroy footer
   if (s_footer) {
@@ -385,21 +1413,89 @@ void chat_window_handle_inbox(DictionaryIterator *iterator) {
   // Handle incoming messages from JS
   Tuple *response_text_tuple = dict_find(iterator, MESSAGE_KEY_RESPONSE_TEXT);
   Tuple *response_end_tuple = dict_find(iterator, MESSAGE_KEY_RESPONSE_END);
+  Tuple *thread_data_tuple = dict_find(iterator, MESSAGE_KEY_THREAD_DATA);
+  Tuple *thread_id_tuple = dict_find(iterator, MESSAGE_KEY_THREAD_ID);
+  Tuple *suggestions_tuple = dict_find(iterator, MESSAGE_KEY_SUGGESTIONS);
+  Tuple *status_text_tuple = dict_find(iterator, MESSAGE_KEY_STATUS_TEXT);
+
+  if (status_text_tuple || response_text_tuple) {
+    // The transfer is still going
+    sniff_governor_touch();
+  }
+
+  if (status_text_tuple) {
+    // Progress of the request (e.g. a web search), shown until the response arrives
+    chat_footer_set_status(s_footer, status_text_tuple->value->cstring);
+  }
+
+  if (thread_data_tuple && thread_id_tuple) {
+    // Received a thread from the history
+    s_thread_id = thread_id_tuple->value->uint32;
+    load_thread(thread_data_tuple);
+  }
 
   if (response_text_tuple) {
-    // Received complete response text
+    // Received response text (the whole response, or one chunk of it)
     const char *text = response_text_tuple->value->cstring;
     APP_LOG(APP_LOG_LEVEL_DEBUG, "Received RESPONSE_TEXT: %s", text);
 
-    // Add as new assistant message
-    add_assistant_message(text);
+    chat_footer_set_status(s_footer, NULL);
+    add_assistant_text(text);
+  }
+
+  if (suggestions_tuple) {
+    // Follow-ups for the response, offered on the next Select press
+    reply_window_set_suggestions(suggestions_tuple->value->cstring);
   }
 
   if (response_end_tuple) {
-    // Response complete - unlock UI
+    // Response complete - the request is done, unlock UI unless more are queued
     APP_LOG(APP_LOG_LEVEL_DEBUG, "Received RESPONSE_END");
-    s_waiting_for_response = false;
+    sniff_governor_end();
+    flush_frame();
+    log_stream_stats();
+    s_response_open = false;
+    chat_footer_set_status(s_footer, NULL);
+    if (s_request_in_flight) {
+      s_request_in_flight = false;
+      request_queue_pop();
+    }
+    if (s_thread_request_timer) {
+      app_timer_cancel(s_thread_request_timer);
+      s_thread_request_timer = NULL;
+    }
+    s_waiting_for_response = request_queue_get_count() > 0;
     chat_window_set_footer_animating(false);
+
+    // Turn complete - save what changed
+    save_conversation();
+    update_thread_index();
+
+    flush_request_queue();
+  }
+}
+
+void chat_window_handle_outbox_failed(DictionaryIterator *iterator) {
+  if (dict_find(iterator, MESSAGE_KEY_THREAD_REQUEST)) {
+    // The thread can be picked again from the history
+    APP_LOG(APP_LOG_LEVEL_ERROR, "Failed to send the thread request");
+    end_thread_request();
+    return;
+  }
+
+  if (!dict_find(iterator, MESSAGE_KEY_REQUEST_CHAT)) {
+    return;
+  }
+
+  // The request never reached the phone: keep it queued until the connection is back
+  s_request_in_flight = false;
+  discard_open_response();
+  sniff_governor_end();
+  chat_window_set_footer_animating(false);
+  set_queued_indicator(true);
+
+  if (connection_service_peek_pebble_app_connection() && !s_request_retry_timer) {
+    s_request_retry_timer = app_timer_register(REQUEST_RETRY_INTERVAL, request_retry_timer_callback, NULL);
   }
 }
 
@@ -415,11 +1511,29 @@ Window* chat_window_create(void) {
 }
 
 void chat_window_destroy(Window *window) {
+  if (s_history_window) {
+    history_window_destroy(s_history_window);
+    s_history_window = NULL;
+  }
+
+  if (s_reply_window) {
+    reply_window_destroy(s_reply_window);
+    s_reply_window = NULL;
+  }
+
   if (window) {
     window_destroy(window);
   }
 }
 
+void chat_window_set_dictation_confirmation(bool enabled) {
+  persist_write_bool(PERSIST_KEY_DICTATION_CONFIRM, enabled);
+
+  if (s_dictation_session) {
+    dictation_session_enable_confirmation(s_dictation_session, enabled);
+  }
+}
+
 void chat_window_set_footer_animating(bool animating) {
   if (!s_footer) {
     return;
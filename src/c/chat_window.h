@@ -26,8 +26,20 @@ void chat_window_destroy(Window *window);
  */
 void chat_window_set_footer_animating(bool animating);
 
+/**
+ * Turn the confirmation screen after dictation on or off (saved across launches).
+ * @param enabled true to let the user review the transcription before it is sent
+ */
+void chat_window_set_dictation_confirmation(bool enabled);
+
 /**
  * Handle incoming AppMessage from JavaScript.
  * @param iterator Dictionary iterator with message data
  */
 void chat_window_handle_inbox(DictionaryIterator *iterator);
+
+/**
+ * Handle an AppMessage that failed to reach JavaScript.
+ * @param iterator Dictionary iterator with the failed message
+ */
+void chat_window_handle_outbox_failed(DictionaryIterator *iterator);
@@ -1,5 +1,6 @@
 #include <pebble.h>
 #include "claude_spark.h"
+#include "memory_profile.h"
 #include "chat_window.h"
 #include "setup_window.h"
 #include "welcome_window.h"
@@ -10,6 +11,12 @@ static Window *s_welcome_window;
 static bool s_is_ready = true;  // Assume ready initially, will be corrected by JS
 
 static void inbox_received_callback(DictionaryIterator *iterator, void *context) {
+  // Settings arrive together with READY_STATUS
+  Tuple *dictation_confirm_tuple = dict_find(iterator, MESSAGE_KEY_DICTATION_CONFIRM);
+  if (dictation_confirm_tuple) {
+    chat_window_set_dictation_confirmation(dictation_confirm_tuple->value->int32 != 0);
+  }
+
   // Check for READY_STATUS message
   Tuple *ready_status_tuple = dict_find(iterator, MESSAGE_KEY_READY_STATUS);
   if (ready_status_tuple) {
@@ -58,6 +65,9 @@ static void inbox_dropped_callback(AppMessageResult reason, void *context) {
 
 static void outbox_failed_callback(DictionaryIterator *iterator, AppMessageResult reason, void *context) {
   APP_LOG(APP_LOG_LEVEL_ERROR, "Outbox send failed: %d", (int)reason);
+
+  // Let the chat window requeue a failed request
+  chat_window_handle_outbox_failed(iterator);
 }
 
 static void outbox_sent_callback(DictionaryIterator *iterator, void *context) {
@@ -85,8 +95,11 @@ static void prv_init(void) {
   app_message_register_outbox_failed(outbox_failed_callback);
   app_message_register_outbox_sent(outbox_sent_callback);
 
-  // Open AppMessage with large inbox (for history) and large outbox (for chunks)
-  app_message_open(4096, 4096);
+  // Open AppMessage with buffers sized by the memory profile (the phone
+  // splits responses to fit the inbox)
+  app_message_open(APP_MESSAGE_INBOX_SIZE, APP_MESSAGE_OUTBOX_SIZE);
+  APP_LOG(APP_LOG_LEVEL_DEBUG, "Heap after AppMessage: %d used, %d free",
+          (int)heap_bytes_used(), (int)heap_bytes_free());
 
   // Check launch reason to determine which window to show
   if (launch_reason() == APP_LAUNCH_QUICK_LAUNCH) {
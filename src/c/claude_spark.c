@@ -1,8 +1,15 @@
 #include "claude_spark.h"
+#include "memory_profile.h"
 
+#ifdef LOW_MEMORY_PROFILE
+// The low-memory profile has no PDC sequences: a single static spark is
+// drawn with line primitives and the animation only tracks its state
+#define STATIC_SPARK_RAYS 12
+#else
 // Global state - PDC sequences loaded once
 static GDrawCommandSequence *s_small_sequence = NULL;
 static GDrawCommandSequence *s_large_sequence = NULL;
+#endif
 
 // Individual spark layer instance
 struct ClaudeSparkLayer {
@@ -15,10 +22,13 @@ struct ClaudeSparkLayer {
 
 // Forward declarations
 static void update_proc(Layer *layer, GContext *ctx);
+#ifndef LOW_MEMORY_PROFILE
 static void next_frame_handler(void *context);
 static GDrawCommandSequence* get_sequence_for_size(ClaudeSparkSize size);
+#endif
 
 void claude_spark_init(void) {
+#ifndef LOW_MEMORY_PROFILE
   // Load both PDC sequences
   s_small_sequence = gdraw_command_sequence_create_with_resource(RESOURCE_ID_CLAUDE_S);
   s_large_sequence = gdraw_command_sequence_create_with_resource(RESOURCE_ID_CLAUDE_L);
@@ -49,9 +59,11 @@ void claude_spark_init(void) {
 #endif
 
   APP_LOG(APP_LOG_LEVEL_INFO, "Claude spark sequences loaded successfully");
+#endif
 }
 
 void claude_spark_deinit(void) {
+#ifndef LOW_MEMORY_PROFILE
   if (s_small_sequence) {
     gdraw_command_sequence_destroy(s_small_sequence);
     s_small_sequence = NULL;
@@ -60,6 +72,7 @@ void claude_spark_deinit(void) {
     gdraw_command_sequence_destroy(s_large_sequence);
     s_large_sequence = NULL;
   }
+#endif
 }
 
 ClaudeSparkLayer* claude_spark_layer_create(GRect frame, ClaudeSparkSize size) {
@@ -108,6 +121,7 @@ void claude_spark_start_animation(ClaudeSparkLayer *spark) {
   spark->is_animating = true;
   spark->frame_index = 0;
 
+#ifndef LOW_MEMORY_PROFILE
   // Schedule first frame
   GDrawCommandSequence *seq = get_sequence_for_size(spark->size);
   GDrawCommandFrame *frame = gdraw_command_sequence_get_frame_by_index(seq, 0);
@@ -115,6 +129,7 @@ void claude_spark_start_animation(ClaudeSparkLayer *spark) {
 
   layer_mark_dirty(spark->layer);
   spark->timer = app_timer_register(duration, next_frame_handler, spark);
+#endif
 }
 
 void claude_spark_stop_animation(ClaudeSparkLayer *spark) {
@@ -137,11 +152,13 @@ void claude_spark_set_frame(ClaudeSparkLayer *spark, int frame_index) {
 
   claude_spark_stop_animation(spark);
 
+#ifndef LOW_MEMORY_PROFILE
   GDrawCommandSequence *seq = get_sequence_for_size(spark->size);
   int num_frames = gdraw_command_sequence_get_num_frames(seq);
 
   spark->frame_index = frame_index % num_frames;
   layer_mark_dirty(spark->layer);
+#endif
 }
 
 void claude_spark_set_size(ClaudeSparkLayer *spark, ClaudeSparkSize size) {
@@ -166,6 +183,30 @@ bool claude_spark_is_animating(ClaudeSparkLayer *spark) {
 
 // Private helper functions
 
+#ifdef LOW_MEMORY_PROFILE
+
+static void update_proc(Layer *layer, GContext *ctx) {
+  GRect bounds = layer_get_bounds(layer);
+  GPoint center = grect_center_point(&bounds);
+  int radius = (bounds.size.w < bounds.size.h ? bounds.size.w : bounds.size.h) / 2 - 1;
+
+  // Rays of alternating length, three lines wide
+  graphics_context_set_stroke_color(ctx, GColorBlack);
+  for (int i = 0; i < STATIC_SPARK_RAYS; i++) {
+    int32_t angle = TRIG_MAX_ANGLE * i / STATIC_SPARK_RAYS;
+    int length = (i % 2) ? radius * 2 / 3 : radius;
+    GPoint end = GPoint(center.x + sin_lookup(angle) * length / TRIG_MAX_RATIO,
+                        center.y - cos_lookup(angle) * length / TRIG_MAX_RATIO);
+
+    for (int offset = -1; offset <= 1; offset++) {
+      graphics_draw_line(ctx, GPoint(center.x + offset, center.y), GPoint(end.x + offset, end.y));
+      graphics_draw_line(ctx, GPoint(center.x, center.y + offset), GPoint(end.x, end.y + offset));
+    }
+  }
+}
+
+#else
+
 static GDrawCommandSequence* get_sequence_for_size(ClaudeSparkSize size) {
   return (size == CLAUDE_SPARK_SMALL) ? s_small_sequence : s_large_sequence;
 }
@@ -215,3 +256,5 @@ static void next_frame_handler(void *context) {
   uint16_t duration = gdraw_command_frame_get_duration(frame);
   spark->timer = app_timer_register(duration, next_frame_handler, spark);
 }
+
+#endif
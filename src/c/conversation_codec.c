@@ -0,0 +1,136 @@
+#include "conversation_codec.h"
+
+#define HEADER_SIZE 2
+#define REQUEST_ID_SIZE 4
+
+// Room reserved for a message's role and length while its text is written
+#define MAX_MESSAGE_LENGTH 0x3FFF
+
+// Private helper functions
+
+static size_t varint_size(size_t value) {
+  size_t size = 1;
+  while (value >= 0x80) {
+    value >>= 7;
+    size++;
+  }
+  return size;
+}
+
+static void write_varint(uint8_t *dest, size_t value) {
+  while (value >= 0x80) {
+    *dest++ = (uint8_t)(value | 0x80);
+    value >>= 7;
+  }
+  *dest = (uint8_t)value;
+}
+
+static bool read_varint(ConversationDecoder *decoder, size_t *value) {
+  *value = 0;
+  for (int shift = 0; shift < 32 && decoder->offset < decoder->length; shift += 7) {
+    uint8_t byte = decoder->data[decoder->offset++];
+    *value |= (size_t)(byte & 0x7F) << shift;
+    if (!(byte & 0x80)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// Public API
+
+size_t conversation_codec_header_size(uint32_t request_id) {
+  return HEADER_SIZE + (request_id ? REQUEST_ID_SIZE : 0);
+}
+
+bool conversation_encoder_init(ConversationEncoder *encoder, uint8_t *buffer, size_t size, uint32_t request_id) {
+  encoder->buffer = buffer;
+  encoder->size = size;
+  encoder->length = conversation_codec_header_size(request_id);
+  encoder->message_start = encoder->length;
+
+  if (size < encoder->length) {
+    encoder->length = 0;
+    return false;
+  }
+
+  buffer[0] = CONVERSATION_CODEC_VERSION;
+  buffer[1] = request_id ? CONVERSATION_CODEC_FLAG_REQUEST_ID : 0;
+  if (request_id) {
+    for (int i = 0; i < REQUEST_ID_SIZE; i++) {
+      buffer[HEADER_SIZE + i] = (uint8_t)(request_id >> (8 * i));
+    }
+  }
+  return true;
+}
+
+char* conversation_encoder_begin_message(ConversationEncoder *encoder) {
+  encoder->message_start = encoder->length;
+  return (char *)encoder->buffer + encoder->length + CONVERSATION_CODEC_MESSAGE_OVERHEAD;
+}
+
+size_t conversation_encoder_get_available(const ConversationEncoder *encoder) {
+  size_t used = encoder->message_start + CONVERSATION_CODEC_MESSAGE_OVERHEAD;
+  if (used >= encoder->size) {
+    return 0;
+  }
+
+  size_t available = encoder->size - used;
+  return available < MAX_MESSAGE_LENGTH ? available : MAX_MESSAGE_LENGTH;
+}
+
+void conversation_encoder_end_message(ConversationEncoder *encoder, bool is_user, size_t length) {
+  uint8_t *message = encoder->buffer + encoder->message_start;
+  size_t prefix_size = 1 + varint_size(length);
+
+  // Short texts need a single length byte: close the gap left for the second
+  if (prefix_size < CONVERSATION_CODEC_MESSAGE_OVERHEAD) {
+    memmove(message + prefix_size, message + CONVERSATION_CODEC_MESSAGE_OVERHEAD, length);
+  }
+
+  message[0] = is_user ? CONVERSATION_CODEC_ROLE_USER : CONVERSATION_CODEC_ROLE_ASSISTANT;
+  write_varint(message + 1, length);
+  encoder->length = encoder->message_start + prefix_size + length;
+}
+
+bool conversation_decoder_init(ConversationDecoder *decoder, const uint8_t *data, size_t length) {
+  decoder->data = data;
+  decoder->length = length;
+  decoder->offset = HEADER_SIZE;
+  decoder->flags = 0;
+  decoder->request_id = 0;
+
+  if (length < HEADER_SIZE || data[0] != CONVERSATION_CODEC_VERSION) {
+    return false;
+  }
+
+  // Unknown flags are ignored, so newer senders can add optional fields last
+  decoder->flags = data[1];
+  if (decoder->flags & CONVERSATION_CODEC_FLAG_REQUEST_ID) {
+    if (length < HEADER_SIZE + REQUEST_ID_SIZE) {
+      return false;
+    }
+    for (int i = 0; i < REQUEST_ID_SIZE; i++) {
+      decoder->request_id |= (uint32_t)data[HEADER_SIZE + i] << (8 * i);
+    }
+    decoder->offset += REQUEST_ID_SIZE;
+  }
+  return true;
+}
+
+bool conversation_decoder_next(ConversationDecoder *decoder, bool *is_user, const char **text, size_t *length) {
+  if (decoder->offset >= decoder->length) {
+    return false;
+  }
+
+  *is_user = decoder->data[decoder->offset++] == CONVERSATION_CODEC_ROLE_USER;
+  if (!read_varint(decoder, length) || *length > decoder->length - decoder->offset) {
+    APP_LOG(APP_LOG_LEVEL_WARNING, "Truncated conversation at byte %d", (int)decoder->offset);
+    decoder->offset = decoder->length;
+    return false;
+  }
+
+  *text = (const char *)decoder->data + decoder->offset;
+  decoder->offset += *length;
+  return true;
+}
@@ -0,0 +1,104 @@
+#pragma once
+#include <pebble.h>
+
+/**
+ * Conversation Codec
+ *
+ * Binary framing of a conversation exchanged with the phone (REQUEST_CHAT
+ * and THREAD_DATA, sent as byte arrays):
+ *
+ *   version (1 byte) | flags (1 byte) | [request ID (4 bytes, little-endian)]
+ *   then per message: role (1 byte) | text length (varint) | UTF-8 text
+ *
+ * The varint is 7 bits per byte, least significant group first, with the
+ * high bit set on all but the last byte. Message text is never scanned for
+ * markers, so it may contain anything.
+ */
+
+#define CONVERSATION_CODEC_VERSION 1
+
+// Header flags
+#define CONVERSATION_CODEC_FLAG_REQUEST_ID 0x01
+
+// Message roles
+#define CONVERSATION_CODEC_ROLE_USER 0
+#define CONVERSATION_CODEC_ROLE_ASSISTANT 1
+
+// Bytes in front of a message's text when its length fits in two varint
+// bytes (all messages an AppMessage can carry)
+#define CONVERSATION_CODEC_MESSAGE_OVERHEAD 3
+
+typedef struct {
+  uint8_t *buffer;
+  size_t size;
+  size_t length;
+  size_t message_start;
+} ConversationEncoder;
+
+typedef struct {
+  const uint8_t *data;
+  size_t length;
+  size_t offset;
+  uint8_t flags;
+  uint32_t request_id;
+} ConversationDecoder;
+
+/**
+ * Get the size of the header written by conversation_encoder_init.
+ * @param request_id Request ID to include, or 0 for none
+ * @return Size of the header in bytes
+ */
+size_t conversation_codec_header_size(uint32_t request_id);
+
+/**
+ * Start encoding a conversation into a buffer.
+ * @param encoder The encoder
+ * @param buffer Destination buffer
+ * @param size Size of the buffer
+ * @param request_id Request ID to include in the header, or 0 for none
+ * @return false if the buffer cannot even hold the header
+ */
+bool conversation_encoder_init(ConversationEncoder *encoder, uint8_t *buffer, size_t size, uint32_t request_id);
+
+/**
+ * Start a message. Its text is written at the returned position (at most
+ * conversation_encoder_get_available bytes), then the message is finished
+ * with conversation_encoder_end_message.
+ * @param encoder The encoder
+ * @return Where to write the message text
+ */
+char* conversation_encoder_begin_message(ConversationEncoder *encoder);
+
+/**
+ * Get how many bytes of text the current message can take.
+ * @param encoder The encoder
+ * @return Free space for text in bytes
+ */
+size_t conversation_encoder_get_available(const ConversationEncoder *encoder);
+
+/**
+ * Finish the current message.
+ * @param encoder The encoder
+ * @param is_user true for a user message, false for Claude
+ * @param length Number of text bytes written
+ */
+void conversation_encoder_end_message(ConversationEncoder *encoder, bool is_user, size_t length);
+
+/**
+ * Start decoding a conversation.
+ * @param decoder The decoder (flags and request_id are filled in)
+ * @param data The encoded conversation
+ * @param length Length of the data in bytes
+ * @return false if the data is not a conversation in a supported version
+ */
+bool conversation_decoder_init(ConversationDecoder *decoder, const uint8_t *data, size_t length);
+
+/**
+ * Decode the next message.
+ * @param decoder The decoder
+ * @param is_user Set to true for a user message, false for Claude
+ * @param text Set to the message text (not NUL-terminated)
+ * @param length Set to the length of the text in bytes
+ * @return false when there are no more messages (or the data is truncated)
+ */
+bool conversation_decoder_next(ConversationDecoder *decoder, bool *is_user, const char **text, size_t *length);
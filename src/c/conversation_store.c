@@ -0,0 +1,305 @@
+#include "conversation_store.h"
+#include "memory_profile.h"
+#include "persist_keys.h"
+
+#define STORE_VERSION 3
+#define RECORD_SIZE PERSIST_DATA_MAX_LENGTH
+#define STORE_CAPACITY (CONVERSATION_STORE_RECORD_COUNT * RECORD_SIZE)
+#define MESSAGE_HEADER_SIZE 5
+#define FLAG_USER 0x01
+
+// Header record describing the ring of encoded messages
+typedef struct {
+  uint8_t version;
+  uint8_t message_count;
+  uint16_t start;   // Ring offset of the oldest message
+  uint16_t length;  // Bytes in use from start
+  uint32_t thread_id;
+} __attribute__((packed)) StoreHeader;
+
+// A message in the ring, as far as saving needs to know it
+typedef struct {
+  uint32_t hash;
+  uint16_t size;
+} StoredMessage;
+
+// Record being written or read (-1 = none)
+static uint8_t s_record[RECORD_SIZE];
+static size_t s_record_fill = 0;
+static int s_record_index = -1;
+static bool s_record_dirty = false;
+
+// Messages in the ring, oldest first, as of the last save or load
+static StoredMessage s_stored[MESSAGE_SLOT_COUNT];
+static int s_stored_count = 0;
+
+// Save state
+static StoreHeader s_header;
+static StoreHeader s_saved_header;
+static int s_matched = 0;
+static bool s_appending = false;
+static uint16_t s_position = 0;
+static int s_records_written = 0;
+
+// Private helper functions
+
+static uint32_t hash_bytes(uint32_t hash, const uint8_t *data, size_t length) {
+  // FNV-1a
+  for (size_t i = 0; i < length; i++) {
+    hash ^= data[i];
+    hash *= 16777619u;
+  }
+  return hash;
+}
+
+static void flush_record(void) {
+  if (s_record_index >= 0 && s_record_dirty) {
+    int result = persist_write_data(PERSIST_KEY_CONVERSATION_BASE + s_record_index, s_record, s_record_fill);
+    if (result < 0) {
+      APP_LOG(APP_LOG_LEVEL_ERROR, "Failed to write conversation record %d: %d", s_record_index, result);
+    }
+    s_records_written++;
+  }
+  s_record_dirty = false;
+}
+
+static void load_record(int index) {
+  flush_record();
+  s_record_index = index;
+  int read = persist_read_data(PERSIST_KEY_CONVERSATION_BASE + index, s_record, RECORD_SIZE);
+  s_record_fill = read > 0 ? read : 0;
+}
+
+// Write at s_position, keeping the rest of each record (it may hold older messages)
+static void write_bytes(const uint8_t *data, size_t length) {
+  while (length > 0) {
+    int index = s_position / RECORD_SIZE;
+    size_t offset = s_position % RECORD_SIZE;
+    if (index != s_record_index) {
+      load_record(index);
+    }
+
+    size_t chunk = RECORD_SIZE - offset;
+    if (chunk > length) {
+      chunk = length;
+    }
+
+    if (offset > s_record_fill) {
+      memset(s_record + s_record_fill, 0, offset - s_record_fill);
+    }
+    memcpy(s_record + offset, data, chunk);
+    if (offset + chunk > s_record_fill) {
+      s_record_fill = offset + chunk;
+    }
+    s_record_dirty = true;
+
+    s_position = (s_position + chunk) % STORE_CAPACITY;
+    data += chunk;
+    length -= chunk;
+  }
+}
+
+static bool read_bytes(uint8_t *data, size_t length) {
+  while (length > 0) {
+    int index = s_position / RECORD_SIZE;
+    size_t offset = s_position % RECORD_SIZE;
+    if (index != s_record_index) {
+      load_record(index);
+    }
+
+    size_t chunk = RECORD_SIZE - offset;
+    if (chunk > length) {
+      chunk = length;
+    }
+    if (offset + chunk > s_record_fill) {
+      return false;
+    }
+
+    memcpy(data, s_record + offset, chunk);
+    s_position = (s_position + chunk) % STORE_CAPACITY;
+    data += chunk;
+    length -= chunk;
+  }
+
+  return true;
+}
+
+static void forget_stored(void) {
+  s_saved_header = (StoreHeader) { 0 };
+  s_stored_count = 0;
+  s_record_index = -1;
+}
+
+// Drop the oldest stored messages, moving the ring start past them
+static void drop_stored(int count) {
+  for (int i = 0; i < count; i++) {
+    s_header.start = (s_header.start + s_stored[i].size) % STORE_CAPACITY;
+  }
+  s_stored_count -= count;
+  memmove(s_stored, s_stored + count, s_stored_count * sizeof(StoredMessage));
+}
+
+// Find the stored message the save starts from, or -1
+static int find_stored(uint32_t hash, uint16_t size) {
+  for (int i = 0; i < s_stored_count; i++) {
+    if (s_stored[i].hash == hash && s_stored[i].size == size) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+// Public API
+
+size_t conversation_store_encoded_size(size_t text_length) {
+  return MESSAGE_HEADER_SIZE + text_length;
+}
+
+size_t conversation_store_capacity(void) {
+  return STORE_CAPACITY;
+}
+
+void conversation_store_save_begin(uint32_t thread_id) {
+  s_header = (StoreHeader) {
+    .version = STORE_VERSION,
+    .message_count = 0,
+    .start = s_saved_header.version == STORE_VERSION ? s_saved_header.start : 0,
+    .length = 0,
+    .thread_id = thread_id,
+  };
+  if (s_saved_header.version != STORE_VERSION) {
+    s_stored_count = 0;
+  }
+  s_matched = 0;
+  s_appending = false;
+  s_records_written = 0;
+}
+
+bool conversation_store_save_message(const char *text, bool is_user, uint8_t first_page, uint8_t page_count) {
+  size_t text_length = strlen(text);
+  size_t size = conversation_store_encoded_size(text_length);
+  if (s_header.length + size > STORE_CAPACITY || s_header.message_count >= MESSAGE_SLOT_COUNT) {
+    return false;
+  }
+
+  uint8_t message_header[MESSAGE_HEADER_SIZE] = {
+    is_user ? FLAG_USER : 0,
+    first_page,
+    page_count,
+    text_length & 0xFF,
+    (text_length >> 8) & 0xFF,
+  };
+  uint32_t hash = hash_bytes(2166136261u, message_header, sizeof(message_header));
+  hash = hash_bytes(hash, (const uint8_t *)text, text_length);
+
+  if (!s_appending) {
+    // Messages already in the ring are kept where they are
+    bool matched;
+    if (s_matched == 0) {
+      int index = find_stored(hash, size);
+      if (index < 0) {
+        // Nothing to keep: continue the ring after the old messages
+        s_header.start = (s_saved_header.start + s_saved_header.length) % STORE_CAPACITY;
+        s_stored_count = 0;
+      } else {
+        drop_stored(index);
+      }
+      matched = index >= 0;
+    } else {
+      matched = s_matched < s_stored_count && s_stored[s_matched].hash == hash &&
+                s_stored[s_matched].size == size;
+    }
+
+    if (matched) {
+      s_matched++;
+      s_header.length += size;
+      s_header.message_count++;
+      return true;
+    }
+
+    // From here on, write after the last kept message
+    s_appending = true;
+    s_stored_count = s_matched;
+    s_position = (s_header.start + s_header.length) % STORE_CAPACITY;
+  }
+
+  write_bytes(message_header, sizeof(message_header));
+  write_bytes((const uint8_t *)text, text_length);
+  s_stored[s_stored_count++] = (StoredMessage) { .hash = hash, .size = size };
+  s_header.length += size;
+  s_header.message_count++;
+
+  return true;
+}
+
+void conversation_store_save_end(void) {
+  flush_record();
+
+  // Stored messages after the last one saved are dropped
+  s_stored_count = s_header.message_count;
+
+  if (memcmp(&s_header, &s_saved_header, sizeof(StoreHeader)) != 0) {
+    persist_write_data(PERSIST_KEY_CONVERSATION_HEADER, &s_header, sizeof(StoreHeader));
+    s_saved_header = s_header;
+  }
+
+  APP_LOG(APP_LOG_LEVEL_DEBUG, "Saved conversation: %d messages, %d bytes, %d records written",
+          s_header.message_count, s_header.length, s_records_written);
+}
+
+int conversation_store_load(uint32_t *thread_id, ConversationStoreMessageHandler handler, void *context) {
+  forget_stored();
+
+  StoreHeader header;
+  if (persist_read_data(PERSIST_KEY_CONVERSATION_HEADER, &header, sizeof(header)) != (int)sizeof(header) ||
+      header.version != STORE_VERSION || header.message_count > MESSAGE_SLOT_COUNT ||
+      header.start >= STORE_CAPACITY || header.length > STORE_CAPACITY) {
+    return 0;
+  }
+  *thread_id = header.thread_id;
+
+  s_position = header.start;
+  uint16_t length = 0;
+  int count = 0;
+  for (; count < header.message_count; count++) {
+    uint8_t message_header[MESSAGE_HEADER_SIZE];
+    if (!read_bytes(message_header, sizeof(message_header))) {
+      break;
+    }
+
+    size_t text_length = message_header[3] | (message_header[4] << 8);
+    size_t size = conversation_store_encoded_size(text_length);
+    if (length + size > header.length) {
+      break;
+    }
+
+    char *text = malloc(text_length + 1);
+    if (!text) {
+      break;
+    }
+
+    if (!read_bytes((uint8_t *)text, text_length)) {
+      free(text);
+      break;
+    }
+    text[text_length] = '\0';
+
+    uint32_t hash = hash_bytes(2166136261u, message_header, sizeof(message_header));
+    s_stored[count] = (StoredMessage) {
+      .hash = hash_bytes(hash, (const uint8_t *)text, text_length),
+      .size = size,
+    };
+    length += size;
+
+    handler(text, message_header[0] & FLAG_USER, message_header[1], message_header[2], context);
+    free(text);
+  }
+
+  // Later saves keep what was read
+  s_saved_header = header;
+  s_saved_header.message_count = count;
+  s_saved_header.length = length;
+  s_stored_count = count;
+
+  return count;
+}
@@ -0,0 +1,74 @@
+#pragma once
+#include <pebble.h>
+
+/**
+ * Conversation Store
+ *
+ * Saves the conversation to persistent storage so it survives app launches.
+ * Messages are encoded back to back in a compact length-prefixed format
+ * (flags, overflow page range, length, text) in a ring spread over persist
+ * records. A save keeps the messages already in the ring where they are:
+ * dropping the oldest ones only moves the ring start in the header, and new
+ * messages are written after the newest, so a turn rewrites the records its
+ * messages land in rather than the whole conversation. Overflow pages are
+ * not copied; they already live in persistent storage.
+ */
+
+// Number of persist records holding the encoded conversation (see persist_keys.h)
+#define CONVERSATION_STORE_RECORD_COUNT 5
+
+/**
+ * Callback for each message read by conversation_store_load().
+ * @param text The in-RAM part of the message text
+ * @param is_user true if this is a user message
+ * @param first_page First overflow page of the message
+ * @param page_count Number of overflow pages
+ * @param context Context passed to conversation_store_load()
+ */
+typedef void (*ConversationStoreMessageHandler)(const char *text, bool is_user,
+                                                uint8_t first_page, uint8_t page_count,
+                                                void *context);
+
+/**
+ * Get the number of bytes a message takes in the store.
+ * @param text_length Length of the in-RAM part of the message text
+ * @return Encoded size in bytes
+ */
+size_t conversation_store_encoded_size(size_t text_length);
+
+/**
+ * Get the total number of bytes available for messages.
+ * @return Capacity in bytes
+ */
+size_t conversation_store_capacity(void);
+
+/**
+ * Start saving a conversation. Follow with conversation_store_save_message()
+ * for each message (oldest first) and finish with conversation_store_save_end().
+ * @param thread_id ID of the conversation's thread (0 if none yet)
+ */
+void conversation_store_save_begin(uint32_t thread_id);
+
+/**
+ * Add a message to the conversation being saved.
+ * @param text The in-RAM part of the message text
+ * @param is_user true if this is a user message
+ * @param first_page First overflow page of the message
+ * @param page_count Number of overflow pages
+ * @return false if the message does not fit in the remaining space or message count
+ */
+bool conversation_store_save_message(const char *text, bool is_user, uint8_t first_page, uint8_t page_count);
+
+/**
+ * Finish saving, writing the header if it changed since the last save or load.
+ */
+void conversation_store_save_end(void);
+
+/**
+ * Read the saved conversation, calling the handler for each message (oldest first).
+ * @param thread_id Set to the ID of the conversation's thread
+ * @param handler Callback for each message
+ * @param context Context passed to the handler
+ * @return Number of messages read
+ */
+int conversation_store_load(uint32_t *thread_id, ConversationStoreMessageHandler handler, void *context);
@@ -0,0 +1,87 @@
+#include "history_window.h"
+#include "thread_index.h"
+
+static Window *s_window;
+static MenuLayer *s_menu_layer;
+static HistoryWindowSelectHandler s_select_handler;
+
+static uint16_t get_num_rows_callback(MenuLayer *menu_layer, uint16_t section_index, void *context) {
+  // "New conversation" plus one row per thread
+  return 1 + thread_index_get_count();
+}
+
+static void draw_row_callback(GContext *ctx, const Layer *cell_layer, MenuIndex *cell_index, void *context) {
+  if (cell_index->row == 0) {
+    menu_cell_basic_draw(ctx, cell_layer, "New conversation", NULL, NULL);
+    return;
+  }
+
+  const ThreadIndexEntry *entry = thread_index_get(cell_index->row - 1);
+  if (!entry) {
+    return;
+  }
+
+  // Subtitle: date of last activity and number of messages
+  char subtitle[32];
+  char date[12];
+  time_t timestamp = entry->timestamp;
+  strftime(date, sizeof(date), "%b %e", localtime(&timestamp));
+  snprintf(subtitle, sizeof(subtitle), "%s, %d messages", date, entry->message_count);
+
+  menu_cell_basic_draw(ctx, cell_layer, entry->title, subtitle, NULL);
+}
+
+static void select_callback(MenuLayer *menu_layer, MenuIndex *cell_index, void *context) {
+  uint32_t thread_id = 0;
+  if (cell_index->row > 0) {
+    const ThreadIndexEntry *entry = thread_index_get(cell_index->row - 1);
+    thread_id = entry ? entry->thread_id : 0;
+  }
+
+  window_stack_remove(s_window, true);
+
+  if (s_select_handler) {
+    s_select_handler(thread_id);
+  }
+}
+
+static void window_load(Window *window) {
+  Layer *window_layer = window_get_root_layer(window);
+  GRect bounds = layer_get_bounds(window_layer);
+
+  s_menu_layer = menu_layer_create(bounds);
+  menu_layer_set_callbacks(s_menu_layer, NULL, (MenuLayerCallbacks) {
+    .get_num_rows = get_num_rows_callback,
+    .draw_row = draw_row_callback,
+    .select_click = select_callback,
+  });
+  menu_layer_set_highlight_colors(s_menu_layer, PBL_IF_COLOR_ELSE(GColorRajah, GColorBlack), GColorWhite);
+  menu_layer_set_click_config_onto_window(s_menu_layer, window);
+  layer_add_child(window_layer, menu_layer_get_layer(s_menu_layer));
+}
+
+static void window_unload(Window *window) {
+  if (s_menu_layer) {
+    menu_layer_destroy(s_menu_layer);
+    s_menu_layer = NULL;
+  }
+}
+
+Window* history_window_create(HistoryWindowSelectHandler select_handler) {
+  s_select_handler = select_handler;
+
+  s_window = window_create();
+  window_set_background_color(s_window, GColorWhite);
+  window_set_window_handlers(s_window, (WindowHandlers) {
+    .load = window_load,
+    .unload = window_unload,
+  });
+
+  return s_window;
+}
+
+void history_window_destroy(Window *window) {
+  if (window) {
+    window_destroy(window);
+  }
+}
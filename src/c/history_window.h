@@ -0,0 +1,29 @@
+#pragma once
+#include <pebble.h>
+
+/**
+ * History Window - Lists past conversations
+ *
+ * Shows a "New conversation" row followed by the threads in the thread
+ * index, most recently used first. Selecting a row pops the window and
+ * reports the choice.
+ */
+
+/**
+ * Callback for a selected row.
+ * @param thread_id ID of the selected thread, or 0 for a new conversation
+ */
+typedef void (*HistoryWindowSelectHandler)(uint32_t thread_id);
+
+/**
+ * Create the history window.
+ * @param select_handler Called when a row is selected
+ * @return Pointer to the created window
+ */
+Window* history_window_create(HistoryWindowSelectHandler select_handler);
+
+/**
+ * Destroy the history window and free its resources.
+ * @param window The window to destroy
+ */
+void history_window_destroy(Window *window);
@@ -0,0 +1,38 @@
+#pragma once
+
+/**
+ * Memory Profile
+ *
+ * Buffer and pool sizes that depend on how much RAM the platform leaves to
+ * the app. LOW_MEMORY_PROFILE is defined per platform in wscript for
+ * watches with a small app heap (aplite); it also replaces the animated
+ * spark with a single static one drawn without PDC sequences.
+ */
+
+#ifdef LOW_MEMORY_PROFILE
+
+// AppMessage buffers (the inbox size is reported to the phone with every
+// request, so responses are sent in chunks that fit)
+#define APP_MESSAGE_INBOX_SIZE 1024
+#define APP_MESSAGE_OUTBOX_SIZE 1024
+
+// Chat history: message slots and the byte budget of the text pool
+#define MESSAGE_SLOT_COUNT 12
+#define TEXT_POOL_MAX_SIZE 2048
+#define HEAP_SAFETY_MARGIN 2048
+
+// Overflow pages kept in RAM (message_pages.c)
+#define RESIDENT_PAGE_COUNT 2
+
+#else
+
+#define APP_MESSAGE_INBOX_SIZE 4096
+#define APP_MESSAGE_OUTBOX_SIZE 4096
+
+#define MESSAGE_SLOT_COUNT 32
+#define TEXT_POOL_MAX_SIZE 8192
+#define HEAP_SAFETY_MARGIN 4096
+
+#define RESIDENT_PAGE_COUNT 4
+
+#endif
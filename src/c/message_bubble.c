@@ -1,42 +1,17 @@
 #include "message_bubble.h"
 
-#define MESSAGE_PADDING 10
+#define MESSAGE_PADDING (MESSAGE_BUBBLE_PADDING_HEIGHT / 2)
 #define MESSAGE_FONT FONT_KEY_GOTHIC_24_BOLD
+#define STATUS_FONT FONT_KEY_GOTHIC_14
 
-struct MessageBubble {
-  Layer *layer;
-  TextLayer *text_layer;
-  bool is_user;
-  int max_width;
-};
+// Measured text a layout may carry behind its anchor before the anchor is
+// moved up to the last line (finding the line costs a few measurements)
+#define ANCHOR_SLACK 64
 
-static void background_update_proc(Layer *layer, GContext *ctx) {
-  MessageBubble *bubble = *(MessageBubble**)layer_get_data(layer);
-  if (!bubble) {
-    return;
-  }
-
-  // Only draw background for user messages (rectangle spanning full width)
-  if (bubble->is_user) {
-    GRect bounds = layer_get_bounds(layer);
-    graphics_context_set_fill_color(ctx, PBL_IF_COLOR_ELSE(GColorRajah, GColorLightGray));
-    graphics_fill_rect(ctx, bounds, 0, GCornerNone);  // No rounded corners
-  }
-  // Claude messages have no background (white on white)
-}
-
-MessageBubble* message_bubble_create(const char *text, bool is_user, int max_width) {
-  MessageBubble *bubble = malloc(sizeof(MessageBubble));
-  if (!bubble) {
-    return NULL;
-  }
-
-  bubble->is_user = is_user;
-  bubble->max_width = max_width;
-
-  // Calculate text size (account for padding so bubble doesn't exceed max_width)
+int message_bubble_measure_text_height(const char *text, int width) {
+  // Calculate text size (account for padding so bubble doesn't exceed width)
   GFont font = fonts_get_system_font(MESSAGE_FONT);
-  int available_text_width = max_width - (MESSAGE_PADDING * 2);
+  int available_text_width = width - (MESSAGE_PADDING * 2);
   GSize text_size = graphics_text_layout_get_content_size(
     text,
     font,
@@ -45,92 +20,147 @@ MessageBubble* message_bubble_create(const char *text, bool is_user, int max_wid
     GTextAlignmentLeft
   );
 
-  // Bubble spans full width, height based on text + padding
-  int bubble_height = text_size.h + (MESSAGE_PADDING * 2);
-
-  // Create container layer with background (full width)
-  bubble->layer = layer_create_with_data(GRect(0, 0, max_width, bubble_height), sizeof(MessageBubble*));
-  layer_set_update_proc(bubble->layer, background_update_proc);
-  *(MessageBubble**)layer_get_data(bubble->layer) = bubble;
-
-  // Create text layer (positioned to center vertically, with extra height for descenders)
-  bubble->text_layer = text_layer_create(GRect(
-    MESSAGE_PADDING,
-    MESSAGE_PADDING / 2,
-    text_size.w,
-    bubble_height - MESSAGE_PADDING
-  ));
-  text_layer_set_text(bubble->text_layer, text);
-  text_layer_set_font(bubble->text_layer, font);
-  text_layer_set_text_alignment(bubble->text_layer, GTextAlignmentLeft);
-  text_layer_set_background_color(bubble->text_layer, GColorClear);
-  text_layer_set_text_color(bubble->text_layer, GColorBlack);
-  layer_add_child(bubble->layer, text_layer_get_layer(bubble->text_layer));
-
-  return bubble;
+  return text_size.h;
 }
 
-void message_bubble_destroy(MessageBubble *bubble) {
-  if (!bubble) {
-    return;
-  }
+// Height of the first length bytes of text
+static int prefix_height(char *text, size_t length, int width) {
+  char saved = text[length];
+  text[length] = '\0';
+  int height = message_bubble_measure_text_height(text, width);
+  text[length] = saved;
+  return height;
+}
 
-  if (bubble->text_layer) {
-    text_layer_destroy(bubble->text_layer);
+static bool is_continuation_byte(char c) {
+  return ((uint8_t)c & 0xC0) == 0x80;
+}
+
+// Move the anchor to the start of the last line of the text measured so far.
+// That line starts right after the longest prefix of the tail (the text from
+// the anchor) that takes fewer lines than the whole tail.
+static void move_anchor(MessageBubbleLayout *layout, char *text, int width) {
+  char *tail = text + layout->anchor;
+  size_t tail_length = layout->length - layout->anchor;
+  int tail_height = layout->height - layout->anchor_y;
+
+  // The last line is short, so gallop back from the end to bracket its start
+  size_t low = 0;
+  size_t high = tail_length;
+  for (size_t step = 8; step < tail_length; step *= 2) {
+    size_t probe = tail_length - step;
+    while (probe > 0 && is_continuation_byte(tail[probe])) {
+      probe--;
+    }
+    if (prefix_height(tail, probe, width) < tail_height) {
+      low = probe;
+      break;
+    }
+    high = probe;
   }
 
-  if (bubble->layer) {
-    layer_destroy(bubble->layer);
+  while (low < high) {
+    // Only split between UTF-8 characters
+    size_t mid = (low + high + 1) / 2;
+    while (mid < high && is_continuation_byte(tail[mid])) {
+      mid++;
+    }
+
+    if (prefix_height(tail, mid, width) < tail_height) {
+      low = mid;
+    } else {
+      high = mid - 1;
+      while (high > low && is_continuation_byte(tail[high])) {
+        high--;
+      }
+    }
   }
 
-  free(bubble);
-}
+  // A partial first word of the last line may fit on the line above, so
+  // back up to the start of that word
+  while (low > 0 && tail[low - 1] != ' ' && tail[low - 1] != '\n') {
+    low--;
+  }
+  if (low == 0) {
+    return;
+  }
 
-void message_bubble_set_text(MessageBubble *bubble, const char *text) {
-  if (!bubble || !bubble->text_layer) {
+  // Keep the old anchor unless the text really breaks there
+  int head_height = prefix_height(tail, low, width);
+  int rest_height = prefix_height(tail + low, tail_length - low, width);
+  if (head_height + rest_height != tail_height) {
     return;
   }
 
-  // Update text
-  text_layer_set_text(bubble->text_layer, text);
+  layout->anchor += low;
+  layout->anchor_y += head_height;
+}
 
-  // Recalculate text size (account for padding so bubble doesn't exceed max_width)
-  GFont font = fonts_get_system_font(MESSAGE_FONT);
-  int available_text_width = bubble->max_width - (MESSAGE_PADDING * 2);
-  GSize text_size = graphics_text_layout_get_content_size(
-    text,
-    font,
-    GRect(0, 0, available_text_width, 2000),
-    GTextOverflowModeWordWrap,
-    GTextAlignmentLeft
-  );
+void message_bubble_layout_reset(MessageBubbleLayout *layout) {
+  *layout = (MessageBubbleLayout) { 0 };
+}
 
-  // Update bubble height (width stays at max_width)
-  int bubble_height = text_size.h + (MESSAGE_PADDING * 2);
-  GRect frame = layer_get_frame(bubble->layer);
-  frame.size.h = bubble_height;
-  layer_set_frame(bubble->layer, frame);
+int message_bubble_layout_measure(MessageBubbleLayout *layout, char *text, int width) {
+  size_t length = strlen(text);
+
+  if (layout->length == 0 || layout->width != width || length < layout->length) {
+    // Measure everything
+    layout->width = width;
+    layout->anchor = 0;
+    layout->anchor_y = 0;
+  } else if (length > layout->length && layout->length - layout->anchor > ANCHOR_SLACK) {
+    // Appended text: everything before the last measured line stays put
+    move_anchor(layout, text, width);
+  }
 
-  // Update text layer size and position (centered vertically with extra height for descenders)
-  GRect text_frame = GRect(
-    MESSAGE_PADDING,
-    MESSAGE_PADDING / 2,
-    text_size.w,
-    bubble_height - MESSAGE_PADDING
-  );
-  layer_set_frame(text_layer_get_layer(bubble->text_layer), text_frame);
+  layout->length = length;
+  layout->height = layout->anchor_y + message_bubble_measure_text_height(text + layout->anchor, width);
+  return layout->height;
+}
 
-  layer_mark_dirty(bubble->layer);
+void message_bubble_draw_background(GContext *ctx, GRect frame, bool is_user) {
+  // Only draw background for user messages (rectangle spanning full width)
+  if (is_user) {
+    graphics_context_set_fill_color(ctx, PBL_IF_COLOR_ELSE(GColorRajah, GColorLightGray));
+    graphics_fill_rect(ctx, frame, 0, GCornerNone);  // No rounded corners
+  }
+  // Claude messages have no background (white on white)
 }
 
-Layer* message_bubble_get_layer(MessageBubble *bubble) {
-  return bubble ? bubble->layer : NULL;
+void message_bubble_draw_text(GContext *ctx, GRect frame, const char *text) {
+  // Inset horizontally, with extra height for descenders
+  GRect text_frame = GRect(
+    frame.origin.x + MESSAGE_PADDING,
+    frame.origin.y,
+    frame.size.w - (MESSAGE_PADDING * 2),
+    frame.size.h + MESSAGE_PADDING
+  );
+
+  graphics_context_set_text_color(ctx, GColorBlack);
+  graphics_draw_text(ctx,
+    text,
+    fonts_get_system_font(MESSAGE_FONT),
+    text_frame,
+    GTextOverflowModeWordWrap,
+    GTextAlignmentLeft,
+    NULL);
 }
 
-int message_bubble_get_height(MessageBubble *bubble) {
-  if (!bubble || !bubble->layer) {
-    return 0;
-  }
+void message_bubble_draw_status(GContext *ctx, GRect frame, const char *status) {
+  // Right-aligned in the space reserved above the bottom padding
+  GRect status_frame = GRect(
+    frame.origin.x + MESSAGE_PADDING,
+    frame.origin.y + frame.size.h - MESSAGE_BUBBLE_STATUS_HEIGHT - MESSAGE_PADDING / 2,
+    frame.size.w - (MESSAGE_PADDING * 2),
+    MESSAGE_BUBBLE_STATUS_HEIGHT
+  );
 
-  return layer_get_frame(bubble->layer).size.h;
+  graphics_context_set_text_color(ctx, GColorDarkGray);
+  graphics_draw_text(ctx,
+    status,
+    fonts_get_system_font(STATUS_FONT),
+    status_frame,
+    GTextOverflowModeTrailingEllipsis,
+    GTextAlignmentRight,
+    NULL);
 }
@@ -2,46 +2,86 @@
 #include <pebble.h>
 
 /**
- * Message Bubble Component
+ * Message Bubble Rendering
  *
- * Displays a single message in the chat with appropriate styling.
+ * Measures and draws a single message in the chat with appropriate styling.
  * User messages have grey background, Claude messages have white/clear background.
+ * Bubbles are not layers: the chat window draws every visible bubble from the
+ * update proc of a single content layer.
+ *
+ * A bubble is a background plus one or more text blocks stacked vertically
+ * (long messages are split into several blocks).
  */
 
-typedef struct MessageBubble MessageBubble;
+// Total vertical padding of a bubble around its text blocks
+#define MESSAGE_BUBBLE_PADDING_HEIGHT 20
+
+// Offset of the first text block from the top of the bubble
+#define MESSAGE_BUBBLE_TEXT_OFFSET 5
+
+// Extra height of a bubble showing a status line (e.g. "Queued")
+#define MESSAGE_BUBBLE_STATUS_HEIGHT 18
 
 /**
- * Create a new message bubble.
- * @param text The message text to display
- * @param is_user true if this is a user message (grey background), false for Claude (white)
- * @param max_width Maximum width for the bubble (for text wrapping)
- * @return Pointer to the created message bubble
+ * Measure the height of one text block.
+ * @param text The text of the block
+ * @param width Width of the bubble (for text wrapping)
+ * @return Height in pixels, without bubble padding
  */
-MessageBubble* message_bubble_create(const char *text, bool is_user, int max_width);
+int message_bubble_measure_text_height(const char *text, int width);
 
 /**
- * Destroy a message bubble and free its resources.
- * @param bubble The bubble to destroy
+ * Layout state of a growing text block (e.g. a response arriving in chunks).
+ * Remembers where the last laid-out line starts so that appended text only
+ * needs that line and the new text measured.
  */
-void message_bubble_destroy(MessageBubble *bubble);
+typedef struct {
+  int16_t width;
+  int16_t height;
+  uint16_t length;
+  uint16_t anchor;
+  int16_t anchor_y;
+} MessageBubbleLayout;
 
 /**
- * Update the text in the message bubble (for streaming support).
- * @param bubble The bubble to update
- * @param text The new text to display
+ * Forget a layout (the next measure covers the whole text).
+ * @param layout The layout state
+ */
+void message_bubble_layout_reset(MessageBubbleLayout *layout);
+
+/**
+ * Measure a text block that may have grown since the last call.
+ * Only the text from the start of the last measured line is measured again;
+ * the whole text is measured when the width changes or the text got shorter.
+ * The text is briefly NUL-terminated at line boundaries while measuring.
+ * @param layout The layout state of the block
+ * @param text The text of the block
+ * @param width Width of the bubble (for text wrapping)
+ * @return Height in pixels, without bubble padding
+ */
+int message_bubble_layout_measure(MessageBubbleLayout *layout, char *text, int width);
+
+/**
+ * Draw the background of a bubble.
+ * @param ctx The graphics context of the layer being drawn
+ * @param frame Position and size of the whole bubble
+ * @param is_user true if this is a user message (grey background), false for Claude (white)
  */
-void message_bubble_set_text(MessageBubble *bubble, const char *text);
+void message_bubble_draw_background(GContext *ctx, GRect frame, bool is_user);
 
 /**
- * Get the underlying Layer for adding to view hierarchy.
- * @param bubble The message bubble
- * @return The Layer object
+ * Draw one text block of a bubble.
+ * @param ctx The graphics context of the layer being drawn
+ * @param frame Bubble-wide frame of the block (height from message_bubble_measure_text_height)
+ * @param text The text of the block
  */
-Layer* message_bubble_get_layer(MessageBubble *bubble);
+void message_bubble_draw_text(GContext *ctx, GRect frame, const char *text);
 
 /**
- * Get the height of the message bubble (for layout calculations).
- * @param bubble The message bubble
- * @return Height in pixels
+ * Draw a status line at the bottom of a bubble.
+ * The bubble must include MESSAGE_BUBBLE_STATUS_HEIGHT in its height.
+ * @param ctx The graphics context of the layer being drawn
+ * @param frame Position and size of the whole bubble
+ * @param status The status text (e.g. "Queued")
  */
-int message_bubble_get_height(MessageBubble *bubble);
+void message_bubble_draw_status(GContext *ctx, GRect frame, const char *status);
@@ -0,0 +1,175 @@
+#include "message_pages.h"
+#include "persist_keys.h"
+#include "memory_profile.h"
+
+#define SPLIT_LOOKBACK 48
+
+// A page held in RAM (dirty until its text is persisted)
+typedef struct {
+  bool loaded;
+  bool dirty;
+  int16_t page;
+  uint32_t last_used;
+  char text[MESSAGE_PAGE_SIZE];
+} ResidentPage;
+
+static ResidentPage s_resident[RESIDENT_PAGE_COUNT];
+static uint32_t s_use_counter = 0;
+
+// Private helper functions
+
+static ResidentPage* find_resident(int page) {
+  for (int i = 0; i < RESIDENT_PAGE_COUNT; i++) {
+    if (s_resident[i].loaded && s_resident[i].page == page) {
+      return &s_resident[i];
+    }
+  }
+  return NULL;
+}
+
+static void persist_page(ResidentPage *slot) {
+  if (!slot->dirty) {
+    return;
+  }
+  slot->dirty = false;
+
+  int result = persist_write_data(PERSIST_KEY_PAGE_BASE + slot->page, slot->text, strlen(slot->text) + 1);
+  if (result < 0) {
+    APP_LOG(APP_LOG_LEVEL_ERROR, "Failed to write page %d: %d", slot->page, result);
+  }
+}
+
+static ResidentPage* claim_resident(int page) {
+  // Reuse an empty slot, otherwise the least recently used one
+  ResidentPage *slot = &s_resident[0];
+  for (int i = 0; i < RESIDENT_PAGE_COUNT; i++) {
+    if (!s_resident[i].loaded) {
+      slot = &s_resident[i];
+      break;
+    }
+    if (s_resident[i].last_used < slot->last_used) {
+      slot = &s_resident[i];
+    }
+  }
+
+  // An evicted page is persisted before its slot is reused
+  persist_page(slot);
+  slot->loaded = true;
+  slot->page = page;
+  slot->last_used = ++s_use_counter;
+  return slot;
+}
+
+static ResidentPage* load_page(int page) {
+  ResidentPage *slot = find_resident(page);
+  if (slot) {
+    slot->last_used = ++s_use_counter;
+    return slot;
+  }
+
+  slot = claim_resident(page);
+  int read = persist_read_data(PERSIST_KEY_PAGE_BASE + page, slot->text, MESSAGE_PAGE_SIZE);
+  if (read < 0) {
+    APP_LOG(APP_LOG_LEVEL_ERROR, "Failed to read page %d: %d", page, read);
+    read = 0;
+  }
+  slot->text[read < MESSAGE_PAGE_SIZE ? read : MESSAGE_PAGE_SIZE - 1] = '\0';
+
+  return slot;
+}
+
+// Public API
+
+size_t message_pages_split_length(const char *text, size_t length, size_t max_length) {
+  if (length <= max_length) {
+    return length;
+  }
+
+  // Prefer breaking right after whitespace near the end of the chunk
+  size_t lookback_limit = max_length > SPLIT_LOOKBACK ? max_length - SPLIT_LOOKBACK : 0;
+  for (size_t i = max_length; i > lookback_limit; i--) {
+    if (text[i - 1] == ' ' || text[i - 1] == '\n') {
+      return i;
+    }
+  }
+
+  // Otherwise break at the limit, backing off UTF-8 continuation bytes
+  size_t split = max_length;
+  while (split > 0 && ((uint8_t)text[split] & 0xC0) == 0x80) {
+    split--;
+  }
+  return split;
+}
+
+const char* message_pages_write(int page, const char *text, size_t length) {
+  ResidentPage *slot = find_resident(page);
+  if (!slot) {
+    slot = claim_resident(page);
+  }
+
+  if (length >= MESSAGE_PAGE_SIZE) {
+    length = MESSAGE_PAGE_SIZE - 1;
+  }
+  memcpy(slot->text, text, length);
+  slot->text[length] = '\0';
+  slot->last_used = ++s_use_counter;
+  slot->dirty = true;
+
+  return slot->text;
+}
+
+const char* message_pages_get(int page) {
+  return load_page(page)->text;
+}
+
+void message_pages_prefetch(int page) {
+  if (!find_resident(page)) {
+    load_page(page);
+  }
+}
+
+size_t message_pages_copy(int page, char *dest, size_t size) {
+  if (size == 0) {
+    return 0;
+  }
+
+  ResidentPage *slot = find_resident(page);
+  if (slot) {
+    size_t length = message_pages_split_length(slot->text, strlen(slot->text), size - 1);
+    memcpy(dest, slot->text, length);
+    dest[length] = '\0';
+    return length;
+  }
+
+  int read = persist_read_data(PERSIST_KEY_PAGE_BASE + page, dest, size);
+  if (read <= 0) {
+    dest[0] = '\0';
+    return 0;
+  }
+
+  // A page cut short ends where it can be split (the byte read past the end
+  // tells whether a character continues there)
+  const char *end = memchr(dest, '\0', read);
+  size_t length = end ? (size_t)(end - dest) : (size_t)read;
+  if (length == size) {
+    length = message_pages_split_length(dest, length, size - 1);
+  }
+  dest[length] = '\0';
+  return length;
+}
+
+void message_pages_flush(void) {
+  for (int i = 0; i < RESIDENT_PAGE_COUNT; i++) {
+    if (s_resident[i].loaded) {
+      persist_page(&s_resident[i]);
+    }
+  }
+}
+
+void message_pages_reset(void) {
+  for (int i = 0; i < RESIDENT_PAGE_COUNT; i++) {
+    s_resident[i].loaded = false;
+    s_resident[i].dirty = false;
+  }
+  s_use_counter = 0;
+}
@@ -0,0 +1,72 @@
+#pragma once
+#include <pebble.h>
+
+/**
+ * Message Pages
+ *
+ * Persist-backed storage for the overflow of long messages.
+ * Text beyond a message's in-RAM part is stored in fixed-size pages in
+ * persistent storage. Only a few recently used pages are resident in RAM,
+ * the rest are loaded on demand (e.g. as the user scrolls). Writes stay in
+ * RAM until the page is evicted or message_pages_flush is called, so a page
+ * filled by many small appends is persisted once.
+ */
+
+// Size of one page including the terminating NUL (one persist record)
+#define MESSAGE_PAGE_SIZE PERSIST_DATA_MAX_LENGTH
+
+// Number of pages available in persistent storage (see persist_keys.h)
+#define MESSAGE_PAGE_COUNT 8
+
+/**
+ * Find where to split text so a chunk fits in max_length bytes.
+ * Prefers breaking after whitespace and never splits a UTF-8 sequence.
+ * @param text The text to split
+ * @param length Length of the text in bytes
+ * @param max_length Maximum chunk length in bytes
+ * @return Length of the first chunk (0 if not even one character fits)
+ */
+size_t message_pages_split_length(const char *text, size_t length, size_t max_length);
+
+/**
+ * Store text in a page (kept resident, persisted when evicted or flushed).
+ * @param page Page index (0 to MESSAGE_PAGE_COUNT - 1)
+ * @param text Text to store (need not be NUL-terminated)
+ * @param length Length of the text, at most MESSAGE_PAGE_SIZE - 1
+ * @return The resident copy of the page text
+ */
+const char* message_pages_write(int page, const char *text, size_t length);
+
+/**
+ * Get the text of a page, loading it from persistent storage if needed.
+ * The returned pointer is valid until another page is loaded.
+ * @param page Page index
+ * @return The page text (empty string if the page cannot be read)
+ */
+const char* message_pages_get(int page);
+
+/**
+ * Load a page into RAM ahead of time if it is not resident yet.
+ * @param page Page index
+ */
+void message_pages_prefetch(int page);
+
+/**
+ * Copy the text of a page without making it resident. A page longer than
+ * the destination is cut as by message_pages_split_length.
+ * @param page Page index
+ * @param dest Destination buffer
+ * @param size Size of the destination buffer
+ * @return Number of bytes copied (excluding the terminating NUL)
+ */
+size_t message_pages_copy(int page, char *dest, size_t size);
+
+/**
+ * Persist the resident pages written since they were last persisted.
+ */
+void message_pages_flush(void);
+
+/**
+ * Drop all resident pages (unsaved writes are discarded).
+ */
+void message_pages_reset(void);
@@ -0,0 +1,30 @@
+#pragma once
+
+/**
+ * Persistent Storage Keys
+ *
+ * All persist keys used by the app. Storage is limited to 4 KB per app, in
+ * records of up to PERSIST_DATA_MAX_LENGTH bytes, so every range below is
+ * sized to keep the total under that limit:
+ *   message pages         8 records (MESSAGE_PAGE_COUNT)
+ *   saved conversation    1 header + 5 records (CONVERSATION_STORE_RECORD_COUNT)
+ *   thread index          1 record
+ *   request queue         1 small record
+ *   settings              1 small record
+ */
+
+// Overflow pages of long messages (message_pages.c)
+#define PERSIST_KEY_PAGE_BASE 100
+
+// Saved conversation (conversation_store.c)
+#define PERSIST_KEY_CONVERSATION_HEADER 200
+#define PERSIST_KEY_CONVERSATION_BASE 201
+
+// Index of past conversations (thread_index.c)
+#define PERSIST_KEY_THREAD_INDEX 300
+
+// Requests waiting to be sent or answered (request_queue.c)
+#define PERSIST_KEY_REQUEST_QUEUE 400
+
+// Whether dictation asks to confirm the transcription (chat_window.c)
+#define PERSIST_KEY_DICTATION_CONFIRM 500
@@ -0,0 +1,145 @@
+#include "reply_window.h"
+
+static Window *s_window;
+static MenuLayer *s_menu_layer;
+static ReplyWindowSelectHandler s_select_handler;
+
+// Suggestions for the last response (kept while the window is closed)
+static char s_suggestions[REPLY_WINDOW_MAX_SUGGESTIONS][REPLY_WINDOW_SUGGESTION_SIZE];
+static int s_suggestion_count = 0;
+
+#if defined(PBL_MICROPHONE)
+#define VOICE_ROW_COUNT 1
+#else
+// Without a microphone there is no voice row, and starter prompts are
+// offered when the last response came without suggestions
+#define VOICE_ROW_COUNT 0
+static const char *const STARTER_PROMPTS[] = {
+  "Tell me a fun fact",
+  "Give me a quick tip",
+  "What should I cook?",
+};
+#endif
+
+static int get_option_count(void) {
+#if !defined(PBL_MICROPHONE)
+  if (s_suggestion_count == 0) {
+    return ARRAY_LENGTH(STARTER_PROMPTS);
+  }
+#endif
+  return s_suggestion_count;
+}
+
+static const char* get_option(int index) {
+#if !defined(PBL_MICROPHONE)
+  if (s_suggestion_count == 0) {
+    return STARTER_PROMPTS[index];
+  }
+#endif
+  return s_suggestions[index];
+}
+
+static uint16_t get_num_rows_callback(MenuLayer *menu_layer, uint16_t section_index, void *context) {
+  // "Reply by voice" plus one row per suggestion
+  return VOICE_ROW_COUNT + get_option_count();
+}
+
+static void draw_row_callback(GContext *ctx, const Layer *cell_layer, MenuIndex *cell_index, void *context) {
+#if defined(PBL_MICROPHONE)
+  if (cell_index->row < VOICE_ROW_COUNT) {
+    menu_cell_basic_draw(ctx, cell_layer, "Reply by voice", NULL, NULL);
+    return;
+  }
+#endif
+
+  menu_cell_basic_draw(ctx, cell_layer, get_option(cell_index->row - VOICE_ROW_COUNT), NULL, NULL);
+}
+
+static void select_callback(MenuLayer *menu_layer, MenuIndex *cell_index, void *context) {
+#if defined(PBL_MICROPHONE)
+  const char *suggestion = cell_index->row >= VOICE_ROW_COUNT ? get_option(cell_index->row - VOICE_ROW_COUNT) : NULL;
+#else
+  const char *suggestion = get_option(cell_index->row);
+#endif
+
+  window_stack_remove(s_window, true);
+
+  if (s_select_handler) {
+    s_select_handler(suggestion);
+  }
+}
+
+static void window_load(Window *window) {
+  Layer *window_layer = window_get_root_layer(window);
+  GRect bounds = layer_get_bounds(window_layer);
+
+  s_menu_layer = menu_layer_create(bounds);
+  menu_layer_set_callbacks(s_menu_layer, NULL, (MenuLayerCallbacks) {
+    .get_num_rows = get_num_rows_callback,
+    .draw_row = draw_row_callback,
+    .select_click = select_callback,
+  });
+  menu_layer_set_highlight_colors(s_menu_layer, PBL_IF_COLOR_ELSE(GColorRajah, GColorBlack), GColorWhite);
+  menu_layer_set_click_config_onto_window(s_menu_layer, window);
+  layer_add_child(window_layer, menu_layer_get_layer(s_menu_layer));
+}
+
+static void window_unload(Window *window) {
+  if (s_menu_layer) {
+    menu_layer_destroy(s_menu_layer);
+    s_menu_layer = NULL;
+  }
+}
+
+Window* reply_window_create(ReplyWindowSelectHandler select_handler) {
+  s_select_handler = select_handler;
+
+  s_window = window_create();
+  window_set_background_color(s_window, GColorWhite);
+  window_set_window_handlers(s_window, (WindowHandlers) {
+    .load = window_load,
+    .unload = window_unload,
+  });
+
+  return s_window;
+}
+
+void reply_window_destroy(Window *window) {
+  if (window) {
+    window_destroy(window);
+  }
+}
+
+void reply_window_set_suggestions(const char *suggestions) {
+  s_suggestion_count = 0;
+
+  while (suggestions && *suggestions && s_suggestion_count < REPLY_WINDOW_MAX_SUGGESTIONS) {
+    const char *end = strchr(suggestions, '\n');
+    size_t length = end ? (size_t)(end - suggestions) : strlen(suggestions);
+
+    // Truncate long suggestions without splitting a UTF-8 character
+    size_t copy_length = length;
+    if (copy_length > REPLY_WINDOW_SUGGESTION_SIZE - 1) {
+      copy_length = REPLY_WINDOW_SUGGESTION_SIZE - 1;
+      while (copy_length > 0 && (suggestions[copy_length] & 0xC0) == 0x80) {
+        copy_length--;
+      }
+    }
+
+    if (copy_length > 0) {
+      memcpy(s_suggestions[s_suggestion_count], suggestions, copy_length);
+      s_suggestions[s_suggestion_count][copy_length] = '\0';
+      s_suggestion_count++;
+    }
+
+    suggestions += end ? length + 1 : length;
+  }
+
+  if (s_menu_layer) {
+    menu_layer_reload_data(s_menu_layer);
+  }
+}
+
+int reply_window_get_suggestion_count(void) {
+  return s_suggestion_count;
+}
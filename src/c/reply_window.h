@@ -0,0 +1,46 @@
+#pragma once
+#include <pebble.h>
+
+/**
+ * Reply Window - Picks how to answer Claude
+ *
+ * Shows a "Reply by voice" row followed by the follow-up suggestions that
+ * came with the last response. Selecting a row pops the window and reports
+ * the choice, so a suggestion is sent with a single click. On watches
+ * without a microphone it is the only way to reply, with starter prompts
+ * offered when there are no suggestions.
+ */
+
+#define REPLY_WINDOW_MAX_SUGGESTIONS 3
+#define REPLY_WINDOW_SUGGESTION_SIZE 40
+
+/**
+ * Callback for a selected row.
+ * @param suggestion Text of the selected suggestion, or NULL to reply by voice
+ */
+typedef void (*ReplyWindowSelectHandler)(const char *suggestion);
+
+/**
+ * Create the reply window.
+ * @param select_handler Called when a row is selected
+ * @return Pointer to the created window
+ */
+Window* reply_window_create(ReplyWindowSelectHandler select_handler);
+
+/**
+ * Destroy the reply window and free its resources.
+ * @param window The window to destroy
+ */
+void reply_window_destroy(Window *window);
+
+/**
+ * Replace the suggestions shown in the reply window.
+ * @param suggestions Newline-separated suggestions, or NULL to clear them
+ */
+void reply_window_set_suggestions(const char *suggestions);
+
+/**
+ * Get the number of suggestions available.
+ * @return Number of suggestions (0 if the last response had none)
+ */
+int reply_window_get_suggestion_count(void);
@@ -0,0 +1,75 @@
+#include "request_queue.h"
+#include "persist_keys.h"
+
+static RequestQueueEntry s_entries[REQUEST_QUEUE_CAPACITY];
+static int s_count = 0;
+static bool s_loaded = false;
+
+// Private helper functions
+
+static void ensure_loaded(void) {
+  if (s_loaded) {
+    return;
+  }
+  s_loaded = true;
+
+  int read = persist_read_data(PERSIST_KEY_REQUEST_QUEUE, s_entries, sizeof(s_entries));
+  s_count = read > 0 ? read / (int)sizeof(RequestQueueEntry) : 0;
+}
+
+static void save(void) {
+  if (s_count == 0) {
+    persist_delete(PERSIST_KEY_REQUEST_QUEUE);
+    return;
+  }
+
+  int result = persist_write_data(PERSIST_KEY_REQUEST_QUEUE, s_entries, s_count * sizeof(RequestQueueEntry));
+  if (result < 0) {
+    APP_LOG(APP_LOG_LEVEL_ERROR, "Failed to write request queue: %d", result);
+  }
+}
+
+// Public API
+
+void request_queue_push(uint32_t request_id, uint32_t thread_id) {
+  ensure_loaded();
+
+  if (s_count == REQUEST_QUEUE_CAPACITY) {
+    APP_LOG(APP_LOG_LEVEL_WARNING, "Request queue full, dropping %u", (unsigned)s_entries[0].request_id);
+    memmove(&s_entries[0], &s_entries[1], (s_count - 1) * sizeof(RequestQueueEntry));
+    s_count--;
+  }
+
+  s_entries[s_count++] = (RequestQueueEntry) {
+    .request_id = request_id,
+    .thread_id = thread_id,
+  };
+  save();
+}
+
+const RequestQueueEntry* request_queue_peek(void) {
+  ensure_loaded();
+  return s_count > 0 ? &s_entries[0] : NULL;
+}
+
+void request_queue_pop(void) {
+  ensure_loaded();
+  if (s_count == 0) {
+    return;
+  }
+
+  memmove(&s_entries[0], &s_entries[1], (s_count - 1) * sizeof(RequestQueueEntry));
+  s_count--;
+  save();
+}
+
+void request_queue_clear(void) {
+  ensure_loaded();
+  s_count = 0;
+  save();
+}
+
+int request_queue_get_count(void) {
+  ensure_loaded();
+  return s_count;
+}
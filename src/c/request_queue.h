@@ -0,0 +1,47 @@
+#pragma once
+#include <pebble.h>
+
+/**
+ * Request Queue
+ *
+ * Persisted queue of chat requests that have not been answered yet.
+ * A request stays queued from the moment the user finishes a turn until
+ * its response ends, so turns made while the phone is disconnected (or
+ * lost when the app closes) are sent once the connection is back.
+ */
+
+#define REQUEST_QUEUE_CAPACITY 4
+
+typedef struct {
+  uint32_t request_id;
+  uint32_t thread_id;
+} RequestQueueEntry;
+
+/**
+ * Add a request to the end of the queue (the oldest one is dropped when full).
+ * @param request_id Unique ID of the request (lets the phone skip duplicates)
+ * @param thread_id Thread the request belongs to
+ */
+void request_queue_push(uint32_t request_id, uint32_t thread_id);
+
+/**
+ * Get the oldest queued request.
+ * @return The entry, or NULL if the queue is empty
+ */
+const RequestQueueEntry* request_queue_peek(void);
+
+/**
+ * Remove the oldest queued request.
+ */
+void request_queue_pop(void);
+
+/**
+ * Remove all queued requests.
+ */
+void request_queue_clear(void);
+
+/**
+ * Get the number of queued requests.
+ * @return Number of entries
+ */
+int request_queue_get_count(void);
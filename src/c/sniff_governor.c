@@ -0,0 +1,79 @@
+#include "sniff_governor.h"
+
+// Longest wait for the next message of a transfer: the phone's timeout for a
+// streamed API response (STREAM_TIMEOUT in index.js) plus delivery to the
+// watch. Each message received restarts it.
+#define SNIFF_WATCHDOG_TIMEOUT 50000
+
+static AppTimer *s_watchdog_timer;
+static bool s_reduced = false;
+static uint32_t s_begin_ms;
+
+// Totals for this launch
+static uint32_t s_reduced_total_ms = 0;
+static int s_transfer_count = 0;
+
+// Private helper functions
+
+static uint32_t now_ms(void) {
+  time_t seconds;
+  uint16_t milliseconds;
+  time_ms(&seconds, &milliseconds);
+  return (uint32_t)seconds * 1000 + milliseconds;
+}
+
+static void restore_normal(bool completed) {
+  if (!s_reduced) {
+    return;
+  }
+
+  app_comm_set_sniff_interval(SNIFF_INTERVAL_NORMAL);
+  s_reduced = false;
+
+  uint32_t elapsed_ms = now_ms() - s_begin_ms;
+  s_reduced_total_ms += elapsed_ms;
+  s_transfer_count++;
+
+  if (completed) {
+    APP_LOG(APP_LOG_LEVEL_DEBUG, "Transfer took %d ms (reduced sniff for %d ms over %d transfers)",
+            (int)elapsed_ms, (int)s_reduced_total_ms, s_transfer_count);
+  } else {
+    APP_LOG(APP_LOG_LEVEL_WARNING, "Transfer not finished after %d ms, back to normal sniff", (int)elapsed_ms);
+  }
+}
+
+static void watchdog_callback(void *context) {
+  s_watchdog_timer = NULL;
+  restore_normal(false);
+}
+
+// Public API
+
+void sniff_governor_begin(void) {
+  if (!s_reduced) {
+    app_comm_set_sniff_interval(SNIFF_INTERVAL_REDUCED);
+    s_reduced = true;
+    s_begin_ms = now_ms();
+  }
+
+  if (s_watchdog_timer) {
+    app_timer_reschedule(s_watchdog_timer, SNIFF_WATCHDOG_TIMEOUT);
+  } else {
+    s_watchdog_timer = app_timer_register(SNIFF_WATCHDOG_TIMEOUT, watchdog_callback, NULL);
+  }
+}
+
+void sniff_governor_touch(void) {
+  if (s_watchdog_timer) {
+    app_timer_reschedule(s_watchdog_timer, SNIFF_WATCHDOG_TIMEOUT);
+  }
+}
+
+void sniff_governor_end(void) {
+  if (s_watchdog_timer) {
+    app_timer_cancel(s_watchdog_timer);
+    s_watchdog_timer = NULL;
+  }
+
+  restore_normal(true);
+}
@@ -0,0 +1,27 @@
+#pragma once
+#include <pebble.h>
+
+/**
+ * Sniff Governor
+ *
+ * Keeps the Bluetooth link in SNIFF_INTERVAL_REDUCED while a response is
+ * being transferred, so its messages arrive without the default sniff
+ * delay, and drops back to SNIFF_INTERVAL_NORMAL as soon as it is done.
+ * A watchdog restores the normal interval if no message of a transfer
+ * arrives for longer than the phone waits for the API. Transfer times and time spent in reduced mode are logged.
+ */
+
+/**
+ * Switch to the reduced sniff interval for a transfer (restarts the watchdog).
+ */
+void sniff_governor_begin(void);
+
+/**
+ * Note a message received during a transfer (restarts the watchdog).
+ */
+void sniff_governor_touch(void);
+
+/**
+ * End the transfer and switch back to the normal sniff interval.
+ */
+void sniff_governor_end(void);
@@ -0,0 +1,99 @@
+#include "text_pool.h"
+
+// Per slab: 0 if free, the run length at the first slab of a run, and
+// TEXT_POOL_CONTINUED for the other slabs of a run
+#define TEXT_POOL_CONTINUED 0xFF
+
+static char *s_pool;
+static uint8_t *s_slabs;
+static int s_slab_count = 0;
+
+// Private helper functions
+
+static int slab_of(const char *text) {
+  return (text - s_pool) / TEXT_POOL_SLAB_SIZE;
+}
+
+// Public API
+
+bool text_pool_init(size_t size) {
+  text_pool_deinit();
+
+  int slab_count = size / TEXT_POOL_SLAB_SIZE;
+  if (slab_count == 0) {
+    return false;
+  }
+
+  s_pool = malloc(slab_count * TEXT_POOL_SLAB_SIZE);
+  s_slabs = calloc(slab_count, sizeof(uint8_t));
+  if (!s_pool || !s_slabs) {
+    text_pool_deinit();
+    return false;
+  }
+
+  s_slab_count = slab_count;
+  return true;
+}
+
+void text_pool_deinit(void) {
+  free(s_pool);
+  free(s_slabs);
+  s_pool = NULL;
+  s_slabs = NULL;
+  s_slab_count = 0;
+}
+
+char* text_pool_alloc(size_t size) {
+  int needed = (size + TEXT_POOL_SLAB_SIZE - 1) / TEXT_POOL_SLAB_SIZE;
+  if (needed == 0 || needed >= TEXT_POOL_CONTINUED) {
+    return NULL;
+  }
+
+  // First fit: find a run of free slabs long enough
+  int run_start = 0;
+  for (int i = 0; i < s_slab_count; i++) {
+    if (s_slabs[i] != 0) {
+      run_start = i + 1;
+      continue;
+    }
+
+    if (i - run_start + 1 == needed) {
+      s_slabs[run_start] = needed;
+      memset(&s_slabs[run_start + 1], TEXT_POOL_CONTINUED, needed - 1);
+      return s_pool + run_start * TEXT_POOL_SLAB_SIZE;
+    }
+  }
+
+  return NULL;
+}
+
+void text_pool_free(char *text) {
+  if (!text || !s_pool) {
+    return;
+  }
+
+  int slab = slab_of(text);
+  memset(&s_slabs[slab], 0, s_slabs[slab]);
+}
+
+TextPoolStats text_pool_get_stats(void) {
+  TextPoolStats stats = {
+    .total_bytes = s_slab_count * TEXT_POOL_SLAB_SIZE,
+  };
+
+  int run = 0;
+  for (int i = 0; i < s_slab_count; i++) {
+    if (s_slabs[i] != 0) {
+      run = 0;
+      continue;
+    }
+
+    run++;
+    stats.free_bytes += TEXT_POOL_SLAB_SIZE;
+    if ((size_t)run * TEXT_POOL_SLAB_SIZE > stats.largest_free_bytes) {
+      stats.largest_free_bytes = run * TEXT_POOL_SLAB_SIZE;
+    }
+  }
+
+  return stats;
+}
@@ -0,0 +1,50 @@
+#pragma once
+#include <pebble.h>
+
+/**
+ * Text Pool
+ *
+ * Fixed pool for message text, allocated once when the chat window loads.
+ * The pool is divided into slabs of TEXT_POOL_SLAB_SIZE bytes and each
+ * text takes a run of consecutive slabs, so adding and evicting messages
+ * never touches the app heap and cannot fragment it.
+ */
+
+#define TEXT_POOL_SLAB_SIZE 32
+
+typedef struct {
+  size_t total_bytes;
+  size_t free_bytes;
+  size_t largest_free_bytes;
+} TextPoolStats;
+
+/**
+ * Allocate the pool.
+ * @param size Size of the pool in bytes (rounded down to whole slabs)
+ * @return true if the pool was allocated
+ */
+bool text_pool_init(size_t size);
+
+/**
+ * Free the pool (all texts allocated from it become invalid).
+ */
+void text_pool_deinit(void);
+
+/**
+ * Allocate space for a text.
+ * @param size Number of bytes needed (including the terminating NUL)
+ * @return Pointer to the space, or NULL if no run of free slabs is large enough
+ */
+char* text_pool_alloc(size_t size);
+
+/**
+ * Return a text's slabs to the pool.
+ * @param text Pointer returned by text_pool_alloc (NULL is ignored)
+ */
+void text_pool_free(char *text);
+
+/**
+ * Get usage and fragmentation statistics.
+ * @return Total, free, and largest contiguous free bytes
+ */
+TextPoolStats text_pool_get_stats(void);
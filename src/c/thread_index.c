@@ -0,0 +1,68 @@
+#include "thread_index.h"
+#include "persist_keys.h"
+
+static ThreadIndexEntry s_entries[THREAD_INDEX_CAPACITY];
+static int s_count = 0;
+static bool s_loaded = false;
+
+// Private helper functions
+
+static void ensure_loaded(void) {
+  if (s_loaded) {
+    return;
+  }
+  s_loaded = true;
+
+  int read = persist_read_data(PERSIST_KEY_THREAD_INDEX, s_entries, sizeof(s_entries));
+  s_count = read > 0 ? read / (int)sizeof(ThreadIndexEntry) : 0;
+}
+
+static void save(void) {
+  int result = persist_write_data(PERSIST_KEY_THREAD_INDEX, s_entries, s_count * sizeof(ThreadIndexEntry));
+  if (result < 0) {
+    APP_LOG(APP_LOG_LEVEL_ERROR, "Failed to write thread index: %d", result);
+  }
+}
+
+// Public API
+
+int thread_index_get_count(void) {
+  ensure_loaded();
+  return s_count;
+}
+
+const ThreadIndexEntry* thread_index_get(int index) {
+  ensure_loaded();
+  return (index >= 0 && index < s_count) ? &s_entries[index] : NULL;
+}
+
+void thread_index_update(uint32_t thread_id, const char *title, uint16_t message_count) {
+  ensure_loaded();
+
+  // Find the thread, or take the last slot (evicting the least recently used when full)
+  int position = 0;
+  while (position < s_count && s_entries[position].thread_id != thread_id) {
+    position++;
+  }
+
+  ThreadIndexEntry entry;
+  if (position < s_count) {
+    entry = s_entries[position];
+  } else {
+    entry = (ThreadIndexEntry) { .thread_id = thread_id };
+    snprintf(entry.title, sizeof(entry.title), "%s", title);
+    if (s_count < THREAD_INDEX_CAPACITY) {
+      s_count++;
+    }
+    position = s_count - 1;
+  }
+
+  entry.timestamp = time(NULL);
+  entry.message_count = message_count;
+
+  // Move to the front
+  memmove(&s_entries[1], &s_entries[0], position * sizeof(ThreadIndexEntry));
+  s_entries[0] = entry;
+
+  save();
+}
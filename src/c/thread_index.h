@@ -0,0 +1,44 @@
+#pragma once
+#include <pebble.h>
+
+/**
+ * Thread Index
+ *
+ * Small on-watch index of past conversations (threads). Each entry holds
+ * the thread's title, last activity time, message count and the ID under
+ * which the phone stores its transcript. The index fits in one persist
+ * record, is read lazily on first use, and keeps entries most recently
+ * used first, evicting the least recently used thread when full.
+ */
+
+#define THREAD_INDEX_TITLE_SIZE 24
+#define THREAD_INDEX_CAPACITY 7
+
+typedef struct {
+  uint32_t thread_id;
+  uint32_t timestamp;
+  uint16_t message_count;
+  char title[THREAD_INDEX_TITLE_SIZE];
+} __attribute__((packed)) ThreadIndexEntry;
+
+/**
+ * Get the number of threads in the index.
+ * @return Number of entries
+ */
+int thread_index_get_count(void);
+
+/**
+ * Get a thread from the index (most recently used first).
+ * @param index Position in the index (0 to count - 1)
+ * @return The entry, or NULL if out of range
+ */
+const ThreadIndexEntry* thread_index_get(int index);
+
+/**
+ * Record activity on a thread, adding it to the index if needed.
+ * The thread moves to the front; the least recently used one is evicted when full.
+ * @param thread_id ID of the thread
+ * @param title Title used when the thread is added (e.g. its first message)
+ * @param message_count Current number of messages in the thread
+ */
+void thread_index_update(uint32_t thread_id, const char *title, uint16_t message_count);
@@ -1,4 +1,540 @@
-// Parse encoded conversation string "[U]msg1[A]msg2..." into messages array
+// Logging: every line goes through Pebble's log forwarding, so lines above
+// LOG_LEVEL are dropped, debug lines are sampled, and payload dumps
+// (transcripts, request bodies, settings) are only formatted with LOG_PAYLOADS
+var LOG_ERROR = 0;
+var LOG_WARNING = 1;
+var LOG_INFO = 2;
+var LOG_DEBUG = 3;
+var LOG_LEVEL = LOG_INFO;
+var LOG_DEBUG_SAMPLE_EVERY = 10;
+var LOG_PAYLOADS = false;
+var debugLineCount = 0;
+
+function log(level, message) {
+  if (level > LOG_LEVEL) {
+    return;
+  }
+  if (level === LOG_DEBUG && debugLineCount++ % LOG_DEBUG_SAMPLE_EVERY !== 0) {
+    return;
+  }
+  console.log(message);
+}
+
+function logPayload(label, payload) {
+  if (!LOG_PAYLOADS) {
+    return;
+  }
+  console.log(label + ': ' + (typeof payload === 'string' ? payload : JSON.stringify(payload)));
+}
+
+// Capture of AppMessage traffic for reproducing timing-sensitive issues.
+// Each line is "<ms since launch>\t<event>\t<bytes>\t<payload JSON>", where
+// event is "#" (launch), "<" (from watch), ">" (to watch), "+" (acked) or "!" (nacked).
+var CAPTURE_STORAGE_KEY = 'capture_log';
+var CAPTURE_MAX_LENGTH = 32768;
+var captureStartTime = Date.now();
+
+function captureEvent(event, payload) {
+  if (!settings.captureEnabled) {
+    return;
+  }
+
+  var json = JSON.stringify(payload);
+  var line = (Date.now() - captureStartTime) + '\t' + event + '\t' + json.length + '\t' + json + '\n';
+  var captured = (localStorage.getItem(CAPTURE_STORAGE_KEY) || '') + line;
+
+  // Drop the oldest lines once the log outgrows its budget
+  if (captured.length > CAPTURE_MAX_LENGTH) {
+    captured = captured.substring(captured.indexOf('\n', captured.length - CAPTURE_MAX_LENGTH) + 1);
+  }
+
+  localStorage.setItem(CAPTURE_STORAGE_KEY, captured);
+}
+
+// Print the captured traffic so it can be extracted with `pebble logs | grep CAPTURE`
+function dumpCapture() {
+  var captured = localStorage.getItem(CAPTURE_STORAGE_KEY);
+  if (!captured) {
+    return;
+  }
+
+  captured.split('\n').forEach(function (line) {
+    if (line) {
+      console.log('CAPTURE\t' + line);
+    }
+  });
+  localStorage.removeItem(CAPTURE_STORAGE_KEY);
+}
+
+// Messages to the watch are sent one at a time, each after the previous one
+// was acked (or nacked), so chunks of a response arrive in order
+var outbox = [];
+var outboxBusy = false;
+
+function flushOutbox() {
+  if (outboxBusy || outbox.length === 0) {
+    return;
+  }
+
+  var entry = outbox.shift();
+  var dict = entry.dict;
+  outboxBusy = true;
+  captureEvent('>', dict);
+  Pebble.sendAppMessage(dict, function () {
+    captureEvent('+', dict);
+    outboxBusy = false;
+    if (entry.done) {
+      entry.done(true);
+    }
+    flushOutbox();
+  }, function () {
+    captureEvent('!', dict);
+    outboxBusy = false;
+    if (entry.done) {
+      entry.done(false);
+    }
+    flushOutbox();
+  });
+}
+
+// Send a message to the watch, recording it (and its delivery) when capture is on.
+// The optional done callback gets whether the watch acked the message.
+function sendMessage(dict, done) {
+  outbox.push({ dict: dict, done: done });
+  flushOutbox();
+}
+
+// Size of the watch's AppMessage inbox, reported with every request (watches
+// with the low-memory profile have a small one); text is split to fit
+var watchInboxSize = 4096;
+var TUPLE_OVERHEAD = 64;
+
+function isLowSurrogate(code) {
+  return code >= 0xDC00 && code <= 0xDFFF;
+}
+
+// Bytes text takes in UTF-8 (a lone surrogate counts as U+FFFD)
+function utf8Length(text) {
+  var length = 0;
+  for (var i = 0; i < text.length; i++) {
+    var code = text.charCodeAt(i);
+    if (code < 0x80) {
+      length += 1;
+    } else if (code < 0x800) {
+      length += 2;
+    } else if (code >= 0xD800 && code <= 0xDBFF && isLowSurrogate(text.charCodeAt(i + 1))) {
+      length += 4;
+      i++;
+    } else {
+      length += 3;
+    }
+  }
+  return length;
+}
+
+// Split text into chunks of at most maxBytes UTF-8 bytes
+function splitText(text, maxBytes) {
+  var chunks = [];
+  var chunk = '';
+  var bytes = 0;
+
+  for (var i = 0; i < text.length; i++) {
+    var character = text.charAt(i);
+    var code = text.charCodeAt(i);
+    if (code >= 0xD800 && code <= 0xDBFF && i + 1 < text.length) {
+      // Keep surrogate pairs together
+      character += text.charAt(++i);
+    }
+
+    var size = utf8Length(character);
+    if (bytes + size > maxBytes && chunk) {
+      chunks.push(chunk);
+      chunk = '';
+      bytes = 0;
+    }
+    chunk += character;
+    bytes += size;
+  }
+
+  if (chunk) {
+    chunks.push(chunk);
+  }
+  return chunks;
+}
+
+// Send response text in as many RESPONSE_TEXT chunks as the watch inbox needs
+function sendResponseText(text, suggestions) {
+  var maxBytes = watchInboxSize - TUPLE_OVERHEAD;
+  var chunks = splitText(text, maxBytes);
+
+  for (var i = 0; i < chunks.length; i++) {
+    var dict = { 'RESPONSE_TEXT': chunks[i] };
+    if (i === chunks.length - 1 && suggestions && utf8Length(chunks[i]) + utf8Length(suggestions) <= maxBytes) {
+      dict.SUGGESTIONS = suggestions;
+      suggestions = null;
+    }
+    sendMessage(dict);
+  }
+
+  if (suggestions) {
+    sendMessage({ 'SUGGESTIONS': suggestions });
+  }
+}
+
+// Conversation threads: full transcripts are kept on the phone so the watch
+// only has to hold an index. Evicted least recently used past a storage budget.
+var THREAD_STORAGE_BUDGET = 65536;
+var THREAD_DATA_MAX_BYTES = 3800;
+
+function loadThreadIndex() {
+  try {
+    return JSON.parse(localStorage.getItem('thread_index')) || {};
+  } catch (e) {
+    return {};
+  }
+}
+
+function saveThread(threadId, messages) {
+  var index = loadThreadIndex();
+  var transcript = JSON.stringify(messages);
+
+  localStorage.setItem('thread_' + threadId, transcript);
+  index[threadId] = { used: Date.now(), size: transcript.length };
+  if (activeThread && activeThread.id === threadId) {
+    activeThread.messages = messages;
+  }
+
+  // Evict the least recently used threads until we are within budget
+  var ids = Object.keys(index).sort(function (a, b) {
+    return index[a].used - index[b].used;
+  });
+  var total = ids.reduce(function (sum, id) {
+    return sum + index[id].size;
+  }, 0);
+
+  while (total > THREAD_STORAGE_BUDGET && ids.length > 1) {
+    var oldest = ids.shift();
+    total -= index[oldest].size;
+    localStorage.removeItem('thread_' + oldest);
+    delete index[oldest];
+    if (activeThread && String(activeThread.id) === oldest) {
+      activeThread = null;
+    }
+    log(LOG_INFO, 'Evicted thread ' + oldest);
+  }
+
+  localStorage.setItem('thread_index', JSON.stringify(index));
+}
+
+function loadThread(threadId) {
+  var index = loadThreadIndex();
+  var transcript = localStorage.getItem('thread_' + threadId);
+  if (!index[threadId] || !transcript) {
+    return null;
+  }
+
+  index[threadId].used = Date.now();
+  localStorage.setItem('thread_index', JSON.stringify(index));
+  return JSON.parse(transcript);
+}
+
+// The thread being talked in, held in memory like the settings so a request
+// does not read its transcript and summary from storage: { id, messages, summary }
+var activeThread = null;
+
+function loadActiveThread(threadId) {
+  if (!activeThread || activeThread.id !== threadId) {
+    activeThread = { id: threadId, messages: loadThread(threadId), summary: loadSummary(threadId) };
+  }
+  return activeThread;
+}
+
+function sameMessage(a, b) {
+  return a.role === b.role && a.content === b.content;
+}
+
+// Extend a stored transcript with the newest messages from the watch. The
+// watch only sends what fits in one AppMessage, so its messages overlap the
+// end of the stored transcript; if they do not, null is returned and the
+// caller starts the thread over (see resetThread).
+function mergeThread(stored, messages) {
+  if (!stored) {
+    return messages;
+  }
+
+  for (var overlap = Math.min(stored.length, messages.length); overlap > 0; overlap--) {
+    var matches = true;
+    for (var i = 0; i < overlap && matches; i++) {
+      matches = sameMessage(stored[stored.length - overlap + i], messages[i]);
+    }
+    if (matches) {
+      return stored.concat(messages.slice(overlap));
+    }
+  }
+
+  log(LOG_WARNING, 'Thread does not match the conversation from the watch');
+  return null;
+}
+
+// Start a thread over from the watch's messages. Its summary goes with the
+// old transcript: the message it was folded up to is no longer there.
+function resetThread(thread) {
+  thread.summary = null;
+  localStorage.removeItem('summary_' + thread.id);
+}
+
+// Conversations are exchanged with the watch as byte arrays (see
+// conversation_codec.h): version, flags and an optional request ID, then per
+// message a role byte, a varint length and the UTF-8 text
+var CONVERSATION_VERSION = 1;
+var CONVERSATION_FLAG_REQUEST_ID = 0x01;
+var ROLE_USER = 0;
+var ROLE_ASSISTANT = 1;
+
+// Append the UTF-8 bytes of text to an array (a lone surrogate becomes U+FFFD)
+function pushUtf8(bytes, text) {
+  for (var i = 0; i < text.length; i++) {
+    var code = text.charCodeAt(i);
+    if (code < 0x80) {
+      bytes.push(code);
+    } else if (code < 0x800) {
+      bytes.push(0xC0 | (code >> 6), 0x80 | (code & 0x3F));
+    } else {
+      if (code >= 0xD800 && code <= 0xDBFF && isLowSurrogate(text.charCodeAt(i + 1))) {
+        code = 0x10000 + ((code - 0xD800) << 10) + (text.charCodeAt(++i) - 0xDC00);
+        bytes.push(0xF0 | (code >> 18), 0x80 | ((code >> 12) & 0x3F));
+      } else {
+        if (code >= 0xD800 && code <= 0xDFFF) {
+          code = 0xFFFD;
+        }
+        bytes.push(0xE0 | (code >> 12));
+      }
+      bytes.push(0x80 | ((code >> 6) & 0x3F), 0x80 | (code & 0x3F));
+    }
+  }
+}
+
+// Write the UTF-8 bytes[start..end) to units from index count on, as UTF-16
+// code units, and return the new count. Invalid sequences (e.g. cut
+// mid-character) become U+FFFD.
+function writeUtf16(units, count, bytes, start, end) {
+  var i = start;
+  while (i < end) {
+    var code = bytes[i++];
+    if (code < 0x80) {
+      units[count++] = code;
+      continue;
+    }
+
+    var extra = 0;
+    var min = 0;
+    if (code >= 0xC2 && code <= 0xDF) {
+      code &= 0x1F;
+      extra = 1;
+      min = 0x80;
+    } else if (code >= 0xE0 && code <= 0xEF) {
+      code &= 0x0F;
+      extra = 2;
+      min = 0x800;
+    } else if (code >= 0xF0 && code <= 0xF4) {
+      code &= 0x07;
+      extra = 3;
+      min = 0x10000;
+    } else {
+      code = 0xFFFD;
+    }
+
+    for (; extra > 0; extra--) {
+      if (i >= end || (bytes[i] & 0xC0) !== 0x80) {
+        break;
+      }
+      code = (code << 6) | (bytes[i++] & 0x3F);
+    }
+    if (extra > 0 || code < min || code > 0x10FFFF || (code >= 0xD800 && code <= 0xDFFF)) {
+      code = 0xFFFD;
+    }
+
+    if (code >= 0x10000) {
+      code -= 0x10000;
+      units[count++] = 0xD800 + (code >> 10);
+      units[count++] = 0xDC00 + (code & 0x3FF);
+    } else {
+      units[count++] = code;
+    }
+  }
+  return count;
+}
+
+// Make a string of UTF-16 code units (in slices, so long texts stay within
+// the engine's argument limit)
+function unitsText(units) {
+  if (units.length <= 4096) {
+    return String.fromCharCode.apply(null, units);
+  }
+  var text = '';
+  for (var offset = 0; offset < units.length; offset += 4096) {
+    text += String.fromCharCode.apply(null, units.slice(offset, offset + 4096));
+  }
+  return text;
+}
+
+function encodeVarint(value) {
+  var bytes = [];
+  while (value >= 0x80) {
+    bytes.push((value & 0x7F) | 0x80);
+    value = Math.floor(value / 128);
+  }
+  bytes.push(value);
+  return bytes;
+}
+
+// Encode the newest messages that fit in maxBytes
+function encodeConversation(messages, requestId, maxBytes) {
+  var bytes = [CONVERSATION_VERSION, requestId ? CONVERSATION_FLAG_REQUEST_ID : 0];
+  if (requestId) {
+    bytes.push(requestId & 0xFF, (requestId >>> 8) & 0xFF, (requestId >>> 16) & 0xFF, (requestId >>> 24) & 0xFF);
+  }
+
+  // Find the oldest message that still fits, then write them in order
+  var lengths = [];
+  var size = bytes.length;
+  var first = messages.length;
+  while (first > 0) {
+    var length = utf8Length(messages[first - 1].content);
+    var partSize = 1 + encodeVarint(length).length + length;
+    if (size + partSize > maxBytes) {
+      break;
+    }
+    size += partSize;
+    lengths[--first] = length;
+  }
+
+  for (var i = first; i < messages.length; i++) {
+    bytes.push(messages[i].role === 'user' ? ROLE_USER : ROLE_ASSISTANT);
+    bytes.push.apply(bytes, encodeVarint(lengths[i]));
+    pushUtf8(bytes, messages[i].content);
+  }
+  return bytes;
+}
+
+// Decode a conversation from the watch, or null if its version is unknown
+function decodeConversation(bytes) {
+  if (bytes.length < 2 || bytes[0] !== CONVERSATION_VERSION) {
+    return null;
+  }
+
+  var offset = 2;
+  var requestId = 0;
+  if (bytes[1] & CONVERSATION_FLAG_REQUEST_ID) {
+    if (bytes.length < 6) {
+      return null;
+    }
+    requestId = (bytes[2] | (bytes[3] << 8) | (bytes[4] << 16) | (bytes[5] << 24)) >>> 0;
+    offset += 4;
+  }
+
+  // The texts are decoded into one run of code units (never more than there
+  // are bytes), then cut into messages
+  var roles = [];
+  var ends = [];
+  var units = new Array(bytes.length);
+  var count = 0;
+  while (offset < bytes.length) {
+    var role = bytes[offset++] === ROLE_USER ? 'user' : 'assistant';
+
+    var length = 0;
+    var scale = 1;
+    var byte;
+    do {
+      byte = bytes[offset++];
+      length += (byte & 0x7F) * scale;
+      scale *= 128;
+    } while (byte & 0x80 && offset < bytes.length);
+
+    if (byte & 0x80 || offset + length > bytes.length) {
+      log(LOG_WARNING, 'Truncated conversation at byte ' + offset);
+      break;
+    }
+    count = writeUtf16(units, count, bytes, offset, offset + length);
+    roles.push(role);
+    ends.push(count);
+    offset += length;
+  }
+
+  units.length = count;
+  var text = unitsText(units);
+  var messages = [];
+  for (var i = 0; i < roles.length; i++) {
+    messages.push({ role: roles[i], content: text.substring(i ? ends[i - 1] : 0, ends[i]) });
+  }
+  return { requestId: requestId, messages: messages };
+}
+
+// Encode the newest messages of a thread that fit in one AppMessage
+function encodeThread(messages) {
+  return encodeConversation(messages, 0, Math.min(THREAD_DATA_MAX_BYTES, watchInboxSize - TUPLE_OVERHEAD));
+}
+
+// Send a thread to the watch when it is opened from the history
+function sendThread(threadId) {
+  // Requests for the thread follow, so it becomes the active one
+  var messages = loadActiveThread(threadId).messages;
+  if (!messages) {
+    log(LOG_WARNING, 'Thread ' + threadId + ' not found');
+    sendMessage({ 'RESPONSE_END': 1 });
+    return;
+  }
+
+  sendMessage({
+    'THREAD_ID': threadId,
+    'THREAD_DATA': encodeThread(messages),
+    'RESPONSE_END': 1
+  });
+}
+
+// Requests are identified by the watch so a request retried after a
+// disconnect is not sent to the API twice
+var ANSWERED_REQUESTS_LIMIT = 5;
+var requestsInFlight = {};
+var answeredRequests = null;
+
+// Read from storage once, then kept in memory (storage keeps it for a retry
+// after the phone restarted the app)
+function getAnsweredRequests() {
+  if (!answeredRequests) {
+    try {
+      answeredRequests = JSON.parse(localStorage.getItem('answered_requests')) || [];
+    } catch (e) {
+      answeredRequests = [];
+    }
+  }
+  return answeredRequests;
+}
+
+function rememberAnswer(requestId, responseText) {
+  var answered = getAnsweredRequests();
+  answered.push({ id: requestId, text: responseText });
+  answeredRequests = answered.slice(-ANSWERED_REQUESTS_LIMIT);
+  localStorage.setItem('answered_requests', JSON.stringify(answeredRequests));
+}
+
+function findAnswer(requestId) {
+  var answered = getAnsweredRequests();
+  for (var i = 0; i < answered.length; i++) {
+    if (answered[i].id === requestId) {
+      return answered[i].text;
+    }
+  }
+  return null;
+}
+
+// Tell the watch the response is complete
+function endResponse(requestId, done) {
+  delete requestsInFlight[requestId];
+  sendMessage({ 'RESPONSE_END': 1 }, done);
+}
+
+// Parse the text framing of older watch apps ("[U]msg1[A]msg2...") into a messages array
 function parseConversation(encoded) {
   var messages = [];
   var parts = encoded.split(/(\[U\]|\[A\])/);
@@ -21,38 +557,578 @@ function parseConversation(encoded) {
   return messages;
 }
 
-// Get response from Claude API
-function getClaudeResponse(messages) {
-  var apiKey = localStorage.getItem('api_key');
-  var baseUrl = localStorage.getItem('base_url') || 'https://api.anthropic.com/v1/messages';
-  var model = localStorage.getItem('model') || 'claude-haiku-4-5';
-  var systemMessage = localStorage.getItem('system_message') || "You're running on a Pebble smartwatch. Please respond in plain text without any formatting, keeping your responses within 1-3 sentences.";
+// Rolling summary: once the phone's transcript of a thread grows past a token
+// threshold, older turns are folded into a cached summary (made by a cheap
+// model between turns) so the request size stays flat however long the chat
+// runs. The watch sends at most one outbox of history (a 4 KB outbox holds
+// about 1000 tokens), so the threshold is checked against the full
+// transcript kept on the phone (see mergeThread).
+var SUMMARY_THRESHOLD_TOKENS = 1500;
+var SUMMARY_KEEP_MESSAGES = 4;
+var SUMMARY_MODEL = 'claude-haiku-4-5';
+
+// Rough token estimate (about 4 characters per token)
+function estimateTokens(messages) {
+  var characters = 0;
+  for (var i = 0; i < messages.length; i++) {
+    characters += messages[i].content.length;
+  }
+  return Math.ceil(characters / 4);
+}
+
+function loadSummary(threadId) {
+  try {
+    return JSON.parse(localStorage.getItem('summary_' + threadId));
+  } catch (e) {
+    return null;
+  }
+}
+
+// Drop the messages covered by the summary. The summary records the last
+// message it folded in; if the transcript does not have that message, the
+// summary is not of this transcript and null is returned.
+function applySummary(messages, summary) {
+  if (!summary) {
+    return messages;
+  }
+
+  for (var i = messages.length - 1; i >= 0; i--) {
+    if (sameMessage(messages[i], { role: summary.lastRole, content: summary.lastContent })) {
+      return messages.slice(i + 1);
+    }
+  }
+  return null;
+}
+
+// Fold older turns of a thread's full transcript into the summary in the
+// background (after a turn finished)
+function compactConversation(threadId, messages, apiKey, baseUrl) {
+  var summary = loadActiveThread(threadId).summary;
+  var pending = applySummary(messages, summary);
+  if (!pending) {
+    summary = null;
+    pending = messages;
+  }
+  if (estimateTokens(pending) < SUMMARY_THRESHOLD_TOKENS) {
+    return;
+  }
+
+  // Keep the newest turns verbatim, starting with a user message
+  var split = pending.length - SUMMARY_KEEP_MESSAGES;
+  while (split > 0 && pending[split].role !== 'user') {
+    split--;
+  }
+  if (split <= 0) {
+    return;
+  }
+
+  var folded = pending.slice(0, split);
+  var transcript = folded.map(function (message) {
+    return (message.role === 'user' ? 'User: ' : 'Assistant: ') + message.content;
+  }).join('\n');
+
+  var prompt = 'Summarize this conversation in a few sentences, keeping every fact needed to continue it.\n\n';
+  if (summary) {
+    prompt += 'Summary of the conversation before this part: ' + summary.text + '\n\n';
+  }
+  prompt += transcript;
+
+  var xhr = new XMLHttpRequest();
+  xhr.open('POST', baseUrl, true);
+  xhr.setRequestHeader('Content-Type', 'application/json');
+  xhr.setRequestHeader('x-api-key', apiKey);
+  xhr.setRequestHeader('anthropic-version', '2023-06-01');
+  xhr.timeout = 15000;
+
+  xhr.onload = function () {
+    if (xhr.status !== 200) {
+      log(LOG_WARNING, 'Summary failed: ' + xhr.status);
+      return;
+    }
+
+    try {
+      var data = JSON.parse(xhr.responseText);
+      var text = data.content && data.content[0] && data.content[0].text;
+      if (text) {
+        var last = folded[folded.length - 1];
+        var newSummary = { text: text.trim(), lastRole: last.role, lastContent: last.content };
+        localStorage.setItem('summary_' + threadId, JSON.stringify(newSummary));
+        if (activeThread && activeThread.id === threadId) {
+          activeThread.summary = newSummary;
+        }
+        log(LOG_INFO, 'Summarized ' + folded.length + ' messages of thread ' + threadId);
+      }
+    } catch (e) {
+      log(LOG_ERROR, 'Error parsing summary: ' + e);
+    }
+  };
+
+  xhr.send(JSON.stringify({
+    model: SUMMARY_MODEL,
+    max_tokens: 256,
+    messages: [{ role: 'user', content: prompt }]
+  }));
+}
+
+// Follow-up suggestions: the model ends its answer with a "Suggestions:" line,
+// which is stripped from the text and sent to the watch as a separate tuple
+var SUGGESTIONS_INSTRUCTION = 'End your answer with a final line starting with "Suggestions:" followed by 2-3 short follow-up questions the user might ask next (at most 5 words each), separated by " | ".';
+var SUGGESTIONS_PATTERN = /\n?[ \t]*Suggestions:[ \t]*([^\n]*)\s*$/i;
+var SUGGESTIONS_MAX = 3;
+var SUGGESTION_MAX_LENGTH = 32;
+
+// Split a response into its text and suggestions (newline-separated)
+function extractSuggestions(responseText) {
+  var match = responseText.match(SUGGESTIONS_PATTERN);
+  if (!match) {
+    return { text: responseText, suggestions: '' };
+  }
+
+  var suggestions = match[1].split('|').map(function (suggestion) {
+    return suggestion.trim().substring(0, SUGGESTION_MAX_LENGTH);
+  }).filter(function (suggestion) {
+    return suggestion.length > 0;
+  }).slice(0, SUGGESTIONS_MAX);
+
+  return {
+    text: responseText.substring(0, match.index).trim(),
+    suggestions: suggestions.join('\n')
+  };
+}
+
+// Latency histograms: per model, request times are counted in log-spaced
+// buckets with a decay so recent requests dominate (kept in localStorage)
+var LATENCY_BUCKETS_MS = [250, 500, 1000, 2000, 4000, 8000, 16000];
+var LATENCY_DECAY = 0.95;
+
+function loadLatencyStats() {
+  try {
+    return JSON.parse(localStorage.getItem('latency_stats')) || {};
+  } catch (e) {
+    return {};
+  }
+}
+
+// Index of the bucket counting a value (the last bucket counts everything larger)
+function bucketIndex(buckets, value) {
+  var bucket = 0;
+  while (bucket < buckets.length && value > buckets[bucket]) {
+    bucket++;
+  }
+  return bucket;
+}
+
+function recordLatency(model, milliseconds) {
+  var stats = loadLatencyStats();
+  var counts = stats[model] || [];
+
+  for (var i = 0; i <= LATENCY_BUCKETS_MS.length; i++) {
+    counts[i] = (counts[i] || 0) * LATENCY_DECAY;
+  }
+  counts[bucketIndex(LATENCY_BUCKETS_MS, milliseconds)] += 1;
+
+  stats[model] = counts;
+  localStorage.setItem('latency_stats', JSON.stringify(stats));
+}
+
+// Upper bound of the bucket holding the given percentile (null without data)
+function latencyPercentile(model, percentile) {
+  var counts = loadLatencyStats()[model];
+  if (!counts) {
+    return null;
+  }
+
+  var total = counts.reduce(function (sum, count) {
+    return sum + count;
+  }, 0);
+  var cumulative = 0;
+  for (var i = 0; i < counts.length; i++) {
+    cumulative += counts[i];
+    if (cumulative >= total * percentile) {
+      return i < LATENCY_BUCKETS_MS.length ? LATENCY_BUCKETS_MS[i] : Infinity;
+    }
+  }
+  return null;
+}
+
+// Web search progress: with web search on, responses are streamed as
+// server-sent events so tool events can be shown on the watch (STATUS_TEXT,
+// in the chat footer) as they arrive. The events are rebuilt into the content
+// blocks of a regular response once it is complete.
+var STATUS_MAX_LENGTH = 40;
+
+// Plain requests time out after 5 s. A streamed response takes the searches
+// too, so it is given longer
+var STREAM_TIMEOUT = 45000;
+
+function sendStatus(status) {
+  sendMessage({ 'STATUS_TEXT': status.length > STATUS_MAX_LENGTH ? status.substring(0, STATUS_MAX_LENGTH - 3) + '...' : status });
+}
+
+function createStream() {
+  return { offset: 0, content: [], inputs: {}, error: null };
+}
+
+// Handle the complete events received since the last call
+function readStream(stream, responseText) {
+  var end = responseText.lastIndexOf('\n');
+  if (end < stream.offset) {
+    return;
+  }
+
+  var lines = responseText.substring(stream.offset, end).split('\n');
+  stream.offset = end + 1;
+
+  lines.forEach(function (line) {
+    if (line.indexOf('data:') !== 0) {
+      return;
+    }
+
+    var event;
+    try {
+      event = JSON.parse(line.substring(5));
+    } catch (e) {
+      log(LOG_WARNING, 'Invalid stream event: ' + e);
+      return;
+    }
+
+    if (event.type === 'content_block_start') {
+      var block = event.content_block;
+      stream.content[event.index] = block;
+      if (block.type === 'server_tool_use') {
+        stream.inputs[event.index] = '';
+      } else if (block.type === 'web_search_tool_result' && Array.isArray(block.content)) {
+        sendStatus('Reading ' + block.content.length + ' results');
+      }
+    } else if (event.type === 'content_block_delta') {
+      if (event.delta.type === 'text_delta') {
+        stream.content[event.index].text = (stream.content[event.index].text || '') + event.delta.text;
+      } else if (event.delta.type === 'input_json_delta' && event.index in stream.inputs) {
+        stream.inputs[event.index] += event.delta.partial_json;
+      }
+    } else if (event.type === 'content_block_stop' && event.index in stream.inputs) {
+      // The tool input (with the search query) is complete
+      try {
+        var input = JSON.parse(stream.inputs[event.index] || '{}');
+        sendStatus(input.query ? 'Searching: ' + input.query : 'Searching the web');
+      } catch (e) {
+        sendStatus('Searching the web');
+      }
+      delete stream.inputs[event.index];
+    } else if (event.type === 'error') {
+      stream.error = event.error;
+    }
+  });
+}
+
+// Performance statistics for the configuration page: per model and endpoint,
+// histograms of time to first byte, API time, Bluetooth transfer time and
+// response size, plus request, error, timeout and response cache counts.
+// Samples fade with a half-life of a few days, so the page shows roughly the
+// last week of use.
+var PERF_STORAGE_KEY = 'perf_stats';
+var PERF_HALF_LIFE_MS = 3 * 24 * 60 * 60 * 1000;
+var PERF_MAX_ENTRIES = 8;
+var PERF_COUNTERS = ['requests', 'errors', 'timeouts', 'cacheHits', 'cacheMisses'];
+var PERF_HISTOGRAMS = { ttfb: LATENCY_BUCKETS_MS, total: LATENCY_BUCKETS_MS, transfer: LATENCY_BUCKETS_MS, bytes: [256, 512, 1024, 2048, 4096, 8192] };
+var perfStats = null;
+
+function loadPerfStats() {
+  if (!perfStats) {
+    try {
+      perfStats = JSON.parse(localStorage.getItem(PERF_STORAGE_KEY)) || {};
+    } catch (e) {
+      perfStats = {};
+    }
+  }
+  return perfStats;
+}
+
+function perfKey(model, baseUrl) {
+  return model + ' @ ' + baseUrl.replace(/^[a-z]+:\/\//i, '').split('/')[0];
+}
+
+// Add a sample: counters are incremented for true fields, histograms counted
+// for numeric fields (e.g. { requests: true, ttfb: 420, total: 1300, bytes: 800 })
+function recordPerf(key, sample) {
+  var stats = loadPerfStats();
+  var entry = stats[key] || { updated: Date.now() };
+  var decay = Math.pow(0.5, (Date.now() - entry.updated) / PERF_HALF_LIFE_MS);
+  var round = function (count) {
+    return Math.round(count * decay * 1000) / 1000;
+  };
+
+  PERF_COUNTERS.forEach(function (name) {
+    entry[name] = round(entry[name] || 0) + (sample[name] ? 1 : 0);
+  });
+  Object.keys(PERF_HISTOGRAMS).forEach(function (name) {
+    var counts = entry[name] || [];
+    for (var i = 0; i <= PERF_HISTOGRAMS[name].length; i++) {
+      counts[i] = round(counts[i] || 0);
+    }
+    if (typeof sample[name] === 'number') {
+      counts[bucketIndex(PERF_HISTOGRAMS[name], sample[name])] += 1;
+    }
+    entry[name] = counts;
+  });
+  entry.updated = Date.now();
+  stats[key] = entry;
+
+  // Keep the most recently used models and endpoints
+  var keys = Object.keys(stats).sort(function (a, b) {
+    return stats[b].updated - stats[a].updated;
+  });
+  keys.slice(PERF_MAX_ENTRIES).forEach(function (oldKey) {
+    delete stats[oldKey];
+  });
+
+  localStorage.setItem(PERF_STORAGE_KEY, JSON.stringify(stats));
+}
+
+function resetPerfStats() {
+  perfStats = {};
+  localStorage.removeItem(PERF_STORAGE_KEY);
+  localStorage.removeItem('latency_stats');
+}
+
+// Automatic model routing ("auto" model setting): a fast model for short
+// conversational turns, a stronger one for long or research-style queries,
+// falling back to the fast model when the strong one is over the latency budget
+var FAST_MODEL = 'claude-haiku-4-5';
+var STRONG_MODEL = 'claude-sonnet-4-5';
+var LONG_PROMPT_LENGTH = 200;
+var STRONG_KEYWORDS = /\b(explain|why|compare|analy[sz]e|write|plan|code|calculate|latest|news|today|search)\b/i;
+
+function routeModel(messages, webSearchEnabled, latencyBudget) {
+  var prompt = messages.length > 0 ? messages[messages.length - 1].content : '';
+  var model = (webSearchEnabled || prompt.length > LONG_PROMPT_LENGTH || STRONG_KEYWORDS.test(prompt)) ?
+    STRONG_MODEL : FAST_MODEL;
+
+  if (model === STRONG_MODEL && latencyBudget > 0) {
+    var p95 = latencyPercentile(STRONG_MODEL, 0.95);
+    if (p95 !== null && p95 > latencyBudget) {
+      log(LOG_INFO, 'Routing to ' + FAST_MODEL + ': ' + STRONG_MODEL + ' p95 ' + p95 + 'ms over budget');
+      model = FAST_MODEL;
+    }
+  }
+
+  log(LOG_DEBUG, 'Routed to ' + model);
+  return model;
+}
+
+// Settings are read from localStorage at launch and again only when the
+// configuration page closes, so the request path never goes to storage
+var SETTINGS_KEYS = ['api_key', 'base_url', 'model', 'system_message', 'web_search_enabled', 'capture_enabled', 'latency_budget_ms', 'skip_dictation_confirmation', 'response_cache_enabled'];
+var DEFAULT_BASE_URL = 'https://api.anthropic.com/v1/messages';
+var DEFAULT_MODEL = 'claude-haiku-4-5';
+var DEFAULT_SYSTEM_MESSAGE = "You're running on a Pebble smartwatch. Please respond in plain text without any formatting, keeping your responses within 1-3 sentences.";
+var WEB_SEARCH_TOOLS = [{
+  type: 'web_search_20250305',
+  name: 'web_search',
+  max_uses: 5
+}];
+
+function loadSettings() {
+  var systemMessage = localStorage.getItem('system_message') || DEFAULT_SYSTEM_MESSAGE;
   var webSearchEnabled = localStorage.getItem('web_search_enabled') === 'true';
 
+  return {
+    apiKey: localStorage.getItem('api_key'),
+    baseUrl: localStorage.getItem('base_url') || DEFAULT_BASE_URL,
+    model: localStorage.getItem('model') || DEFAULT_MODEL,
+    systemMessage: systemMessage,
+    webSearchEnabled: webSearchEnabled,
+    captureEnabled: localStorage.getItem('capture_enabled') === 'true',
+    latencyBudget: parseInt(localStorage.getItem('latency_budget_ms'), 10) || 0,
+    skipDictationConfirmation: localStorage.getItem('skip_dictation_confirmation') === 'true',
+    responseCacheEnabled: localStorage.getItem('response_cache_enabled') === 'true',
+
+    // Parts of the request body that only change with the settings, serialized once
+    systemJson: JSON.stringify(systemMessage + '\n\n' + SUGGESTIONS_INSTRUCTION),
+    toolsJson: webSearchEnabled ? JSON.stringify(WEB_SEARCH_TOOLS) : null
+  };
+}
+
+var settings = loadSettings();
+
+// Response cache (opt-in): answers to standalone questions (a single turn
+// without web search) are reused for a day, keyed by a hash of the model,
+// the system prompt and the normalized question. The least recently used
+// answers are evicted past a storage budget.
+var RESPONSE_CACHE_KEY = 'response_cache';
+var RESPONSE_CACHE_TTL_MS = 24 * 60 * 60 * 1000;
+var RESPONSE_CACHE_BUDGET = 16384;
+var responseCache = null;
+
+function loadResponseCache() {
+  if (!responseCache) {
+    try {
+      responseCache = JSON.parse(localStorage.getItem(RESPONSE_CACHE_KEY)) || {};
+    } catch (e) {
+      responseCache = {};
+    }
+  }
+  return responseCache;
+}
+
+// 32-bit FNV-1a hash of a string, in hex
+function hashString(text) {
+  var hash = 0x811c9dc5;
+  for (var i = 0; i < text.length; i++) {
+    hash ^= text.charCodeAt(i);
+    hash = (hash + (hash << 1) + (hash << 4) + (hash << 7) + (hash << 8) + (hash << 24)) >>> 0;
+  }
+  return hash.toString(16);
+}
+
+// Question as cached: case, spacing and trailing punctuation do not matter
+function normalizePrompt(prompt) {
+  return prompt.trim().toLowerCase().replace(/\s+/g, ' ').replace(/[\s?!.]+$/, '');
+}
+
+// Cache lookup for a request, or null if the request cannot be cached
+function responseCacheLookup(model, messages) {
+  if (!settings.responseCacheEnabled || settings.webSearchEnabled || messages.length !== 1) {
+    return null;
+  }
+
+  var prompt = normalizePrompt(messages[0].content);
+  return {
+    key: hashString(model + '\n' + settings.systemMessage + '\n' + prompt),
+    prompt: prompt
+  };
+}
+
+function findCachedResponse(lookup) {
+  var entry = loadResponseCache()[lookup.key];
+  if (!entry || entry.prompt !== lookup.prompt || Date.now() - entry.created > RESPONSE_CACHE_TTL_MS) {
+    return null;
+  }
+
+  entry.used = Date.now();
+  localStorage.setItem(RESPONSE_CACHE_KEY, JSON.stringify(responseCache));
+  return entry;
+}
+
+function storeCachedResponse(lookup, text, suggestions) {
+  var cache = loadResponseCache();
+  var now = Date.now();
+  cache[lookup.key] = { prompt: lookup.prompt, text: text, suggestions: suggestions, created: now, used: now };
+
+  // Drop expired answers, then the least recently used ones until within budget
+  var keys = Object.keys(cache).filter(function (key) {
+    if (now - cache[key].created > RESPONSE_CACHE_TTL_MS) {
+      delete cache[key];
+      return false;
+    }
+    return true;
+  }).sort(function (a, b) {
+    return cache[a].used - cache[b].used;
+  });
+
+  var serialized = JSON.stringify(cache);
+  while (serialized.length > RESPONSE_CACHE_BUDGET && keys.length > 1) {
+    delete cache[keys.shift()];
+    serialized = JSON.stringify(cache);
+  }
+  localStorage.setItem(RESPONSE_CACHE_KEY, serialized);
+}
+
+// Get response from Claude API
+function getClaudeResponse(messages, threadId, requestId) {
+  var apiKey = settings.apiKey;
+  var baseUrl = settings.baseUrl;
+  var model = settings.model;
+
+  if (model === 'auto') {
+    model = routeModel(messages, settings.webSearchEnabled, settings.latencyBudget);
+  }
+
   if (!apiKey) {
-    console.log('No API key configured');
+    log(LOG_WARNING, 'No API key configured');
     // Send error, then end
-    Pebble.sendAppMessage({ 'RESPONSE_TEXT': 'No API key configured. Please configure in settings.' });
-    Pebble.sendAppMessage({ 'RESPONSE_END': 1 });
+    sendResponseText('No API key configured. Please configure in settings.');
+    endResponse(requestId);
     return;
   }
 
-  console.log('Sending request to Claude API with ' + messages.length + ' messages');
+  // The full transcript of the thread, ending with the new question
+  var thread = threadId ? loadActiveThread(threadId) : null;
+  var conversation = thread ? mergeThread(thread.messages, messages) : messages;
+  if (!conversation) {
+    resetThread(thread);
+    conversation = messages;
+  }
+
+  var statsKey = perfKey(model, baseUrl);
+  var cacheLookup = responseCacheLookup(model, messages);
+  if (cacheLookup) {
+    var cached = findCachedResponse(cacheLookup);
+    recordPerf(statsKey, { cacheHits: !!cached, cacheMisses: !cached });
+
+    if (cached) {
+      // Answer right away, the same way as a response from the API
+      log(LOG_INFO, 'Answered from the response cache');
+      sendResponseText(cached.text, cached.suggestions);
+      if (requestId) {
+        rememberAnswer(requestId, cached.text);
+      }
+      if (threadId) {
+        saveThread(threadId, conversation.concat([{ role: 'assistant', content: cached.text }]));
+      }
+      endResponse(requestId);
+      return;
+    }
+  }
+
+  log(LOG_DEBUG, 'Sending request to Claude API with ' + messages.length + ' messages');
 
   var xhr = new XMLHttpRequest();
   xhr.open('POST', baseUrl, true);
   xhr.setRequestHeader('Content-Type', 'application/json');
   xhr.setRequestHeader('x-api-key', apiKey);
   xhr.setRequestHeader('anthropic-version', '2023-06-01');
-  xhr.timeout = 5000;
+
+  var startTime = Date.now();
+  var firstByteTime = 0;
+  var transferStartTime = 0;
+  var stream = settings.webSearchEnabled ? createStream() : null;
+  xhr.timeout = stream ? STREAM_TIMEOUT : 5000;
+
+  xhr.onreadystatechange = function () {
+    if (xhr.readyState >= 2 && !firstByteTime) {
+      firstByteTime = Date.now();
+    }
+    if (stream && xhr.readyState === 3 && xhr.status === 200) {
+      readStream(stream, xhr.responseText);
+    }
+  };
 
   xhr.onload = function () {
+    recordLatency(model, Date.now() - startTime);
+    recordPerf(statsKey, {
+      requests: true,
+      errors: xhr.status !== 200,
+      ttfb: (firstByteTime || Date.now()) - startTime,
+      total: Date.now() - startTime,
+      bytes: utf8Length(xhr.responseText)
+    });
+
     if (xhr.status === 200) {
       try {
-        var data = JSON.parse(xhr.responseText);
+        var data;
+        if (stream) {
+          readStream(stream, xhr.responseText + '\n');
+          data = { content: stream.content.filter(Boolean), error: stream.error };
+        } else {
+          data = JSON.parse(xhr.responseText);
+        }
 
         // Extract all text blocks from content array
-        if (data.content && data.content.length > 0) {
+        if (data.error) {
+          log(LOG_ERROR, 'Stream error: ' + data.error.message);
+          sendResponseText('Error: ' + data.error.message);
+        } else if (data.content && data.content.length > 0) {
           var responseText = '';
 
           for (var i = 0; i < data.content.length; i++) {
@@ -64,25 +1140,41 @@ function getClaudeResponse(messages) {
             }
           }
 
-          responseText = responseText.trim();
+          var extracted = extractSuggestions(responseText.trim());
+          responseText = extracted.text;
 
           if (responseText.length > 0) {
-            console.log('Sending response: ' + responseText);
-            Pebble.sendAppMessage({ 'RESPONSE_TEXT': responseText });
+            logPayload('Sending response', responseText);
+            transferStartTime = Date.now();
+            sendResponseText(responseText, extracted.suggestions);
+
+            if (requestId) {
+              rememberAnswer(requestId, responseText);
+            }
+
+            if (cacheLookup) {
+              storeCachedResponse(cacheLookup, responseText, extracted.suggestions);
+            }
+
+            if (threadId) {
+              var transcript = conversation.concat([{ role: 'assistant', content: responseText }]);
+              saveThread(threadId, transcript);
+              compactConversation(threadId, transcript, apiKey, baseUrl);
+            }
           } else {
-            console.log('No text blocks in response');
-            Pebble.sendAppMessage({ 'RESPONSE_TEXT': 'No response from Claude' });
+            log(LOG_WARNING, 'No text blocks in response');
+            sendResponseText('No response from Claude');
           }
         } else {
-          console.log('No content in response');
-          Pebble.sendAppMessage({ 'RESPONSE_TEXT': 'No response from Claude' });
+          log(LOG_WARNING, 'No content in response');
+          sendResponseText('No response from Claude');
         }
       } catch (e) {
-        console.log('Error parsing response: ' + e);
-        Pebble.sendAppMessage({ 'RESPONSE_TEXT': 'Error parsing response' });
+        log(LOG_ERROR, 'Error parsing response: ' + e);
+        sendResponseText('Error parsing response');
       }
     } else {
-      console.log('API error: ' + xhr.status + ' - ' + xhr.responseText);
+      log(LOG_ERROR, 'API error: ' + xhr.status + ' - ' + xhr.responseText);
       // Parse error response and extract message
       var errorMessage = xhr.responseText;
 
@@ -92,83 +1184,168 @@ function getClaudeResponse(messages) {
           errorMessage = errorData.error.message;
         }
       } catch (e) {
-        console.log('Failed to parse error response: ' + e);
+        log(LOG_WARNING, 'Failed to parse error response: ' + e);
       }
 
       // Send error
-      Pebble.sendAppMessage({ 'RESPONSE_TEXT': 'Error ' + xhr.status + ': ' + errorMessage });
+      sendResponseText('Error ' + xhr.status + ': ' + errorMessage);
     }
 
-    // Always send end signal
-    Pebble.sendAppMessage({ 'RESPONSE_END': 1 });
+    // Always send end signal (a delivered response completes its transfer time)
+    endResponse(requestId, function (acked) {
+      if (transferStartTime && acked) {
+        recordPerf(statsKey, { transfer: Date.now() - transferStartTime });
+      }
+    });
   };
 
   xhr.onerror = function () {
-    console.log('Network error');
-    Pebble.sendAppMessage({ 'RESPONSE_TEXT': 'Network error occurred' });
-    Pebble.sendAppMessage({ 'RESPONSE_END': 1 });
+    log(LOG_ERROR, 'Network error');
+    recordPerf(statsKey, { requests: true, errors: true });
+    sendResponseText('Network error occurred');
+    endResponse(requestId);
   };
 
   xhr.ontimeout = function () {
-    console.log('Request timeout');
-    Pebble.sendAppMessage({ 'RESPONSE_TEXT': 'Request timed out. Likely problems on Anthropic\'s side.' });
-    Pebble.sendAppMessage({ 'RESPONSE_END': 1 });
-  };
-
-  var requestBody = {
-    model: model,
-    max_tokens: 256,
-    messages: messages
+    log(LOG_WARNING, 'Request timeout');
+    recordLatency(model, Date.now() - startTime);
+    recordPerf(statsKey, { requests: true, timeouts: true });
+    sendResponseText('Request timed out. Likely problems on Anthropic\'s side.');
+    endResponse(requestId);
   };
 
-  // Add system message if provided
-  if (systemMessage) {
-    requestBody.system = systemMessage;
+  // Replace turns already folded into the summary with the summary itself,
+  // followed by every turn after it (which may be older than what the watch sent)
+  var summary = thread ? thread.summary : null;
+  var requestMessages = summary ? applySummary(conversation, summary) : null;
+  if (!requestMessages) {
+    summary = null;
+    requestMessages = messages;
   }
+  var systemJson = settings.systemJson;
+  if (summary) {
+    systemJson = JSON.stringify(settings.systemMessage + '\n\nSummary of the earlier conversation: ' + summary.text +
+      '\n\n' + SUGGESTIONS_INSTRUCTION);
+  }
+
+  // Only the model and the messages are serialized per request
+  var requestBody = '{"model":' + JSON.stringify(model) + ',"max_tokens":256,"system":' + systemJson +
+    (settings.toolsJson ? ',"tools":' + settings.toolsJson : '') + (stream ? ',"stream":true' : '') +
+    ',"messages":' + JSON.stringify(requestMessages) + '}';
+
+  logPayload('Request body', requestBody);
+  xhr.send(requestBody);
+}
+
+// Connection pre-warming: the watch asks for it when dictation starts, so the
+// TLS handshake with the API is done by the time the request is sent
+var PREWARM_INTERVAL = 30000;
+var lastPrewarmTime = 0;
 
-  // Add web search tool if enabled
-  if (webSearchEnabled) {
-    requestBody.tools = [{
-      type: 'web_search_20250305',
-      name: 'web_search',
-      max_uses: 5
-    }];
+function prewarmConnection() {
+  if (Date.now() - lastPrewarmTime < PREWARM_INTERVAL) {
+    return;
   }
+  lastPrewarmTime = Date.now();
 
-  console.log('Request body: ' + JSON.stringify(requestBody));
-  xhr.send(JSON.stringify(requestBody));
+  var xhr = new XMLHttpRequest();
+  xhr.open('HEAD', settings.baseUrl, true);
+  xhr.timeout = 5000;
+  xhr.onload = function () {
+    log(LOG_DEBUG, 'Connection pre-warmed in ' + (Date.now() - lastPrewarmTime) + 'ms');
+  };
+  xhr.send();
 }
 
-// Send ready status to watch
+// Send ready status (and the settings the watch keeps itself) to watch
 function sendReadyStatus() {
-  var apiKey = localStorage.getItem('api_key');
+  var apiKey = settings.apiKey;
   var isReady = apiKey && apiKey.trim().length > 0 ? 1 : 0;
+  var dictationConfirm = settings.skipDictationConfirmation ? 0 : 1;
 
-  console.log('Sending READY_STATUS: ' + isReady);
-  Pebble.sendAppMessage({ 'READY_STATUS': isReady });
+  log(LOG_INFO, 'Sending READY_STATUS: ' + isReady);
+  sendMessage({ 'READY_STATUS': isReady, 'DICTATION_CONFIRM': dictationConfirm });
 }
 
 // Listen for app ready
 Pebble.addEventListener('ready', function () {
-  console.log('PebbleKit JS ready');
+  log(LOG_INFO, 'PebbleKit JS ready');
+  captureStartTime = Date.now();
+  captureEvent('#', { launched: new Date().toISOString() });
   sendReadyStatus();
 });
 
 // Listen for messages from watch
 Pebble.addEventListener('appmessage', function (e) {
-  console.log('Received message from watch');
+  log(LOG_DEBUG, 'Received message from watch');
+  captureEvent('<', e.payload);
+
+  if (e.payload.INBOX_SIZE) {
+    watchInboxSize = e.payload.INBOX_SIZE;
+  }
 
   if (e.payload.REQUEST_CHAT) {
     var encoded = e.payload.REQUEST_CHAT;
-    console.log('REQUEST_CHAT received: ' + encoded);
+    log(LOG_DEBUG, 'REQUEST_CHAT received: ' + encoded.length + (typeof encoded === 'string' ? ' characters' : ' bytes'));
+
+    var requestId = e.payload.REQUEST_ID;
+    var messages;
+    if (typeof encoded === 'string') {
+      messages = parseConversation(encoded);
+    } else {
+      var conversation = decodeConversation(encoded);
+      if (!conversation) {
+        log(LOG_ERROR, 'Unsupported conversation format ' + encoded[0]);
+        sendResponseText('Error: unsupported request format');
+        sendMessage({ 'RESPONSE_END': 1 });
+        return;
+      }
+      messages = conversation.messages;
+      requestId = conversation.requestId || requestId;
+    }
 
-    var messages = parseConversation(encoded);
-    console.log('Parsed ' + messages.length + ' messages');
+    if (requestId && requestsInFlight[requestId]) {
+      log(LOG_INFO, 'Request ' + requestId + ' already in progress');
+      return;
+    }
 
-    getClaudeResponse(messages);
+    // A retried request that was already answered gets the same answer again
+    var answer = requestId ? findAnswer(requestId) : null;
+    if (answer !== null) {
+      log(LOG_INFO, 'Request ' + requestId + ' already answered');
+      sendResponseText(answer);
+      sendMessage({ 'RESPONSE_END': 1 });
+      return;
+    }
+
+    log(LOG_DEBUG, 'Parsed ' + messages.length + ' messages');
+
+    if (requestId) {
+      requestsInFlight[requestId] = true;
+    }
+    getClaudeResponse(messages, e.payload.THREAD_ID, requestId);
+  } else if (e.payload.THREAD_REQUEST) {
+    sendThread(e.payload.THREAD_REQUEST);
+  } else if (e.payload.PREWARM) {
+    prewarmConnection();
   }
 });
 
+// The settings page is bundled at build time (see wscript) and opened as a
+// data: URI, so it opens instantly and works offline. The query string and the
+// emulator's return_to are appended after the page, inside the trailing comment.
+// A bundle built without the page falls back to the hosted copy.
+var HOSTED_CONFIG_PAGE_URL = 'https://breitburg.github.io/claude-for-pebble/config/';
+
+function getConfigPageUrl() {
+  try {
+    return 'data:text/html;charset=utf-8,' + encodeURIComponent(require('./config_page') + '<!--');
+  } catch (e) {
+    log(LOG_WARNING, 'Bundled settings page not found, opening the hosted one');
+    return HOSTED_CONFIG_PAGE_URL;
+  }
+}
+
 // Listen for when the configuration page is opened
 Pebble.addEventListener('showConfiguration', function () {
   // Get existing settings
@@ -177,36 +1354,53 @@ Pebble.addEventListener('showConfiguration', function () {
   var model = localStorage.getItem('model') || '';
   var systemMessage = localStorage.getItem('system_message') || '';
   var webSearchEnabled = localStorage.getItem('web_search_enabled') || 'false';
+  var captureEnabled = localStorage.getItem('capture_enabled') || 'false';
+  var latencyBudget = localStorage.getItem('latency_budget_ms') || '';
+  var skipConfirmation = localStorage.getItem('skip_dictation_confirmation') || 'false';
+  var responseCacheEnabled = localStorage.getItem('response_cache_enabled') || 'false';
+
+  // Flush any recorded traffic to the log before the user changes settings
+  dumpCapture();
 
   // Build configuration URL
-  var url = 'https://breitburg.github.io/claude-for-pebble/config/';
+  var url = getConfigPageUrl();
   url += '?api_key=' + encodeURIComponent(apiKey);
   url += '&base_url=' + encodeURIComponent(baseUrl);
   url += '&model=' + encodeURIComponent(model);
   url += '&system_message=' + encodeURIComponent(systemMessage);
   url += '&web_search_enabled=' + encodeURIComponent(webSearchEnabled);
+  url += '&capture_enabled=' + encodeURIComponent(captureEnabled);
+  url += '&latency_budget_ms=' + encodeURIComponent(latencyBudget);
+  url += '&skip_dictation_confirmation=' + encodeURIComponent(skipConfirmation);
+  url += '&response_cache_enabled=' + encodeURIComponent(responseCacheEnabled);
+  url += '&perf_stats=' + encodeURIComponent(JSON.stringify({ buckets: PERF_HISTOGRAMS, entries: loadPerfStats() }));
 
-  console.log('Opening configuration page: ' + url);
+  logPayload('Opening configuration page', url);
   Pebble.openURL(url);
 });
 
 // Listen for when the configuration page is closed
 Pebble.addEventListener('webviewclosed', function (e) {
   if (e && e.response) {
-    var settings = JSON.parse(decodeURIComponent(e.response));
-    console.log('Settings received: ' + JSON.stringify(settings));
+    var received = JSON.parse(decodeURIComponent(e.response));
+    logPayload('Settings received', received);
 
     // Save or clear settings in local storage
-    var keys = ['api_key', 'base_url', 'model', 'system_message', 'web_search_enabled'];
-    keys.forEach(function (key) {
-      if (settings[key] && settings[key].trim() !== '') {
-        localStorage.setItem(key, settings[key]);
-        console.log(key + ' saved');
+    SETTINGS_KEYS.forEach(function (key) {
+      if (received[key] && received[key].trim() !== '') {
+        localStorage.setItem(key, received[key]);
+        log(LOG_DEBUG, key + ' saved');
       } else {
         localStorage.removeItem(key);
-        console.log(key + ' cleared');
+        log(LOG_DEBUG, key + ' cleared');
       }
     });
+    settings = loadSettings();
+
+    if (received.reset_stats === 'true') {
+      resetPerfStats();
+      log(LOG_INFO, 'Performance statistics reset');
+    }
 
     // Send updated ready status to watch
     sendReadyStatus();
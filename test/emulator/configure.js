@@ -0,0 +1,26 @@
+// Stands in for the browser `pebble emu-app-config` opens the settings page
+// in: instead of showing the page, it returns the settings in MOCK_SETTINGS
+// (JSON) to the page's return_to URL, as the page's Save button would.
+//
+//   BROWSER="node test/emulator/configure.js %s &" pebble emu-app-config --emulator basalt
+var http = require('http');
+
+// Read as config/config.js does: the page is a data: URI, with return_to
+// after the page text
+var pageUrl = process.argv[2] || '';
+var match = pageUrl.match(/[?&]return_to=([^&#]*)/);
+if (!match) {
+  console.error('No return_to in the settings page URL');
+  process.exit(1);
+}
+var returnTo = decodeURIComponent(match[1]);
+
+http.get(returnTo + encodeURIComponent(process.env.MOCK_SETTINGS || '{}'), function (res) {
+  res.resume();
+  res.on('end', function () {
+    process.exit(res.statusCode < 400 ? 0 : 1);
+  });
+}).on('error', function (e) {
+  console.error('Could not return the settings: ' + e.message);
+  process.exit(1);
+});
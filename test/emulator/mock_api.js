@@ -0,0 +1,261 @@
+// Mock Messages API for the emulator performance suite. PebbleKit JS is
+// pointed at it through the base_url setting; it replays recorded responses
+// (fixtures/*.json, and fixtures/*.sse for streamed requests) with added
+// latency, chunking and errors, and records the timing of every request.
+//
+//   node test/emulator/mock_api.js [--port 8787] [--latency ms]
+//     [--chunk-size bytes] [--chunk-interval ms] [--errors 429,ok,529,timeout]
+var http = require('http');
+var fs = require('fs');
+var path = require('path');
+var util = require('util');
+
+var FIXTURES_DIR = path.join(__dirname, 'fixtures');
+var DEFAULT_PORT = 8787;
+
+// Error bodies as the API sends them
+var ERROR_TYPES = {
+  429: { type: 'rate_limit_error', message: 'Number of request tokens has exceeded your per-minute rate limit' },
+  529: { type: 'overloaded_error', message: 'Overloaded' }
+};
+
+// Recorded responses by kind, in file name order
+function loadFixtures(dir) {
+  var fixtures = { json: [], sse: [] };
+  fs.readdirSync(dir).sort().forEach(function (name) {
+    var kind = path.extname(name).substring(1);
+    if (fixtures[kind]) {
+      fixtures[kind].push({ name: name, body: fs.readFileSync(path.join(dir, name), 'utf8') });
+    }
+  });
+  return fixtures;
+}
+
+function formatEvent(event) {
+  return 'event: ' + event.type + '\ndata: ' + JSON.stringify(event) + '\n\n';
+}
+
+// The events of a recorded JSON response as if it had been streamed, for
+// streamed requests when there is no recorded stream
+function toEventStream(json) {
+  var message = JSON.parse(json);
+  var content = message.content || [];
+  var start = {};
+  Object.keys(message).forEach(function (key) {
+    start[key] = key === 'content' ? [] : message[key];
+  });
+  start.stop_reason = null;
+
+  var events = [{ type: 'message_start', message: start }];
+  content.forEach(function (block, index) {
+    if (block.type === 'text') {
+      events.push({ type: 'content_block_start', index: index, content_block: { type: 'text', text: '' } });
+      events.push({ type: 'content_block_delta', index: index, delta: { type: 'text_delta', text: block.text } });
+    } else {
+      events.push({ type: 'content_block_start', index: index, content_block: block });
+    }
+    events.push({ type: 'content_block_stop', index: index });
+  });
+  events.push({
+    type: 'message_delta',
+    delta: { stop_reason: message.stop_reason, stop_sequence: null },
+    usage: { output_tokens: message.usage ? message.usage.output_tokens : 0 }
+  });
+  events.push({ type: 'message_stop' });
+
+  return events.map(formatEvent).join('');
+}
+
+// Options: fixtures (directory), latency (ms before the response starts),
+// chunkSize (bytes per write, 0 for the whole body at once), chunkInterval
+// (ms between writes), errors (outcome of the first requests in order: 429,
+// 529, 'timeout' or 'ok'; later requests succeed), onResponse (called with
+// the request's entry when its response has been sent)
+function createMockApi(options) {
+  options = options || {};
+  var fixtures = loadFixtures(options.fixtures || FIXTURES_DIR);
+  var latency = options.latency || 0;
+  var chunkSize = options.chunkSize || 0;
+  var chunkInterval = options.chunkInterval || 0;
+  var errors = options.errors || [];
+  var served = { json: 0, sse: 0 };
+  var sockets = [];
+
+  var mock = {
+    // One entry per Messages API request: { stream, outcome, fixture,
+    // receivedAt, firstByteAt, endAt, bytes, chunks }
+    requests: [],
+    server: null,
+    url: null
+  };
+
+  function nextFixture(stream) {
+    if (stream && fixtures.sse.length > 0) {
+      var recorded = fixtures.sse[served.sse++ % fixtures.sse.length];
+      return { name: recorded.name, body: recorded.body, type: 'text/event-stream' };
+    }
+
+    if (fixtures.json.length === 0) {
+      throw new Error('No fixtures to replay');
+    }
+    var fixture = fixtures.json[served.json++ % fixtures.json.length];
+    return stream ?
+      { name: fixture.name, body: toEventStream(fixture.body), type: 'text/event-stream' } :
+      { name: fixture.name, body: fixture.body, type: 'application/json' };
+  }
+
+  // Write the body in chunks, then end the response
+  function sendBody(res, entry, body) {
+    var data = Buffer.from(body, 'utf8');
+    var size = chunkSize > 0 ? chunkSize : data.length;
+    var offset = 0;
+
+    function writeNext() {
+      if (res.destroyed) {
+        return;
+      }
+      if (!entry.firstByteAt) {
+        entry.firstByteAt = Date.now();
+      }
+      res.write(data.subarray(offset, offset + size));
+      offset += size;
+      entry.chunks++;
+
+      if (offset < data.length) {
+        setTimeout(writeNext, chunkInterval);
+      } else {
+        res.end();
+        entry.endAt = Date.now();
+        if (options.onResponse) {
+          options.onResponse(entry);
+        }
+      }
+    }
+
+    entry.bytes = data.length;
+    writeNext();
+  }
+
+  function respond(req, res, requestBody) {
+    var request = {};
+    try {
+      request = JSON.parse(requestBody);
+    } catch (e) {
+      // Answered like any other request
+    }
+
+    var entry = {
+      stream: request.stream === true,
+      outcome: errors.length > mock.requests.length ? String(errors[mock.requests.length]) : 'ok',
+      fixture: null,
+      receivedAt: Date.now(),
+      firstByteAt: 0,
+      endAt: 0,
+      bytes: 0,
+      chunks: 0
+    };
+    mock.requests.push(entry);
+
+    if (entry.outcome === 'timeout') {
+      // Never answer; the client gives up
+      return;
+    }
+
+    setTimeout(function () {
+      if (ERROR_TYPES[entry.outcome]) {
+        res.writeHead(Number(entry.outcome), { 'Content-Type': 'application/json', 'retry-after': '1' });
+        sendBody(res, entry, JSON.stringify({ type: 'error', error: ERROR_TYPES[entry.outcome] }));
+        return;
+      }
+
+      var fixture = nextFixture(entry.stream);
+      entry.fixture = fixture.name;
+      res.writeHead(200, { 'Content-Type': fixture.type });
+      sendBody(res, entry, fixture.body);
+    }, latency);
+  }
+
+  mock.server = http.createServer(function (req, res) {
+    // Connection pre-warming
+    if (req.method !== 'POST') {
+      res.writeHead(200);
+      res.end();
+      return;
+    }
+
+    var chunks = [];
+    req.on('data', function (chunk) {
+      chunks.push(chunk);
+    });
+    req.on('end', function () {
+      respond(req, res, Buffer.concat(chunks).toString('utf8'));
+    });
+  });
+
+  mock.server.on('connection', function (socket) {
+    sockets.push(socket);
+    socket.on('close', function () {
+      sockets.splice(sockets.indexOf(socket), 1);
+    });
+  });
+
+  mock.listen = function (port, callback) {
+    mock.server.listen(port, '127.0.0.1', function () {
+      mock.url = 'http://127.0.0.1:' + mock.server.address().port + '/v1/messages';
+      if (callback) {
+        callback(mock.url);
+      }
+    });
+  };
+
+  // Close, dropping requests left unanswered
+  mock.close = function (callback) {
+    sockets.slice().forEach(function (socket) {
+      socket.destroy();
+    });
+    mock.server.close(callback);
+  };
+
+  return mock;
+}
+
+// Command line options shared with run.js
+var CLI_OPTIONS = {
+  port: { type: 'string' },
+  fixtures: { type: 'string' },
+  latency: { type: 'string' },
+  'chunk-size': { type: 'string' },
+  'chunk-interval': { type: 'string' },
+  errors: { type: 'string' }
+};
+
+function mockOptionsFromCli(values) {
+  return {
+    fixtures: values.fixtures,
+    latency: Number(values.latency || 0),
+    chunkSize: Number(values['chunk-size'] || 0),
+    chunkInterval: Number(values['chunk-interval'] || 0),
+    errors: values.errors ? values.errors.split(',') : []
+  };
+}
+
+if (require.main === module) {
+  var values = util.parseArgs({ options: CLI_OPTIONS }).values;
+  var cliOptions = mockOptionsFromCli(values);
+  cliOptions.onResponse = function (entry) {
+    console.log(entry.outcome + ' ' + (entry.fixture || '-') + ': ' + entry.bytes + ' bytes in ' + entry.chunks +
+      ' chunks, ' + (entry.endAt - entry.receivedAt) + ' ms');
+  };
+  createMockApi(cliOptions).listen(Number(values.port || DEFAULT_PORT), function (url) {
+    console.log('Mock Messages API at ' + url);
+  });
+}
+
+module.exports = {
+  FIXTURES_DIR: FIXTURES_DIR,
+  DEFAULT_PORT: DEFAULT_PORT,
+  CLI_OPTIONS: CLI_OPTIONS,
+  createMockApi: createMockApi,
+  mockOptionsFromCli: mockOptionsFromCli,
+  toEventStream: toEventStream
+};
@@ -0,0 +1,174 @@
+// The mock Messages API of the emulator suite, over real HTTP, and the phone
+// code reading what it serves.
+var test = require('node:test');
+var assert = require('node:assert');
+var fs = require('fs');
+var http = require('http');
+var os = require('os');
+var path = require('path');
+var mockApi = require('./mock_api');
+var harness = require('../pkjs/harness');
+
+function fixture(name) {
+  return fs.readFileSync(path.join(mockApi.FIXTURES_DIR, name), 'utf8');
+}
+
+function startMock(options) {
+  var mock = mockApi.createMockApi(options);
+  return new Promise(function (resolve) {
+    mock.listen(0, function () {
+      resolve(mock);
+    });
+  });
+}
+
+// POST a Messages API request; resolves with { status, body, headers,
+// firstByteAt } or { timedOut: true }
+function post(mock, request, timeout) {
+  return new Promise(function (resolve, reject) {
+    var sentAt = Date.now();
+    var req = http.request(mock.url, { method: 'POST', headers: { 'Content-Type': 'application/json' } }, function (res) {
+      var chunks = [];
+      var firstByteAt = 0;
+      res.on('data', function (chunk) {
+        firstByteAt = firstByteAt || Date.now();
+        chunks.push(chunk);
+      });
+      res.on('end', function () {
+        resolve({
+          status: res.statusCode,
+          headers: res.headers,
+          body: Buffer.concat(chunks).toString('utf8'),
+          ttfb: firstByteAt - sentAt,
+          total: Date.now() - sentAt
+        });
+      });
+    });
+    if (timeout) {
+      req.setTimeout(timeout, function () {
+        req.destroy();
+        resolve({ timedOut: true });
+      });
+    }
+    req.on('error', function (e) {
+      if (!req.destroyed) {
+        reject(e);
+      }
+    });
+    req.end(JSON.stringify(request));
+  });
+}
+
+var QUESTION = { model: 'claude-haiku-4-5', max_tokens: 256, messages: [{ role: 'user', content: 'Hi' }] };
+var STREAMED_QUESTION = Object.assign({ stream: true }, QUESTION);
+
+// Text of a response the way the phone reads it: answer the app's request
+// with the mock's response and collect what is sent to the watch
+function answerApp(response, stream) {
+  var storage = { api_key: 'test-key' };
+  if (stream) {
+    storage.web_search_enabled = 'true';
+  }
+  var app = harness.loadApp({ storage: storage });
+  app.receive({ REQUEST_CHAT: app.context.encodeConversation([{ role: 'user', content: 'Hi' }], 1, 4000) });
+  app.requests[0].respond(response.status, response.body);
+
+  return app.sent.filter(function (dict) {
+    return dict.RESPONSE_TEXT !== undefined;
+  }).map(function (dict) {
+    return dict.RESPONSE_TEXT;
+  }).join('');
+}
+
+test('recorded JSON responses are replayed in order', async function () {
+  var mock = await startMock();
+  try {
+    var first = await post(mock, QUESTION);
+    var second = await post(mock, QUESTION);
+    var third = await post(mock, QUESTION);
+
+    assert.strictEqual(first.status, 200);
+    assert.strictEqual(first.headers['content-type'], 'application/json');
+    assert.strictEqual(first.body, fixture('long.json'));
+    assert.strictEqual(second.body, fixture('short.json'));
+    assert.strictEqual(third.body, fixture('long.json'));
+    assert.deepStrictEqual(mock.requests.map(function (entry) {
+      return entry.fixture;
+    }), ['long.json', 'short.json', 'long.json']);
+
+    // What the phone sends the watch is the recorded text
+    assert.strictEqual(answerApp(second), JSON.parse(fixture('short.json')).content[0].text);
+  } finally {
+    mock.close();
+  }
+});
+
+test('streamed requests get the recorded event stream', async function () {
+  var mock = await startMock();
+  try {
+    var response = await post(mock, STREAMED_QUESTION);
+    assert.strictEqual(response.headers['content-type'], 'text/event-stream');
+    assert.strictEqual(response.body, fixture('search.sse'));
+    assert.strictEqual(answerApp(response, true),
+      'It is sunny in Palo Alto today, with a high of 22 degrees Celsius and a light breeze in the afternoon.');
+  } finally {
+    mock.close();
+  }
+});
+
+test('a recorded JSON response is streamed when there is no recorded stream', async function () {
+  var dir = fs.mkdtempSync(path.join(os.tmpdir(), 'mock-api-'));
+  fs.copyFileSync(path.join(mockApi.FIXTURES_DIR, 'short.json'), path.join(dir, 'short.json'));
+  var mock = await startMock({ fixtures: dir });
+  try {
+    var response = await post(mock, STREAMED_QUESTION);
+    assert.strictEqual(response.headers['content-type'], 'text/event-stream');
+    assert.ok(response.body.indexOf('event: message_stop') >= 0);
+    assert.strictEqual(answerApp(response, true), JSON.parse(fixture('short.json')).content[0].text);
+  } finally {
+    mock.close();
+    fs.rmSync(dir, { recursive: true });
+  }
+});
+
+test('responses start after the latency and arrive in chunks', async function () {
+  var mock = await startMock({ latency: 150, chunkSize: 200, chunkInterval: 30 });
+  try {
+    var response = await post(mock, QUESTION);
+    var entry = mock.requests[0];
+    var chunks = Math.ceil(Buffer.byteLength(fixture('long.json')) / 200);
+
+    assert.strictEqual(response.body, fixture('long.json'));
+    assert.strictEqual(entry.chunks, chunks);
+    assert.ok(response.ttfb >= 140, 'first byte after ' + response.ttfb + ' ms');
+    assert.ok(entry.firstByteAt - entry.receivedAt >= 140);
+    assert.ok(entry.endAt - entry.firstByteAt >= (chunks - 1) * 25, 'body over ' + (entry.endAt - entry.firstByteAt) + ' ms');
+  } finally {
+    mock.close();
+  }
+});
+
+test('errors and timeouts are injected in order', async function () {
+  var mock = await startMock({ errors: ['429', '529', 'timeout'] });
+  try {
+    var limited = await post(mock, QUESTION);
+    assert.strictEqual(limited.status, 429);
+    assert.strictEqual(limited.headers['retry-after'], '1');
+    assert.strictEqual(JSON.parse(limited.body).error.type, 'rate_limit_error');
+    assert.strictEqual(answerApp(limited), 'Error 429: ' + JSON.parse(limited.body).error.message);
+
+    var overloaded = await post(mock, QUESTION);
+    assert.strictEqual(overloaded.status, 529);
+    assert.strictEqual(JSON.parse(overloaded.body).error.type, 'overloaded_error');
+
+    assert.deepStrictEqual(await post(mock, QUESTION, 200), { timedOut: true });
+
+    var answered = await post(mock, QUESTION);
+    assert.strictEqual(answered.status, 200);
+    assert.deepStrictEqual(mock.requests.map(function (entry) {
+      return entry.outcome;
+    }), ['429', '529', 'timeout', 'ok']);
+  } finally {
+    mock.close();
+  }
+});
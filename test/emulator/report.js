@@ -0,0 +1,138 @@
+// Metrics of an emulator run, read from the app's log lines (`pebble logs`),
+// each stamped with the host time it was read at: the watch's log timestamps
+// only have whole seconds.
+
+// A turn starts when the watch sends its request and ends with the end of
+// the response. The first response text is drawn as it is received.
+var TURN_START = /Sent REQUEST_CHAT/;
+var RESPONSE_TEXT = /Received RESPONSE_TEXT/;
+var RESPONSE_END = /Received RESPONSE_END/;
+// Messages lost either way (inbox dropped on the watch, outbox failed)
+var DROPPED = /Message dropped|Outbox send failed/;
+// Heap size at launch, then what is free at each layout
+var HEAP_AT_LAUNCH = /Heap after AppMessage: (\d+) used, (\d+) free/;
+var HEAP_FREE = /heap free (\d+)/;
+
+// lines: [{ time, text }] in order. Returns { turns: [{ ttft, turnTime }],
+// dropped, heapSize, heapPeak }; a turn that never ended has a null turnTime
+function parseLog(lines) {
+  var result = { turns: [], dropped: 0, heapSize: 0, heapPeak: 0 };
+  var turn = null;
+
+  lines.forEach(function (line) {
+    var match;
+    if (TURN_START.test(line.text)) {
+      turn = { start: line.time, ttft: null, turnTime: null };
+      result.turns.push(turn);
+    } else if (RESPONSE_TEXT.test(line.text)) {
+      if (turn && turn.ttft === null) {
+        turn.ttft = line.time - turn.start;
+      }
+    } else if (RESPONSE_END.test(line.text)) {
+      if (turn) {
+        turn.turnTime = line.time - turn.start;
+        turn = null;
+      }
+    } else if (DROPPED.test(line.text)) {
+      result.dropped++;
+    } else if ((match = line.text.match(HEAP_AT_LAUNCH))) {
+      result.heapSize = Number(match[1]) + Number(match[2]);
+      result.heapPeak = Math.max(result.heapPeak, Number(match[1]));
+    }
+
+    if (result.heapSize && (match = line.text.match(HEAP_FREE))) {
+      result.heapPeak = Math.max(result.heapPeak, result.heapSize - Number(match[1]));
+    }
+  });
+
+  result.turns = result.turns.map(function (entry) {
+    return { ttft: entry.ttft, turnTime: entry.turnTime };
+  });
+  return result;
+}
+
+// Nearest-rank percentile of the non-null values (null if there are none)
+function percentile(values, fraction) {
+  var sorted = values.filter(function (value) {
+    return value !== null;
+  }).sort(function (a, b) {
+    return a - b;
+  });
+  if (sorted.length === 0) {
+    return null;
+  }
+  return sorted[Math.min(sorted.length - 1, Math.ceil(fraction * sorted.length) - 1)];
+}
+
+// Summary of one platform's run; requests are the mock server's entries
+function summarize(platform, parsed, requests) {
+  var ttfts = parsed.turns.map(function (turn) {
+    return turn.ttft;
+  });
+  var turnTimes = parsed.turns.map(function (turn) {
+    return turn.turnTime;
+  });
+  var outcomes = {};
+  (requests || []).forEach(function (entry) {
+    outcomes[entry.outcome] = (outcomes[entry.outcome] || 0) + 1;
+  });
+
+  return {
+    platform: platform,
+    turns: parsed.turns.length,
+    completed: turnTimes.filter(function (time) {
+      return time !== null;
+    }).length,
+    ttft: { median: percentile(ttfts, 0.5), p90: percentile(ttfts, 0.9) },
+    turnTime: { median: percentile(turnTimes, 0.5), p90: percentile(turnTimes, 0.9) },
+    dropped: parsed.dropped,
+    heapPeak: parsed.heapPeak,
+    heapSize: parsed.heapSize,
+    apiOutcomes: outcomes
+  };
+}
+
+function pad(text, width) {
+  text = String(text);
+  while (text.length < width) {
+    text += ' ';
+  }
+  return text;
+}
+
+function formatMs(value) {
+  return value === null ? '-' : value + ' ms';
+}
+
+// A table of the summaries, one row per platform
+function formatReport(summaries) {
+  var header = ['platform', 'turns', 'first text (p50/p90)', 'turn (p50/p90)', 'dropped', 'peak heap'];
+  var rows = summaries.map(function (summary) {
+    return [
+      summary.platform,
+      summary.completed + '/' + summary.turns,
+      formatMs(summary.ttft.median) + ' / ' + formatMs(summary.ttft.p90),
+      formatMs(summary.turnTime.median) + ' / ' + formatMs(summary.turnTime.p90),
+      summary.dropped,
+      summary.heapSize ? summary.heapPeak + ' of ' + summary.heapSize : '-'
+    ];
+  });
+
+  var widths = header.map(function (title, column) {
+    return rows.reduce(function (width, row) {
+      return Math.max(width, String(row[column]).length);
+    }, title.length);
+  });
+  return [header].concat(rows).map(function (row) {
+    return row.map(function (cell, column) {
+      return pad(cell, widths[column]);
+    }).join('  ').trim();
+  }).join('\n');
+}
+
+module.exports = {
+  parseLog: parseLog,
+  percentile: percentile,
+  summarize: summarize,
+  formatReport: formatReport
+};
@@ -0,0 +1,48 @@
+// Metrics of an emulator run read from its log lines.
+var test = require('node:test');
+var assert = require('node:assert');
+var report = require('./report');
+
+// Log lines as `pebble logs` prints them, stamped with the time they were read
+var LOG = [
+  [0, '[12:00:00] claude-for-pebble.c:101> Heap after AppMessage: 9000 used, 55000 free'],
+  [900, '[12:00:01] chat_window.c:1118> Sent REQUEST_CHAT: 40 bytes'],
+  [1300, '[12:00:01] chat_window.c:1440> Received RESPONSE_TEXT: The Pebble Time Round has'],
+  [1320, '[12:00:01] chat_window.c:251> Layout: 2 messages, 180px, heap free 51000, pool free 7000 of 8192 (largest 7000)'],
+  [1400, '[12:00:01] chat_window.c:1453> Received RESPONSE_END'],
+  [3000, '[12:00:03] chat_window.c:1118> Sent REQUEST_CHAT: 120 bytes'],
+  [3800, '[12:00:03] chat_window.c:1440> Received RESPONSE_TEXT: Sourdough starts'],
+  [3850, '[12:00:03] claude-for-pebble.c:63> Message dropped: 8'],
+  [3900, '[12:00:03] chat_window.c:1440> Received RESPONSE_TEXT: with a starter'],
+  [3950, '[12:00:03] chat_window.c:251> Layout: 4 messages, 900px, heap free 52500, pool free 5000 of 8192 (largest 4000)'],
+  [4200, '[12:00:04] chat_window.c:1453> Received RESPONSE_END'],
+  [6000, '[12:00:06] chat_window.c:1118> Sent REQUEST_CHAT: 200 bytes'],
+  [6100, '[12:00:06] claude-for-pebble.c:67> Outbox send failed: 2']
+].map(function (entry) {
+  return { time: entry[0], text: entry[1] };
+});
+
+test('turns, drops and heap are read from the log', function () {
+  var parsed = report.parseLog(LOG);
+  assert.deepStrictEqual(parsed.turns, [
+    { ttft: 400, turnTime: 500 },
+    { ttft: 800, turnTime: 1200 },
+    { ttft: null, turnTime: null }
+  ]);
+  assert.strictEqual(parsed.dropped, 2);
+  assert.strictEqual(parsed.heapSize, 64000);
+  assert.strictEqual(parsed.heapPeak, 13000);
+});
+
+test('the summary leaves out turns that never finished', function () {
+  var summary = report.summarize('basalt', report.parseLog(LOG), [{ outcome: 'ok' }, { outcome: '429' }, { outcome: 'ok' }]);
+  assert.strictEqual(summary.turns, 3);
+  assert.strictEqual(summary.completed, 2);
+  assert.deepStrictEqual(summary.ttft, { median: 400, p90: 800 });
+  assert.deepStrictEqual(summary.turnTime, { median: 500, p90: 1200 });
+  assert.deepStrictEqual(summary.apiOutcomes, { ok: 2, 429: 1 });
+
+  var table = report.formatReport([summary]).split('\n');
+  assert.strictEqual(table.length, 2);
+  assert.match(table[1], /^basalt\s+2\/3\s+400 ms \/ 800 ms\s+500 ms \/ 1200 ms\s+2\s+13000 of 64000$/);
+});
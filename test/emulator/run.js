@@ -0,0 +1,155 @@
+// Emulator performance suite: runs the app in the Pebble emulator on each
+// platform against the mock Messages API (mock_api.js), plays a few turns by
+// pressing Select and dictating with `pebble transcribe`, and reports time to
+// the first response text, turn time, dropped AppMessages and peak heap
+// (report.js). Needs the Pebble SDK's `pebble` tool on the PATH.
+//
+//   node test/emulator/run.js [--platforms basalt,diorite,emery] [--turns 5]
+//     [--stream] [--skip-build] [--out report.json] [mock_api.js options]
+var childProcess = require('child_process');
+var fs = require('fs');
+var path = require('path');
+var readline = require('readline');
+var util = require('util');
+var mockApi = require('./mock_api');
+var report = require('./report');
+
+var ROOT = path.join(__dirname, '..', '..');
+var DEFAULT_PLATFORMS = ['basalt', 'diorite', 'emery'];
+var DEFAULT_TURNS = 5;
+var TURN_TIMEOUT = 60000;
+// Time for the window or the dictation UI to come up after a button press
+var UI_SETTLE_TIME = 1500;
+
+var QUESTIONS = [
+  'How big is the screen of the Pebble Time Round',
+  'How do I bake sourdough bread',
+  'What is the weather in Palo Alto today',
+  'Tell me more about that'
+];
+
+function sleep(ms) {
+  return new Promise(function (resolve) {
+    setTimeout(resolve, ms);
+  });
+}
+
+function pebble(args, env) {
+  var result = childProcess.spawnSync('pebble', args, {
+    cwd: ROOT,
+    stdio: 'inherit',
+    env: Object.assign({}, process.env, env || {})
+  });
+  if (result.error || result.status !== 0) {
+    throw new Error('pebble ' + args.join(' ') + ' failed' + (result.error ? ': ' + result.error.message : ''));
+  }
+}
+
+// Follow the emulator's logs, stamping each line with the time it was read
+function followLogs(platform) {
+  var lines = [];
+  var child = childProcess.spawn('pebble', ['logs', '--emulator', platform], { cwd: ROOT });
+  readline.createInterface({ input: child.stdout }).on('line', function (text) {
+    lines.push({ time: Date.now(), text: text });
+  });
+  return { lines: lines, stop: function () { child.kill(); } };
+}
+
+async function waitForLine(lines, pattern, count, timeout) {
+  var deadline = Date.now() + timeout;
+  while (Date.now() < deadline) {
+    var seen = lines.filter(function (line) {
+      return pattern.test(line.text);
+    }).length;
+    if (seen >= count) {
+      return true;
+    }
+    await sleep(100);
+  }
+  return false;
+}
+
+async function runPlatform(platform, options, mock) {
+  console.log('== ' + platform);
+  var firstRequest = mock.requests.length;
+  pebble(['install', '--emulator', platform]);
+
+  var logs = followLogs(platform);
+  try {
+    // Point the app at the mock server (see configure.js)
+    pebble(['emu-app-config', '--emulator', platform], {
+      BROWSER: process.execPath + ' ' + path.join(__dirname, 'configure.js') + ' %s &',
+      MOCK_SETTINGS: JSON.stringify({
+        api_key: 'emulator',
+        base_url: mock.url,
+        web_search_enabled: options.stream ? 'true' : 'false',
+        skip_dictation_confirmation: 'true'
+      })
+    });
+    await sleep(UI_SETTLE_TIME);
+
+    // Welcome window to the chat window
+    pebble(['emu-button', 'click', 'select', '--emulator', platform]);
+    await sleep(UI_SETTLE_TIME);
+
+    for (var turn = 0; turn < options.turns; turn++) {
+      pebble(['emu-button', 'click', 'select', '--emulator', platform]);
+      await sleep(UI_SETTLE_TIME);
+      pebble(['transcribe', '--emulator', platform, QUESTIONS[turn % QUESTIONS.length]]);
+      if (!await waitForLine(logs.lines, /Received RESPONSE_END/, turn + 1, TURN_TIMEOUT)) {
+        console.log('Turn ' + (turn + 1) + ' did not finish');
+        break;
+      }
+      await sleep(UI_SETTLE_TIME);
+    }
+  } finally {
+    logs.stop();
+  }
+
+  return report.summarize(platform, report.parseLog(logs.lines), mock.requests.slice(firstRequest));
+}
+
+async function main() {
+  var cliOptions = Object.assign({
+    platforms: { type: 'string' },
+    turns: { type: 'string' },
+    stream: { type: 'boolean' },
+    'skip-build': { type: 'boolean' },
+    out: { type: 'string' }
+  }, mockApi.CLI_OPTIONS);
+  var values = util.parseArgs({ options: cliOptions }).values;
+  var options = {
+    platforms: values.platforms ? values.platforms.split(',') : DEFAULT_PLATFORMS,
+    turns: Number(values.turns || DEFAULT_TURNS),
+    stream: !!values.stream
+  };
+
+  if (!values['skip-build']) {
+    pebble(['build']);
+  }
+
+  var mock = mockApi.createMockApi(mockApi.mockOptionsFromCli(values));
+  await new Promise(function (resolve) {
+    mock.listen(Number(values.port || mockApi.DEFAULT_PORT), resolve);
+  });
+
+  var summaries = [];
+  try {
+    for (var i = 0; i < options.platforms.length; i++) {
+      summaries.push(await runPlatform(options.platforms[i], options, mock));
+      pebble(['kill']);
+    }
+  } finally {
+    mock.close();
+  }
+
+  console.log(report.formatReport(summaries));
+  if (values.out) {
+    fs.writeFileSync(values.out, JSON.stringify({ options: options, summaries: summaries }, null, 2) + '\n');
+  }
+}
+
+main().catch(function (e) {
+  console.error(e.message);
+  process.exit(1);
+});
@@ -0,0 +1,143 @@
+#include <time.h>
+#include "chat_driver.h"
+
+/**
+ * Chat window benchmarks: the work done on the watch for common sessions,
+ * as operation counts from the fake SDK (which track the watch's costs
+ * independently of the host) and host wall time.
+ */
+
+#define TURN_COUNT 50
+#define STREAM_BYTES 2048
+#define STREAM_DELTA 20
+#define STREAM_INTERVAL 50
+
+static const char *s_words[] = {
+  "the", "watch", "answers", "quickly", "while", "text", "keeps", "arriving", "from", "phone",
+  "and", "every", "bubble", "wraps", "across", "several", "lines", "of", "a", "small", "screen",
+};
+
+static double s_start_seconds;
+
+// Private helper functions
+
+static double wall_seconds(void) {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+static void make_text(char *text, size_t length, unsigned seed) {
+  size_t used = 0;
+  while (used < length) {
+    const char *word = s_words[seed++ % ARRAY_LENGTH(s_words)];
+    seed = seed * 1103515245 + 12345;
+    used += snprintf(text + used, length - used + 1, "%s%s", used ? " " : "", word);
+  }
+  text[length] = '\0';
+}
+
+static void begin(void) {
+  fake_counters_clear();
+  s_start_seconds = wall_seconds();
+}
+
+static void report(const char *name, int operations) {
+  double elapsed_ms = (wall_seconds() - s_start_seconds) * 1000;
+  FakeCounters counters = fake_counters();
+  printf("%s\n", name);
+  printf("  wall time          %8.2f ms (%.1f us per operation)\n", elapsed_ms, elapsed_ms * 1000 / operations);
+  printf("  text measured      %8d calls %8zu bytes\n", counters.text_measures, counters.text_measure_bytes);
+  printf("  text drawn         %8d calls %8zu bytes\n", counters.text_draws, counters.text_draw_bytes);
+  printf("  layers drawn       %8d (%d created, %d alive)\n",
+         counters.layer_redraws, counters.layers_created, counters.layers_alive);
+  printf("  heap               %8zu bytes used, peak %zu, %d mallocs\n",
+         counters.heap_used, counters.heap_peak, counters.mallocs);
+  printf("  storage            %8d writes %7zu bytes, %d reads\n",
+         counters.persist_writes, counters.persist_write_bytes, counters.persist_reads);
+  printf("  AppMessage out     %8d sends %8zu bytes\n", counters.outbox_sends, counters.outbox_bytes);
+}
+
+// Benchmarks
+
+static void bench_add_messages(void) {
+  chat_driver_launch();
+
+  char text[256];
+  begin();
+  for (int turn = 0; turn < TURN_COUNT; turn++) {
+    make_text(text, 40, turn);
+    chat_driver_say(text);
+    make_text(text, 200, turn + 1000);
+    chat_driver_respond(text, 0, 0);
+    fake_render(NULL, 0);
+  }
+  report("add 100 messages (50 turns, redraw after each)", 2 * TURN_COUNT);
+
+  chat_driver_close();
+}
+
+static void bench_stream_response(void) {
+  chat_driver_launch();
+  chat_driver_say("Tell me a long story");
+
+  static char text[STREAM_BYTES + 1];
+  make_text(text, STREAM_BYTES, 7);
+
+  // Each delta is followed by a redraw if the frame timer ran
+  begin();
+  char chunk[STREAM_DELTA + 1];
+  for (size_t offset = 0; offset < STREAM_BYTES; offset += STREAM_DELTA) {
+    size_t length = STREAM_BYTES - offset < STREAM_DELTA ? STREAM_BYTES - offset : STREAM_DELTA;
+    memcpy(chunk, text + offset, length);
+    chunk[length] = '\0';
+    chat_driver_send_cstring(MESSAGE_KEY_RESPONSE_TEXT, chunk);
+    fake_advance(STREAM_INTERVAL);
+    fake_render(NULL, 0);
+  }
+  chat_driver_respond("", 0, 0);
+  report("stream 2 KB in 20-byte deltas (50 ms apart)", (STREAM_BYTES + STREAM_DELTA - 1) / STREAM_DELTA);
+
+  chat_driver_close();
+}
+
+static void bench_scroll_history(void) {
+  chat_driver_launch();
+  char text[600];
+  for (int turn = 0; turn < TURN_COUNT; turn++) {
+    make_text(text, 40, turn);
+    chat_driver_say(text);
+    make_text(text, turn % 5 == 0 ? 580 : 200, turn + 1000);
+    chat_driver_respond(text, 0, 0);
+  }
+
+  // Step to the top and back down, redrawing after every step
+  begin();
+  int steps = 0;
+  char screen[2048];
+  char previous[2048] = "";
+  for (ButtonId button = BUTTON_ID_UP; button <= BUTTON_ID_DOWN; button += BUTTON_ID_DOWN - BUTTON_ID_UP) {
+    while (steps < 2000) {
+      fake_click(button, false, 1);
+      fake_render(screen, sizeof(screen));
+      steps++;
+      if (strcmp(screen, previous) == 0) {
+        break;
+      }
+      strcpy(previous, screen);
+    }
+  }
+  report("scroll through full history (top and back)", steps);
+
+  chat_driver_close();
+}
+
+int main(void) {
+  fake_reset();
+  bench_add_messages();
+  fake_reset();
+  bench_stream_response();
+  fake_reset();
+  bench_scroll_history();
+  return 0;
+}
@@ -0,0 +1,96 @@
+#include "chat_driver.h"
+#include "chat_window.h"
+#include "claude_spark.h"
+#include "conversation_codec.h"
+#include "memory_profile.h"
+
+#define INBOX_BUFFER_SIZE (APP_MESSAGE_INBOX_SIZE + 64)
+
+static Window *s_chat_window;
+
+// Private helper functions
+
+static void outbox_failed_callback(DictionaryIterator *iterator, AppMessageResult reason, void *context) {
+  chat_window_handle_outbox_failed(iterator);
+}
+
+static uint32_t sent_request_id(void) {
+  DictionaryIterator *iter = fake_outbox_last();
+  Tuple *request = iter ? dict_find(iter, MESSAGE_KEY_REQUEST_CHAT) : NULL;
+  ConversationDecoder decoder;
+  if (!request || !conversation_decoder_init(&decoder, request->value->data, request->length)) {
+    return 0;
+  }
+  return decoder.request_id;
+}
+
+static void send_message(uint32_t key, const char *text, size_t length, bool end) {
+  static uint8_t buffer[INBOX_BUFFER_SIZE];
+  DictionaryIterator iter;
+  fake_dict_begin(&iter, buffer, sizeof(buffer));
+  if (key) {
+    char chunk[APP_MESSAGE_INBOX_SIZE];
+    memcpy(chunk, text, length);
+    chunk[length] = '\0';
+    dict_write_cstring(&iter, key, chunk);
+  }
+  if (end) {
+    dict_write_uint8(&iter, MESSAGE_KEY_RESPONSE_END, 1);
+  }
+  chat_window_handle_inbox(&iter);
+}
+
+// Public API
+
+void chat_driver_launch(void) {
+  claude_spark_init();
+  app_message_register_outbox_failed(outbox_failed_callback);
+  app_message_open(APP_MESSAGE_INBOX_SIZE, APP_MESSAGE_OUTBOX_SIZE);
+
+  s_chat_window = chat_window_create();
+  window_stack_push(s_chat_window, false);
+}
+
+void chat_driver_close(void) {
+  window_stack_remove(s_chat_window, false);
+  chat_window_destroy(s_chat_window);
+  s_chat_window = NULL;
+  claude_spark_deinit();
+}
+
+uint32_t chat_driver_say(const char *text) {
+  uint32_t previous_id = sent_request_id();
+  if (!fake_dictation_is_running()) {
+    fake_click(BUTTON_ID_SELECT, false, 1);
+  }
+  if (!fake_dictation_is_running()) {
+    // Select opened the suggestions instead: the first one is "Reply by voice"
+    fake_click(BUTTON_ID_SELECT, false, 1);
+  }
+  fake_advance(CHAT_DRIVER_SPEAKING_MS);
+  if (!fake_dictation_finish(text)) {
+    return 0;
+  }
+
+  fake_advance(FAKE_OUTBOX_ACK_DELAY);
+  uint32_t request_id = sent_request_id();
+  return request_id != previous_id ? request_id : 0;
+}
+
+void chat_driver_send_cstring(uint32_t key, const char *text) {
+  send_message(key, text, strlen(text), false);
+}
+
+void chat_driver_respond(const char *text, size_t chunk_size, uint32_t interval_ms) {
+  size_t length = strlen(text);
+  if (chunk_size == 0 || chunk_size > APP_MESSAGE_INBOX_SIZE - 1) {
+    chunk_size = APP_MESSAGE_INBOX_SIZE - 1;
+  }
+
+  for (size_t offset = 0; offset < length; offset += chunk_size) {
+    size_t chunk = length - offset < chunk_size ? length - offset : chunk_size;
+    send_message(MESSAGE_KEY_RESPONSE_TEXT, text + offset, chunk, false);
+    fake_advance(interval_ms);
+  }
+  send_message(0, NULL, 0, true);
+}
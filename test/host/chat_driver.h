@@ -0,0 +1,46 @@
+#pragma once
+#include "fake_pebble.h"
+
+/**
+ * Chat Driver
+ *
+ * Plays the user and the phone against the chat window on the fake SDK:
+ * launches the app the way claude-for-pebble.c does, dictates turns, and
+ * answers requests with responses streamed in chunks.
+ */
+
+// Time the user takes to speak a turn (the prewarm message is acked meanwhile)
+#define CHAT_DRIVER_SPEAKING_MS 1500
+
+/**
+ * Open AppMessage and push the chat window (which starts dictation).
+ */
+void chat_driver_launch(void);
+
+/**
+ * Pop and destroy the chat window (the conversation is saved).
+ */
+void chat_driver_close(void);
+
+/**
+ * Speak a turn: presses Select unless dictation is already running (and
+ * picks "Reply by voice" if suggestions were offered), then finishes dictation.
+ * @param text The transcription
+ * @return The request ID of the REQUEST_CHAT sent for the turn, or 0 if none was sent
+ */
+uint32_t chat_driver_say(const char *text);
+
+/**
+ * Send a message with one string to the chat window.
+ * @param key Message key
+ * @param text The string
+ */
+void chat_driver_send_cstring(uint32_t key, const char *text);
+
+/**
+ * Answer the request in flight: the text in RESPONSE_TEXT chunks, then RESPONSE_END.
+ * @param text The response
+ * @param chunk_size Bytes per chunk (0 for the whole response in one chunk)
+ * @param interval_ms Time between chunks
+ */
+void chat_driver_respond(const char *text, size_t chunk_size, uint32_t interval_ms);
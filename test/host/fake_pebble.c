@@ -0,0 +1,1678 @@
+#include <math.h>
+#include <stdarg.h>
+#include "fake_pebble.h"
+
+// The fake heap allocates from the host heap
+#undef malloc
+#undef calloc
+#undef free
+
+#define MAX_WINDOWS 8
+#define MAX_TIMERS 64
+#define MAX_PERSIST_KEYS 256
+#define DEFAULT_APP_MESSAGE_SIZE 4096
+#define DEFAULT_MENU_CELL_HEIGHT 44
+#define MESSAGE_KEY_BASE 10000
+
+// Bookkeeping in front of every fake heap block (about what the watch's
+// allocator spends per block)
+typedef struct {
+  size_t size;
+  uint32_t generation;
+  uint32_t padding;
+} BlockHeader;
+
+// Fonts are measured with fixed metrics per font: average glyph advance and
+// line height
+typedef struct FakeFont {
+  const char *key;
+  int char_width;
+  int line_height;
+} FakeFont;
+
+struct GContext {
+  GPoint offset;
+  GRect clip;
+};
+
+struct GBitmap {
+  GSize size;
+};
+
+struct Layer {
+  GRect frame;
+  GRect bounds;
+  Layer *parent;
+  Layer *first_child;
+  Layer *next_sibling;
+  LayerUpdateProc update_proc;
+  Window *window;
+  bool hidden;
+  void *data;
+};
+
+struct TextLayer {
+  Layer layer;
+  const char *text;
+  GFont font;
+  GTextAlignment alignment;
+  GTextOverflowMode overflow_mode;
+};
+
+struct ScrollLayer {
+  Layer layer;
+  Layer content;
+};
+
+struct StatusBarLayer {
+  Layer layer;
+};
+
+struct MenuLayer {
+  Layer layer;
+  MenuLayerCallbacks callbacks;
+  void *context;
+  MenuIndex selected;
+};
+
+struct ActionBarLayer {
+  Layer layer;
+  ClickConfigProvider click_config_provider;
+  const GBitmap *icons[NUM_BUTTONS];
+};
+
+typedef struct {
+  ClickHandler single;
+  ClickHandler multi;
+  uint8_t multi_min_clicks;
+  uint8_t multi_max_clicks;
+  ClickHandler long_down;
+  ClickHandler long_up;
+} ClickSubscription;
+
+struct Window {
+  Layer root;
+  WindowHandlers handlers;
+  ClickConfigProvider click_config_provider;
+  void *click_context;
+  ClickSubscription clicks[NUM_BUTTONS];
+  ActionBarLayer *action_bar;
+  bool loaded;
+};
+
+typedef struct {
+  ButtonId button_id;
+  bool repeating;
+  uint8_t clicks;
+} ClickRecognizer;
+
+struct AppTimer {
+  bool used;
+  uint32_t due_ms;
+  uint32_t sequence;
+  AppTimerCallback callback;
+  void *data;
+};
+
+struct DictationSession {
+  DictationSessionStatusCallback callback;
+  void *context;
+  bool running;
+};
+
+struct GDrawCommandSequence {
+  GSize bounds;
+  uint32_t frame_count;
+};
+
+struct GDrawCommandFrame {
+  uint32_t duration;
+};
+
+struct GDrawCommandList {
+  uint32_t command_count;
+};
+
+typedef struct {
+  bool used;
+  uint32_t key;
+  uint16_t size;
+  uint8_t data[PERSIST_DATA_MAX_LENGTH];
+} PersistEntry;
+
+uint32_t MESSAGE_KEY_REQUEST_CHAT = MESSAGE_KEY_BASE + 0;
+uint32_t MESSAGE_KEY_RESPONSE_TEXT = MESSAGE_KEY_BASE + 1;
+uint32_t MESSAGE_KEY_RESPONSE_END = MESSAGE_KEY_BASE + 2;
+uint32_t MESSAGE_KEY_READY_STATUS = MESSAGE_KEY_BASE + 3;
+uint32_t MESSAGE_KEY_THREAD_ID = MESSAGE_KEY_BASE + 4;
+uint32_t MESSAGE_KEY_THREAD_REQUEST = MESSAGE_KEY_BASE + 5;
+uint32_t MESSAGE_KEY_THREAD_DATA = MESSAGE_KEY_BASE + 6;
+uint32_t MESSAGE_KEY_REQUEST_ID = MESSAGE_KEY_BASE + 7;
+uint32_t MESSAGE_KEY_SUGGESTIONS = MESSAGE_KEY_BASE + 8;
+uint32_t MESSAGE_KEY_PREWARM = MESSAGE_KEY_BASE + 9;
+uint32_t MESSAGE_KEY_DICTATION_CONFIRM = MESSAGE_KEY_BASE + 10;
+uint32_t MESSAGE_KEY_INBOX_SIZE = MESSAGE_KEY_BASE + 11;
+uint32_t MESSAGE_KEY_STATUS_TEXT = MESSAGE_KEY_BASE + 12;
+
+static FakeFont s_fonts[] = {
+  { FONT_KEY_GOTHIC_18, 7, 22 },  // Fallback for fonts not listed
+  { FONT_KEY_GOTHIC_14, 6, 16 },
+  { FONT_KEY_GOTHIC_14_BOLD, 6, 16 },
+  { FONT_KEY_GOTHIC_18_BOLD, 8, 22 },
+  { FONT_KEY_GOTHIC_24_BOLD, 10, 28 },
+};
+
+static FakeCounters s_counters;
+static size_t s_heap_size = FAKE_HEAP_SIZE;
+static uint32_t s_heap_generation = 1;
+static bool s_log_output = false;
+static uint32_t s_now_ms = 0;
+
+static Window *s_window_stack[MAX_WINDOWS];
+static int s_window_count = 0;
+static Window *s_configuring_window;
+
+static struct AppTimer s_timers[MAX_TIMERS];
+static uint32_t s_timer_sequence = 0;
+
+static DictationSession *s_dictation;
+
+static PersistEntry s_persist[MAX_PERSIST_KEYS];
+
+// Text collected by fake_render
+static char *s_render_text;
+static size_t s_render_size;
+static size_t s_render_length;
+
+// AppMessage
+static AppMessageInboxReceived s_inbox_received;
+static AppMessageInboxDropped s_inbox_dropped;
+static AppMessageOutboxSent s_outbox_sent;
+static AppMessageOutboxFailed s_outbox_failed;
+static uint8_t *s_inbox_buffer;
+static uint8_t *s_outbox_buffer;
+static uint32_t s_outbox_size = DEFAULT_APP_MESSAGE_SIZE;
+static DictionaryIterator s_outbox_iter;
+static bool s_outbox_pending = false;
+static uint32_t s_outbox_due_ms;
+static bool s_outbox_delivered = true;
+static uint8_t *s_last_message;
+static DictionaryIterator s_last_iter;
+
+static ConnectionHandlers s_connection_handlers;
+static bool s_connected = true;
+static SniffInterval s_sniff_interval = SNIFF_INTERVAL_NORMAL;
+
+// Private helper functions
+
+static bool rect_is_empty(GRect rect) {
+  return rect.size.w <= 0 || rect.size.h <= 0;
+}
+
+static GRect rect_intersect(GRect a, GRect b) {
+  int x0 = a.origin.x > b.origin.x ? a.origin.x : b.origin.x;
+  int y0 = a.origin.y > b.origin.y ? a.origin.y : b.origin.y;
+  int x1 = a.origin.x + a.size.w < b.origin.x + b.size.w ? a.origin.x + a.size.w : b.origin.x + b.size.w;
+  int y1 = a.origin.y + a.size.h < b.origin.y + b.size.h ? a.origin.y + a.size.h : b.origin.y + b.size.h;
+  return GRect(x0, y0, x1 - x0, y1 - y0);
+}
+
+static void layer_init(Layer *layer, GRect frame) {
+  *layer = (Layer) {
+    .frame = frame,
+    .bounds = GRect(0, 0, frame.size.w, frame.size.h),
+  };
+}
+
+static void* layer_alloc(size_t size, GRect frame) {
+  Layer *layer = fake_calloc(1, size);
+  if (layer) {
+    layer_init(layer, frame);
+    s_counters.layers_created++;
+    s_counters.layers_alive++;
+  }
+  return layer;
+}
+
+static void layer_release(Layer *layer) {
+  if (!layer) {
+    return;
+  }
+  layer_remove_from_parent(layer);
+  while (layer->first_child) {
+    layer_remove_from_parent(layer->first_child);
+  }
+  s_counters.layers_alive--;
+  fake_free(layer);
+}
+
+static void collect_text(const char *text, GRect box, GContext *ctx) {
+  if (!s_render_text || !text) {
+    return;
+  }
+
+  // Only text that shows on screen
+  GRect screen_box = GRect(box.origin.x + ctx->offset.x, box.origin.y + ctx->offset.y, box.size.w, box.size.h);
+  if (rect_is_empty(rect_intersect(screen_box, ctx->clip))) {
+    return;
+  }
+
+  // Each line starts with the screen position of the text
+  int prefix = snprintf(s_render_text + s_render_length, s_render_size - s_render_length,
+                        "%4d ", screen_box.origin.y);
+  s_render_length += prefix;
+  if (s_render_length >= s_render_size) {
+    s_render_length = s_render_size - 1;
+    return;
+  }
+
+  for (const char *c = text; *c && s_render_length + 2 < s_render_size; c++) {
+    s_render_text[s_render_length++] = *c == '\n' ? ' ' : *c;
+  }
+  if (s_render_length + 1 < s_render_size) {
+    s_render_text[s_render_length++] = '\n';
+  }
+  s_render_text[s_render_length] = '\0';
+}
+
+// Greedy word wrap: a word that does not fit goes to the next line, a word
+// longer than a line is broken
+static GSize measure_text(const char *text, const FakeFont *font, int width) {
+  int columns = width / font->char_width;
+  if (!text || !*text || columns <= 0) {
+    return GSize(0, 0);
+  }
+
+  int lines = 1;
+  int column = 0;
+  int widest = 0;
+  const char *c = text;
+  while (*c) {
+    if (*c == '\n') {
+      lines++;
+      column = 0;
+      c++;
+      continue;
+    }
+    if (*c == ' ') {
+      if (column < columns) {
+        column++;
+      }
+      c++;
+      continue;
+    }
+
+    int word = 0;
+    while (c[word] && c[word] != ' ' && c[word] != '\n') {
+      word++;
+    }
+    if (column > 0 && column + word > columns) {
+      lines++;
+      column = 0;
+    }
+    while (word > columns - column) {
+      word -= columns - column;
+      c += columns - column;
+      lines++;
+      column = 0;
+    }
+    column += word;
+    c += word;
+    if (column > widest) {
+      widest = column;
+    }
+  }
+
+  return GSize(widest * font->char_width, lines * font->line_height);
+}
+
+static void draw_layer(Layer *layer, GPoint origin, GRect clip, GContext *ctx) {
+  if (layer->hidden) {
+    return;
+  }
+
+  GRect frame = GRect(origin.x + layer->frame.origin.x, origin.y + layer->frame.origin.y,
+                      layer->frame.size.w, layer->frame.size.h);
+  clip = rect_intersect(clip, frame);
+  if (rect_is_empty(clip)) {
+    return;
+  }
+
+  GPoint content_origin = GPoint(frame.origin.x + layer->bounds.origin.x, frame.origin.y + layer->bounds.origin.y);
+  if (layer->update_proc) {
+    ctx->offset = content_origin;
+    ctx->clip = clip;
+    s_counters.layer_redraws++;
+    layer->update_proc(layer, ctx);
+  }
+
+  for (Layer *child = layer->first_child; child; child = child->next_sibling) {
+    draw_layer(child, content_origin, clip, ctx);
+  }
+}
+
+static void text_layer_update_proc(Layer *layer, GContext *ctx) {
+  TextLayer *text_layer = (TextLayer *)layer;
+  graphics_draw_text(ctx, text_layer->text, text_layer->font, layer->bounds,
+                     text_layer->overflow_mode, text_layer->alignment, NULL);
+}
+
+static int16_t menu_cell_height(MenuLayer *menu_layer, MenuIndex *index) {
+  if (menu_layer->callbacks.get_cell_height) {
+    return menu_layer->callbacks.get_cell_height(menu_layer, index, menu_layer->context);
+  }
+  return DEFAULT_MENU_CELL_HEIGHT;
+}
+
+static uint16_t menu_row_count(MenuLayer *menu_layer, uint16_t section) {
+  if (!menu_layer->callbacks.get_num_rows) {
+    return 0;
+  }
+  return menu_layer->callbacks.get_num_rows(menu_layer, section, menu_layer->context);
+}
+
+static uint16_t menu_section_count(MenuLayer *menu_layer) {
+  if (menu_layer->callbacks.get_num_sections) {
+    return menu_layer->callbacks.get_num_sections(menu_layer, menu_layer->context);
+  }
+  return 1;
+}
+
+// Draw the rows of the menu, scrolled so that the selected row shows
+static void menu_layer_update_proc(Layer *layer, GContext *ctx) {
+  MenuLayer *menu_layer = (MenuLayer *)layer;
+  int height = layer->bounds.size.h;
+
+  int selected_bottom = 0;
+  int y = 0;
+  for (uint16_t section = 0; section < menu_section_count(menu_layer); section++) {
+    for (uint16_t row = 0; row < menu_row_count(menu_layer, section); row++) {
+      MenuIndex index = { section, row };
+      y += menu_cell_height(menu_layer, &index);
+      if (section == menu_layer->selected.section && row == menu_layer->selected.row) {
+        selected_bottom = y;
+      }
+    }
+  }
+  int scroll = selected_bottom > height ? selected_bottom - height : 0;
+
+  GPoint origin = ctx->offset;
+  y = 0;
+  for (uint16_t section = 0; section < menu_section_count(menu_layer); section++) {
+    for (uint16_t row = 0; row < menu_row_count(menu_layer, section); row++) {
+      MenuIndex index = { section, row };
+      int cell_height = menu_cell_height(menu_layer, &index);
+      if (y + cell_height > scroll && y < scroll + height && menu_layer->callbacks.draw_row) {
+        Layer cell;
+        layer_init(&cell, GRect(0, y - scroll, layer->bounds.size.w, cell_height));
+        ctx->offset = GPoint(origin.x, origin.y + y - scroll);
+        menu_layer->callbacks.draw_row(ctx, &cell, &index, menu_layer->context);
+      }
+      y += cell_height;
+    }
+  }
+  ctx->offset = origin;
+}
+
+static void menu_move(MenuLayer *menu_layer, int delta) {
+  int rows = menu_row_count(menu_layer, menu_layer->selected.section);
+  int row = menu_layer->selected.row + delta;
+  if (row >= 0 && row < rows) {
+    menu_layer->selected.row = row;
+  }
+}
+
+static void menu_up_handler(ClickRecognizerRef recognizer, void *context) {
+  menu_move(context, -1);
+}
+
+static void menu_down_handler(ClickRecognizerRef recognizer, void *context) {
+  menu_move(context, 1);
+}
+
+static void menu_select_handler(ClickRecognizerRef recognizer, void *context) {
+  MenuLayer *menu_layer = context;
+  if (menu_layer->callbacks.select_click && menu_row_count(menu_layer, menu_layer->selected.section) > 0) {
+    menu_layer->callbacks.select_click(menu_layer, &menu_layer->selected, menu_layer->context);
+  }
+}
+
+static void menu_click_config_provider(void *context) {
+  window_single_repeating_click_subscribe(BUTTON_ID_UP, 100, menu_up_handler);
+  window_single_repeating_click_subscribe(BUTTON_ID_DOWN, 100, menu_down_handler);
+  window_single_click_subscribe(BUTTON_ID_SELECT, menu_select_handler);
+}
+
+// Subscribe the clicks of the window that just came to the top
+static void configure_clicks(Window *window) {
+  memset(window->clicks, 0, sizeof(window->clicks));
+  s_configuring_window = window;
+  if (window->action_bar && window->action_bar->click_config_provider) {
+    window->action_bar->click_config_provider(window->click_context);
+  } else if (window->click_config_provider) {
+    window->click_config_provider(window->click_context);
+  }
+  s_configuring_window = NULL;
+}
+
+static void window_came_to_top(Window *window) {
+  if (!window->loaded) {
+    window->loaded = true;
+    if (window->handlers.load) {
+      window->handlers.load(window);
+    }
+  }
+  if (window->handlers.appear) {
+    window->handlers.appear(window);
+  }
+  configure_clicks(window);
+}
+
+static void window_unload(Window *window, bool visible) {
+  if (visible && window->handlers.disappear) {
+    window->handlers.disappear(window);
+  }
+  if (window->loaded) {
+    window->loaded = false;
+    if (window->handlers.unload) {
+      window->handlers.unload(window);
+    }
+  }
+}
+
+static struct AppTimer* next_due_timer(uint32_t until_ms) {
+  struct AppTimer *next = NULL;
+  for (int i = 0; i < MAX_TIMERS; i++) {
+    struct AppTimer *timer = &s_timers[i];
+    if (!timer->used || timer->due_ms > until_ms) {
+      continue;
+    }
+    if (!next || timer->due_ms < next->due_ms ||
+        (timer->due_ms == next->due_ms && timer->sequence < next->sequence)) {
+      next = timer;
+    }
+  }
+  return next;
+}
+
+static size_t dict_tuple_size(const Tuple *tuple) {
+  return sizeof(Tuple) + tuple->length;
+}
+
+static DictionaryResult dict_write(DictionaryIterator *iter, uint32_t key, TupleType type,
+                                   const void *data, uint16_t size) {
+  if (!iter || !iter->buffer) {
+    return DICT_INVALID_ARGS;
+  }
+  if (iter->length + sizeof(Tuple) + size > iter->size) {
+    return DICT_NOT_ENOUGH_STORAGE;
+  }
+
+  Tuple *tuple = (Tuple *)(iter->buffer + iter->length);
+  tuple->key = key;
+  tuple->type = type;
+  tuple->length = size;
+  memcpy(tuple->value->data, data, size);
+  iter->length += sizeof(Tuple) + size;
+  iter->buffer[0]++;
+  return DICT_OK;
+}
+
+// Deliver the pending outbound message to the sent or failed callback
+static void outbox_finish(void) {
+  s_outbox_pending = false;
+
+  // The callbacks may send again, so they get a copy of the message
+  DictionaryIterator iter = s_outbox_iter;
+  uint8_t *copy = malloc(s_outbox_iter.length);
+  memcpy(copy, s_outbox_iter.buffer, s_outbox_iter.length);
+  iter.buffer = copy;
+  iter.size = iter.length;
+
+  if (s_outbox_delivered && s_connected) {
+    if (s_outbox_sent) {
+      s_outbox_sent(&iter, NULL);
+    }
+  } else if (s_outbox_failed) {
+    s_outbox_failed(&iter, APP_MSG_NOT_CONNECTED, NULL);
+  }
+  free(copy);
+}
+
+static PersistEntry* persist_find(uint32_t key) {
+  for (int i = 0; i < MAX_PERSIST_KEYS; i++) {
+    if (s_persist[i].used && s_persist[i].key == key) {
+      return &s_persist[i];
+    }
+  }
+  return NULL;
+}
+
+// Public API: fake controls
+
+void fake_reset(void) {
+  // Blocks from before the reset are freed without being counted
+  s_heap_generation++;
+  memset(&s_counters, 0, sizeof(s_counters));
+  s_heap_size = FAKE_HEAP_SIZE;
+  s_now_ms = 0;
+
+  memset(s_window_stack, 0, sizeof(s_window_stack));
+  s_window_count = 0;
+  memset(s_timers, 0, sizeof(s_timers));
+  s_dictation = NULL;
+  memset(s_persist, 0, sizeof(s_persist));
+
+  s_inbox_received = NULL;
+  s_inbox_dropped = NULL;
+  s_outbox_sent = NULL;
+  s_outbox_failed = NULL;
+  s_inbox_buffer = NULL;
+  s_outbox_buffer = NULL;
+  s_outbox_size = DEFAULT_APP_MESSAGE_SIZE;
+  s_outbox_pending = false;
+  s_outbox_delivered = true;
+  free(s_last_message);
+  s_last_message = NULL;
+
+  memset(&s_connection_handlers, 0, sizeof(s_connection_handlers));
+  s_connected = true;
+  s_sniff_interval = SNIFF_INTERVAL_NORMAL;
+}
+
+FakeCounters fake_counters(void) {
+  return s_counters;
+}
+
+void fake_counters_clear(void) {
+  size_t heap_used = s_counters.heap_used;
+  memset(&s_counters, 0, sizeof(s_counters));
+  s_counters.heap_used = heap_used;
+  s_counters.heap_peak = heap_used;
+}
+
+void fake_set_heap_size(size_t size) {
+  s_heap_size = size;
+}
+
+void fake_set_log_output(bool enabled) {
+  s_log_output = enabled;
+}
+
+uint32_t fake_now_ms(void) {
+  return s_now_ms;
+}
+
+void fake_advance(uint32_t ms) {
+  uint32_t until_ms = s_now_ms + ms;
+
+  while (true) {
+    struct AppTimer *timer = next_due_timer(until_ms);
+    bool outbox_due = s_outbox_pending && s_outbox_due_ms <= until_ms;
+    if (!timer && !outbox_due) {
+      break;
+    }
+
+    if (outbox_due && (!timer || s_outbox_due_ms <= timer->due_ms)) {
+      s_now_ms = s_outbox_due_ms > s_now_ms ? s_outbox_due_ms : s_now_ms;
+      outbox_finish();
+      continue;
+    }
+
+    s_now_ms = timer->due_ms > s_now_ms ? timer->due_ms : s_now_ms;
+    timer->used = false;
+    s_counters.timers_fired++;
+    timer->callback(timer->data);
+  }
+
+  s_now_ms = until_ms;
+}
+
+void fake_render(char *text, size_t size) {
+  if (text && size > 0) {
+    text[0] = '\0';
+  }
+  Window *window = window_stack_get_top_window();
+  if (!window) {
+    return;
+  }
+
+  s_render_text = size > 0 ? text : NULL;
+  s_render_size = size;
+  s_render_length = 0;
+
+  GContext ctx = { .clip = GRect(0, 0, FAKE_SCREEN_WIDTH, FAKE_SCREEN_HEIGHT) };
+  draw_layer(&window->root, GPoint(0, 0), ctx.clip, &ctx);
+  s_render_text = NULL;
+}
+
+void fake_click(ButtonId button_id, bool repeating, uint8_t clicks) {
+  Window *window = window_stack_get_top_window();
+  if (!window) {
+    return;
+  }
+
+  ClickSubscription *subscription = &window->clicks[button_id];
+  ClickRecognizer recognizer = { button_id, repeating, clicks };
+  if (clicks >= 2 && subscription->multi &&
+      clicks >= subscription->multi_min_clicks && clicks <= subscription->multi_max_clicks) {
+    subscription->multi(&recognizer, window->click_context);
+  } else if (subscription->single) {
+    subscription->single(&recognizer, window->click_context);
+  } else if (button_id == BUTTON_ID_BACK) {
+    window_stack_pop(true);
+  }
+}
+
+void fake_long_click(ButtonId button_id) {
+  Window *window = window_stack_get_top_window();
+  if (!window) {
+    return;
+  }
+
+  ClickSubscription *subscription = &window->clicks[button_id];
+  ClickRecognizer recognizer = { button_id, false, 1 };
+  if (subscription->long_down) {
+    subscription->long_down(&recognizer, window->click_context);
+  }
+  if (subscription->long_up) {
+    subscription->long_up(&recognizer, window->click_context);
+  }
+}
+
+bool fake_dictation_is_running(void) {
+  return s_dictation && s_dictation->running;
+}
+
+bool fake_dictation_finish(const char *transcription) {
+  DictationSession *session = s_dictation;
+  if (!session || !session->running) {
+    return false;
+  }
+
+  session->running = false;
+  s_dictation = NULL;
+
+  char text[512] = "";
+  if (transcription) {
+    strncpy(text, transcription, sizeof(text) - 1);
+  }
+  session->callback(session,
+                    transcription ? DictationSessionStatusSuccess : DictationSessionStatusFailureNoSpeechDetected,
+                    transcription ? text : NULL, session->context);
+  return true;
+}
+
+SniffInterval fake_sniff_interval(void) {
+  return s_sniff_interval;
+}
+
+void fake_set_connected(bool connected) {
+  if (connected == s_connected) {
+    return;
+  }
+
+  s_connected = connected;
+  if (s_connection_handlers.pebble_app_connection_handler) {
+    s_connection_handlers.pebble_app_connection_handler(connected);
+  }
+  if (s_connection_handlers.pebblekit_connection_handler) {
+    s_connection_handlers.pebblekit_connection_handler(connected);
+  }
+}
+
+void fake_outbox_set_delivered(bool delivered) {
+  s_outbox_delivered = delivered;
+}
+
+DictionaryIterator* fake_outbox_last(void) {
+  return s_last_message ? &s_last_iter : NULL;
+}
+
+void fake_dict_begin(DictionaryIterator *iter, uint8_t *buffer, size_t size) {
+  *iter = (DictionaryIterator) {
+    .buffer = buffer,
+    .size = size,
+    .length = 1,
+  };
+  buffer[0] = 0;
+}
+
+size_t fake_persist_bytes(void) {
+  size_t total = 0;
+  for (int i = 0; i < MAX_PERSIST_KEYS; i++) {
+    if (s_persist[i].used) {
+      total += s_persist[i].size;
+    }
+  }
+  return total;
+}
+
+// Public API: heap
+
+void* fake_malloc(size_t size) {
+  size_t block_size = sizeof(BlockHeader) + size;
+  if (s_counters.heap_used + block_size > s_heap_size) {
+    s_counters.failed_mallocs++;
+    return NULL;
+  }
+
+  BlockHeader *header = malloc(block_size);
+  if (!header) {
+    return NULL;
+  }
+  header->size = block_size;
+  header->generation = s_heap_generation;
+
+  s_counters.mallocs++;
+  s_counters.heap_used += block_size;
+  if (s_counters.heap_used > s_counters.heap_peak) {
+    s_counters.heap_peak = s_counters.heap_used;
+  }
+  return header + 1;
+}
+
+void* fake_calloc(size_t count, size_t size) {
+  void *ptr = fake_malloc(count * size);
+  if (ptr) {
+    memset(ptr, 0, count * size);
+  }
+  return ptr;
+}
+
+void fake_free(void *ptr) {
+  if (!ptr) {
+    return;
+  }
+
+  BlockHeader *header = (BlockHeader *)ptr - 1;
+  if (header->generation == s_heap_generation) {
+    s_counters.frees++;
+    s_counters.heap_used -= header->size;
+  }
+  free(header);
+}
+
+size_t heap_bytes_free(void) {
+  return s_heap_size - s_counters.heap_used;
+}
+
+size_t heap_bytes_used(void) {
+  return s_counters.heap_used;
+}
+
+// Public API: logging
+
+void app_log(uint8_t log_level, const char *src_filename, int src_line_number, const char *fmt, ...) {
+  s_counters.logs++;
+  if (!s_log_output) {
+    return;
+  }
+
+  va_list args;
+  va_start(args, fmt);
+  fprintf(stderr, "[%d] %s:%d ", log_level, src_filename, src_line_number);
+  vfprintf(stderr, fmt, args);
+  fprintf(stderr, "\n");
+  va_end(args);
+}
+
+// Public API: graphics
+
+GFont fonts_get_system_font(const char *font_key) {
+  for (size_t i = 0; i < ARRAY_LENGTH(s_fonts); i++) {
+    if (strcmp(s_fonts[i].key, font_key) == 0) {
+      return &s_fonts[i];
+    }
+  }
+  return &s_fonts[0];
+}
+
+GSize graphics_text_layout_get_content_size(const char *text, GFont font, GRect box,
+                                            GTextOverflowMode overflow_mode, GTextAlignment alignment) {
+  size_t length = text ? strlen(text) : 0;
+  s_counters.text_measures++;
+  s_counters.text_measure_bytes += length;
+
+  GSize size = measure_text(text, font, box.size.w);
+  if (size.h > box.size.h) {
+    size.h = box.size.h;
+  }
+  return size;
+}
+
+void graphics_draw_text(GContext *ctx, const char *text, GFont font, GRect box,
+                        GTextOverflowMode overflow_mode, GTextAlignment alignment, GTextAttributes *text_attributes) {
+  s_counters.text_draws++;
+  s_counters.text_draw_bytes += text ? strlen(text) : 0;
+  collect_text(text, box, ctx);
+}
+
+void graphics_context_set_fill_color(GContext *ctx, GColor color) {}
+void graphics_context_set_stroke_color(GContext *ctx, GColor color) {}
+void graphics_context_set_text_color(GContext *ctx, GColor color) {}
+
+void graphics_fill_rect(GContext *ctx, GRect rect, uint16_t corner_radius, GCornerMask corner_mask) {
+  s_counters.rect_fills++;
+}
+
+void graphics_draw_line(GContext *ctx, GPoint p0, GPoint p1) {}
+
+void graphics_fill_radial(GContext *ctx, GRect rect, GOvalScaleMode scale_mode, uint16_t inset,
+                          int32_t angle_start, int32_t angle_end) {}
+
+GPoint grect_center_point(const GRect *rect) {
+  return GPoint(rect->origin.x + rect->size.w / 2, rect->origin.y + rect->size.h / 2);
+}
+
+void grect_align(GRect *rect, const GRect *inside_rect, const GAlign alignment, const bool clip) {
+  GPoint center = grect_center_point(inside_rect);
+  rect->origin = GPoint(center.x - rect->size.w / 2, center.y - rect->size.h / 2);
+}
+
+int32_t sin_lookup(int32_t angle) {
+  return (int32_t)(sin(angle * 2 * M_PI / TRIG_MAX_ANGLE) * TRIG_MAX_RATIO);
+}
+
+int32_t cos_lookup(int32_t angle) {
+  return (int32_t)(cos(angle * 2 * M_PI / TRIG_MAX_ANGLE) * TRIG_MAX_RATIO);
+}
+
+// Public API: resources and draw commands
+
+GBitmap* gbitmap_create_with_resource(uint32_t resource_id) {
+  GBitmap *bitmap = fake_malloc(sizeof(GBitmap) + 25 * 25);
+  if (bitmap) {
+    bitmap->size = GSize(25, 25);
+  }
+  return bitmap;
+}
+
+void gbitmap_destroy(GBitmap *bitmap) {
+  fake_free(bitmap);
+}
+
+GDrawCommandSequence* gdraw_command_sequence_create_with_resource(uint32_t resource_id) {
+  // Sequences take the size of their resource on the heap (claude-l.pdc and
+  // claude-s.pdc: 9 frames each)
+  bool large = resource_id == RESOURCE_ID_CLAUDE_L;
+  GDrawCommandSequence *sequence = fake_malloc(large ? 4223 : 8462);
+  if (sequence) {
+    sequence->bounds = large ? GSize(60, 60) : GSize(25, 25);
+    sequence->frame_count = 9;
+  }
+  return sequence;
+}
+
+void gdraw_command_sequence_destroy(GDrawCommandSequence *sequence) {
+  fake_free(sequence);
+}
+
+GSize gdraw_command_sequence_get_bounds_size(GDrawCommandSequence *sequence) {
+  return sequence->bounds;
+}
+
+uint32_t gdraw_command_sequence_get_num_frames(GDrawCommandSequence *sequence) {
+  return sequence->frame_count;
+}
+
+GDrawCommandFrame* gdraw_command_sequence_get_frame_by_index(GDrawCommandSequence *sequence, uint32_t index) {
+  static GDrawCommandFrame s_frame = { 33 };
+  return index < sequence->frame_count ? &s_frame : NULL;
+}
+
+uint32_t gdraw_command_frame_get_duration(GDrawCommandFrame *frame) {
+  return frame->duration;
+}
+
+void gdraw_command_frame_draw(GContext *ctx, GDrawCommandSequence *sequence, GDrawCommandFrame *frame, GPoint offset) {}
+
+GDrawCommandList* gdraw_command_frame_get_command_list(GDrawCommandFrame *frame) {
+  static GDrawCommandList s_list = { 0 };
+  return &s_list;
+}
+
+uint32_t gdraw_command_list_get_num_commands(GDrawCommandList *command_list) {
+  return command_list->command_count;
+}
+
+GDrawCommand* gdraw_command_list_get_command(GDrawCommandList *command_list, uint16_t command_idx) {
+  return NULL;
+}
+
+void gdraw_command_set_fill_color(GDrawCommand *command, GColor fill_color) {}
+
+// Public API: layers
+
+Layer* layer_create(GRect frame) {
+  return layer_alloc(sizeof(Layer), frame);
+}
+
+Layer* layer_create_with_data(GRect frame, size_t data_size) {
+  Layer *layer = layer_alloc(sizeof(Layer) + data_size, frame);
+  if (layer) {
+    layer->data = layer + 1;
+  }
+  return layer;
+}
+
+void layer_destroy(Layer *layer) {
+  layer_release(layer);
+}
+
+void* layer_get_data(const Layer *layer) {
+  return layer->data;
+}
+
+void layer_set_update_proc(Layer *layer, LayerUpdateProc update_proc) {
+  layer->update_proc = update_proc;
+}
+
+void layer_mark_dirty(Layer *layer) {}
+
+void layer_add_child(Layer *parent, Layer *child) {
+  layer_remove_from_parent(child);
+  child->parent = parent;
+  child->window = parent->window;
+
+  Layer **link = &parent->first_child;
+  while (*link) {
+    link = &(*link)->next_sibling;
+  }
+  *link = child;
+}
+
+void layer_remove_from_parent(Layer *child) {
+  if (!child->parent) {
+    return;
+  }
+
+  for (Layer **link = &child->parent->first_child; *link; link = &(*link)->next_sibling) {
+    if (*link == child) {
+      *link = child->next_sibling;
+      break;
+    }
+  }
+  child->parent = NULL;
+  child->next_sibling = NULL;
+  child->window = NULL;
+}
+
+GRect layer_get_frame(const Layer *layer) {
+  return layer->frame;
+}
+
+void layer_set_frame(Layer *layer, GRect frame) {
+  layer->frame = frame;
+  layer->bounds.size = frame.size;
+}
+
+GRect layer_get_bounds(const Layer *layer) {
+  return layer->bounds;
+}
+
+void layer_set_bounds(Layer *layer, GRect bounds) {
+  layer->bounds = bounds;
+}
+
+void layer_set_hidden(Layer *layer, bool hidden) {
+  layer->hidden = hidden;
+}
+
+TextLayer* text_layer_create(GRect frame) {
+  TextLayer *text_layer = layer_alloc(sizeof(TextLayer), frame);
+  if (text_layer) {
+    text_layer->font = fonts_get_system_font(FONT_KEY_GOTHIC_14);
+    text_layer->layer.update_proc = text_layer_update_proc;
+  }
+  return text_layer;
+}
+
+void text_layer_destroy(TextLayer *text_layer) {
+  layer_release((Layer *)text_layer);
+}
+
+Layer* text_layer_get_layer(TextLayer *text_layer) {
+  return &text_layer->layer;
+}
+
+void text_layer_set_text(TextLayer *text_layer, const char *text) {
+  text_layer->text = text;
+}
+
+const char* text_layer_get_text(TextLayer *text_layer) {
+  return text_layer->text;
+}
+
+void text_layer_set_font(TextLayer *text_layer, GFont font) {
+  text_layer->font = font;
+}
+
+void text_layer_set_text_color(TextLayer *text_layer, GColor color) {}
+void text_layer_set_background_color(TextLayer *text_layer, GColor color) {}
+
+void text_layer_set_text_alignment(TextLayer *text_layer, GTextAlignment text_alignment) {
+  text_layer->alignment = text_alignment;
+}
+
+void text_layer_set_overflow_mode(TextLayer *text_layer, GTextOverflowMode line_mode) {
+  text_layer->overflow_mode = line_mode;
+}
+
+GSize text_layer_get_content_size(TextLayer *text_layer) {
+  return graphics_text_layout_get_content_size(text_layer->text, text_layer->font, text_layer->layer.bounds,
+                                               text_layer->overflow_mode, text_layer->alignment);
+}
+
+ScrollLayer* scroll_layer_create(GRect frame) {
+  ScrollLayer *scroll_layer = layer_alloc(sizeof(ScrollLayer), frame);
+  if (scroll_layer) {
+    layer_init(&scroll_layer->content, GRect(0, 0, frame.size.w, frame.size.h));
+    layer_add_child(&scroll_layer->layer, &scroll_layer->content);
+  }
+  return scroll_layer;
+}
+
+void scroll_layer_destroy(ScrollLayer *scroll_layer) {
+  layer_release((Layer *)scroll_layer);
+}
+
+Layer* scroll_layer_get_layer(const ScrollLayer *scroll_layer) {
+  return (Layer *)&scroll_layer->layer;
+}
+
+void scroll_layer_add_child(ScrollLayer *scroll_layer, Layer *child) {
+  layer_add_child(&scroll_layer->content, child);
+}
+
+void scroll_layer_set_content_size(ScrollLayer *scroll_layer, GSize size) {
+  scroll_layer->content.frame.size = size;
+  scroll_layer->content.bounds.size = size;
+  scroll_layer_set_content_offset(scroll_layer, scroll_layer->content.frame.origin, false);
+}
+
+GSize scroll_layer_get_content_size(const ScrollLayer *scroll_layer) {
+  return scroll_layer->content.frame.size;
+}
+
+void scroll_layer_set_content_offset(ScrollLayer *scroll_layer, GPoint offset, bool animated) {
+  // The content cannot scroll past its top or bottom
+  int min_y = scroll_layer->layer.frame.size.h - scroll_layer->content.frame.size.h;
+  if (min_y > 0) {
+    min_y = 0;
+  }
+  if (offset.y < min_y) {
+    offset.y = min_y;
+  }
+  if (offset.y > 0) {
+    offset.y = 0;
+  }
+  scroll_layer->content.frame.origin = GPoint(0, offset.y);
+}
+
+GPoint scroll_layer_get_content_offset(ScrollLayer *scroll_layer) {
+  return scroll_layer->content.frame.origin;
+}
+
+void scroll_layer_set_shadow_hidden(ScrollLayer *scroll_layer, bool hidden) {}
+
+StatusBarLayer* status_bar_layer_create(void) {
+  return layer_alloc(sizeof(StatusBarLayer), GRect(0, 0, FAKE_SCREEN_WIDTH, STATUS_BAR_LAYER_HEIGHT));
+}
+
+void status_bar_layer_destroy(StatusBarLayer *status_bar_layer) {
+  layer_release((Layer *)status_bar_layer);
+}
+
+Layer* status_bar_layer_get_layer(StatusBarLayer *status_bar_layer) {
+  return &status_bar_layer->layer;
+}
+
+void status_bar_layer_set_colors(StatusBarLayer *status_bar_layer, GColor background, GColor foreground) {}
+
+// Public API: windows and clicks
+
+Window* window_create(void) {
+  Window *window = fake_calloc(1, sizeof(Window));
+  if (window) {
+    layer_init(&window->root, GRect(0, 0, FAKE_SCREEN_WIDTH, FAKE_SCREEN_HEIGHT));
+    window->root.window = window;
+  }
+  return window;
+}
+
+void window_destroy(Window *window) {
+  if (!window) {
+    return;
+  }
+  window_stack_remove(window, false);
+  fake_free(window);
+}
+
+void window_set_window_handlers(Window *window, WindowHandlers handlers) {
+  window->handlers = handlers;
+}
+
+void window_set_background_color(Window *window, GColor background_color) {}
+
+Layer* window_get_root_layer(const Window *window) {
+  return (Layer *)&window->root;
+}
+
+void window_set_click_config_provider(Window *window, ClickConfigProvider click_config_provider) {
+  window_set_click_config_provider_with_context(window, click_config_provider, window);
+}
+
+void window_set_click_config_provider_with_context(Window *window, ClickConfigProvider click_config_provider, void *context) {
+  window->click_config_provider = click_config_provider;
+  window->click_context = context;
+  if (window_stack_get_top_window() == window) {
+    configure_clicks(window);
+  }
+}
+
+void window_single_click_subscribe(ButtonId button_id, ClickHandler handler) {
+  if (s_configuring_window) {
+    s_configuring_window->clicks[button_id].single = handler;
+  }
+}
+
+void window_single_repeating_click_subscribe(ButtonId button_id, uint16_t repeat_interval_ms, ClickHandler handler) {
+  window_single_click_subscribe(button_id, handler);
+}
+
+void window_multi_click_subscribe(ButtonId button_id, uint8_t min_clicks, uint8_t max_clicks, uint16_t timeout,
+                                  bool last_click_only, ClickHandler handler) {
+  if (s_configuring_window) {
+    ClickSubscription *subscription = &s_configuring_window->clicks[button_id];
+    subscription->multi = handler;
+    subscription->multi_min_clicks = min_clicks;
+    subscription->multi_max_clicks = max_clicks;
+  }
+}
+
+void window_long_click_subscribe(ButtonId button_id, uint16_t delay_ms, ClickHandler down_handler, ClickHandler up_handler) {
+  if (s_configuring_window) {
+    s_configuring_window->clicks[button_id].long_down = down_handler;
+    s_configuring_window->clicks[button_id].long_up = up_handler;
+  }
+}
+
+uint8_t click_number_of_clicks_counted(ClickRecognizerRef recognizer) {
+  return ((ClickRecognizer *)recognizer)->clicks;
+}
+
+ButtonId click_recognizer_get_button_id(ClickRecognizerRef recognizer) {
+  return ((ClickRecognizer *)recognizer)->button_id;
+}
+
+bool click_recognizer_is_repeating(ClickRecognizerRef recognizer) {
+  return ((ClickRecognizer *)recognizer)->repeating;
+}
+
+void window_stack_push(Window *window, bool animated) {
+  if (window_stack_contains_window(window) || s_window_count == MAX_WINDOWS) {
+    return;
+  }
+
+  Window *top = window_stack_get_top_window();
+  if (top && top->handlers.disappear) {
+    top->handlers.disappear(top);
+  }
+  s_window_stack[s_window_count++] = window;
+  window_came_to_top(window);
+}
+
+Window* window_stack_pop(bool animated) {
+  Window *top = window_stack_get_top_window();
+  if (top) {
+    window_stack_remove(top, animated);
+  }
+  return top;
+}
+
+void window_stack_pop_all(const bool animated) {
+  while (s_window_count > 0) {
+    window_stack_pop(animated);
+  }
+}
+
+bool window_stack_remove(Window *window, bool animated) {
+  for (int i = 0; i < s_window_count; i++) {
+    if (s_window_stack[i] != window) {
+      continue;
+    }
+
+    bool was_top = i == s_window_count - 1;
+    memmove(&s_window_stack[i], &s_window_stack[i + 1], (s_window_count - i - 1) * sizeof(Window *));
+    s_window_count--;
+    window_unload(window, was_top);
+
+    Window *top = window_stack_get_top_window();
+    if (was_top && top) {
+      window_came_to_top(top);
+    }
+    return true;
+  }
+  return false;
+}
+
+Window* window_stack_get_top_window(void) {
+  return s_window_count > 0 ? s_window_stack[s_window_count - 1] : NULL;
+}
+
+bool window_stack_contains_window(Window *window) {
+  for (int i = 0; i < s_window_count; i++) {
+    if (s_window_stack[i] == window) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// Public API: menus and action bars
+
+MenuLayer* menu_layer_create(GRect frame) {
+  MenuLayer *menu_layer = layer_alloc(sizeof(MenuLayer), frame);
+  if (menu_layer) {
+    menu_layer->layer.update_proc = menu_layer_update_proc;
+  }
+  return menu_layer;
+}
+
+void menu_layer_destroy(MenuLayer *menu_layer) {
+  layer_release((Layer *)menu_layer);
+}
+
+Layer* menu_layer_get_layer(const MenuLayer *menu_layer) {
+  return (Layer *)&menu_layer->layer;
+}
+
+void menu_layer_set_callbacks(MenuLayer *menu_layer, void *callback_context, MenuLayerCallbacks callbacks) {
+  menu_layer->callbacks = callbacks;
+  menu_layer->context = callback_context;
+}
+
+void menu_layer_set_click_config_onto_window(MenuLayer *menu_layer, Window *window) {
+  window_set_click_config_provider_with_context(window, menu_click_config_provider, menu_layer);
+}
+
+void menu_layer_reload_data(MenuLayer *menu_layer) {
+  int rows = menu_row_count(menu_layer, menu_layer->selected.section);
+  if (menu_layer->selected.row >= rows) {
+    menu_layer->selected.row = rows > 0 ? rows - 1 : 0;
+  }
+}
+
+void menu_layer_set_highlight_colors(MenuLayer *menu_layer, GColor background, GColor foreground) {}
+
+void menu_cell_basic_draw(GContext *ctx, const Layer *cell_layer, const char *title, const char *subtitle, GBitmap *icon) {
+  int width = cell_layer->frame.size.w;
+  graphics_draw_text(ctx, title, fonts_get_system_font(FONT_KEY_GOTHIC_24_BOLD), GRect(5, 0, width - 10, 28),
+                     GTextOverflowModeTrailingEllipsis, GTextAlignmentLeft, NULL);
+  if (subtitle) {
+    graphics_draw_text(ctx, subtitle, fonts_get_system_font(FONT_KEY_GOTHIC_18), GRect(5, 26, width - 10, 22),
+                       GTextOverflowModeTrailingEllipsis, GTextAlignmentLeft, NULL);
+  }
+}
+
+ActionBarLayer* action_bar_layer_create(void) {
+  return layer_alloc(sizeof(ActionBarLayer),
+                     GRect(FAKE_SCREEN_WIDTH - ACTION_BAR_WIDTH, 0, ACTION_BAR_WIDTH, FAKE_SCREEN_HEIGHT));
+}
+
+void action_bar_layer_destroy(ActionBarLayer *action_bar) {
+  layer_release((Layer *)action_bar);
+}
+
+void action_bar_layer_add_to_window(ActionBarLayer *action_bar, struct Window *window) {
+  layer_add_child(&window->root, &action_bar->layer);
+  window->action_bar = action_bar;
+  if (window_stack_get_top_window() == window) {
+    configure_clicks(window);
+  }
+}
+
+void action_bar_layer_set_click_config_provider(ActionBarLayer *action_bar, ClickConfigProvider click_config_provider) {
+  action_bar->click_config_provider = click_config_provider;
+  Window *window = action_bar->layer.window;
+  if (window && window_stack_get_top_window() == window) {
+    configure_clicks(window);
+  }
+}
+
+void action_bar_layer_set_icon(ActionBarLayer *action_bar, ButtonId button_id, const GBitmap *icon) {
+  action_bar->icons[button_id] = icon;
+}
+
+// Public API: timers, time and the event loop
+
+AppTimer* app_timer_register(uint32_t timeout_ms, AppTimerCallback callback, void *callback_data) {
+  for (int i = 0; i < MAX_TIMERS; i++) {
+    struct AppTimer *timer = &s_timers[i];
+    if (!timer->used) {
+      *timer = (struct AppTimer) {
+        .used = true,
+        .due_ms = s_now_ms + timeout_ms,
+        .sequence = s_timer_sequence++,
+        .callback = callback,
+        .data = callback_data,
+      };
+      return timer;
+    }
+  }
+  return NULL;
+}
+
+bool app_timer_reschedule(AppTimer *timer_handle, uint32_t new_timeout_ms) {
+  if (!timer_handle || !timer_handle->used) {
+    return false;
+  }
+  timer_handle->due_ms = s_now_ms + new_timeout_ms;
+  timer_handle->sequence = s_timer_sequence++;
+  return true;
+}
+
+void app_timer_cancel(AppTimer *timer_handle) {
+  if (timer_handle) {
+    timer_handle->used = false;
+  }
+}
+
+uint16_t time_ms(time_t *tloc, uint16_t *out_ms) {
+  // Simulated time starts at 2026-01-01 00:00:00 UTC
+  uint64_t now = 1767225600000ULL + s_now_ms;
+  if (tloc) {
+    *tloc = (time_t)(now / 1000);
+  }
+  if (out_ms) {
+    *out_ms = now % 1000;
+  }
+  return now % 1000;
+}
+
+time_t fake_time(time_t *tloc) {
+  time_t now;
+  time_ms(&now, NULL);
+  if (tloc) {
+    *tloc = now;
+  }
+  return now;
+}
+
+AppLaunchReason launch_reason(void) {
+  return APP_LAUNCH_USER;
+}
+
+void app_event_loop(void) {}
+
+// Public API: dictation
+
+DictationSession* dictation_session_create(uint32_t buffer_size, DictationSessionStatusCallback callback, void *callback_context) {
+  DictationSession *session = fake_calloc(1, sizeof(DictationSession));
+  if (session) {
+    session->callback = callback;
+    session->context = callback_context;
+  }
+  return session;
+}
+
+void dictation_session_destroy(DictationSession *session) {
+  if (session == s_dictation) {
+    s_dictation = NULL;
+  }
+  fake_free(session);
+}
+
+void dictation_session_enable_confirmation(DictationSession *session, bool is_enabled) {}
+
+int dictation_session_start(DictationSession *session) {
+  session->running = true;
+  s_dictation = session;
+  return 0;
+}
+
+int dictation_session_stop(DictationSession *session) {
+  session->running = false;
+  if (session == s_dictation) {
+    s_dictation = NULL;
+  }
+  return 0;
+}
+
+// Public API: dictionaries and AppMessage
+
+Tuple* dict_read_first(DictionaryIterator *iter) {
+  if (!iter || iter->length <= 1 || iter->buffer[0] == 0) {
+    return NULL;
+  }
+  iter->cursor = (Tuple *)(iter->buffer + 1);
+  return iter->cursor;
+}
+
+Tuple* dict_read_next(DictionaryIterator *iter) {
+  if (!iter->cursor) {
+    return NULL;
+  }
+  uint8_t *next = (uint8_t *)iter->cursor + dict_tuple_size(iter->cursor);
+  if (next >= iter->buffer + iter->length) {
+    iter->cursor = NULL;
+    return NULL;
+  }
+  iter->cursor = (Tuple *)next;
+  return iter->cursor;
+}
+
+Tuple* dict_find(const DictionaryIterator *iter, const uint32_t key) {
+  DictionaryIterator walker = *iter;
+  for (Tuple *tuple = dict_read_first(&walker); tuple; tuple = dict_read_next(&walker)) {
+    if (tuple->key == key) {
+      return tuple;
+    }
+  }
+  return NULL;
+}
+
+DictionaryResult dict_write_data(DictionaryIterator *iter, const uint32_t key, const uint8_t * const data, const uint16_t size) {
+  return dict_write(iter, key, TUPLE_BYTE_ARRAY, data, size);
+}
+
+DictionaryResult dict_write_cstring(DictionaryIterator *iter, const uint32_t key, const char * const cstring) {
+  return dict_write(iter, key, TUPLE_CSTRING, cstring, strlen(cstring) + 1);
+}
+
+DictionaryResult dict_write_uint8(DictionaryIterator *iter, const uint32_t key, const uint8_t value) {
+  return dict_write(iter, key, TUPLE_UINT, &value, sizeof(value));
+}
+
+DictionaryResult dict_write_uint32(DictionaryIterator *iter, const uint32_t key, const uint32_t value) {
+  return dict_write(iter, key, TUPLE_UINT, &value, sizeof(value));
+}
+
+DictionaryResult dict_write_int32(DictionaryIterator *iter, const uint32_t key, const int32_t value) {
+  return dict_write(iter, key, TUPLE_INT, &value, sizeof(value));
+}
+
+AppMessageResult app_message_open(const uint32_t size_inbound, const uint32_t size_outbound) {
+  // A relaunch opens AppMessage again: the buffers of the previous launch
+  // are released, as they are when the app exits on the watch
+  fake_free(s_inbox_buffer);
+  fake_free(s_outbox_buffer);
+  s_inbox_buffer = fake_malloc(size_inbound);
+  s_outbox_buffer = fake_malloc(size_outbound);
+  if (!s_inbox_buffer || !s_outbox_buffer) {
+    fake_free(s_inbox_buffer);
+    fake_free(s_outbox_buffer);
+    s_inbox_buffer = NULL;
+    s_outbox_buffer = NULL;
+    return APP_MSG_OUT_OF_MEMORY;
+  }
+  s_outbox_size = size_outbound;
+  return APP_MSG_OK;
+}
+
+AppMessageInboxReceived app_message_register_inbox_received(AppMessageInboxReceived received_callback) {
+  AppMessageInboxReceived previous = s_inbox_received;
+  s_inbox_received = received_callback;
+  return previous;
+}
+
+AppMessageInboxDropped app_message_register_inbox_dropped(AppMessageInboxDropped dropped_callback) {
+  AppMessageInboxDropped previous = s_inbox_dropped;
+  s_inbox_dropped = dropped_callback;
+  return previous;
+}
+
+AppMessageOutboxSent app_message_register_outbox_sent(AppMessageOutboxSent sent_callback) {
+  AppMessageOutboxSent previous = s_outbox_sent;
+  s_outbox_sent = sent_callback;
+  return previous;
+}
+
+AppMessageOutboxFailed app_message_register_outbox_failed(AppMessageOutboxFailed failed_callback) {
+  AppMessageOutboxFailed previous = s_outbox_failed;
+  s_outbox_failed = failed_callback;
+  return previous;
+}
+
+AppMessageResult app_message_outbox_begin(DictionaryIterator **iterator) {
+  if (s_outbox_pending) {
+    return APP_MSG_BUSY;
+  }
+
+  // Without app_message_open the outbox lives outside the fake heap
+  static uint8_t s_default_outbox[DEFAULT_APP_MESSAGE_SIZE];
+  uint8_t *buffer = s_outbox_buffer ? s_outbox_buffer : s_default_outbox;
+  fake_dict_begin(&s_outbox_iter, buffer, s_outbox_size);
+  *iterator = &s_outbox_iter;
+  return APP_MSG_OK;
+}
+
+AppMessageResult app_message_outbox_send(void) {
+  if (s_outbox_pending) {
+    return APP_MSG_BUSY;
+  }
+
+  s_counters.outbox_sends++;
+  s_counters.outbox_bytes += s_outbox_iter.length;
+
+  free(s_last_message);
+  s_last_message = malloc(s_outbox_iter.length);
+  memcpy(s_last_message, s_outbox_iter.buffer, s_outbox_iter.length);
+  s_last_iter = s_outbox_iter;
+  s_last_iter.buffer = s_last_message;
+  s_last_iter.size = s_outbox_iter.length;
+
+  s_outbox_pending = true;
+  s_outbox_due_ms = s_now_ms + FAKE_OUTBOX_ACK_DELAY;
+  return APP_MSG_OK;
+}
+
+void app_comm_set_sniff_interval(const SniffInterval interval) {
+  s_sniff_interval = interval;
+}
+
+void connection_service_subscribe(ConnectionHandlers conn_handlers) {
+  s_connection_handlers = conn_handlers;
+}
+
+void connection_service_unsubscribe(void) {
+  memset(&s_connection_handlers, 0, sizeof(s_connection_handlers));
+}
+
+bool connection_service_peek_pebble_app_connection(void) {
+  return s_connected;
+}
+
+// Public API: persistent storage
+
+bool persist_exists(const uint32_t key) {
+  return persist_find(key) != NULL;
+}
+
+int persist_get_size(const uint32_t key) {
+  PersistEntry *entry = persist_find(key);
+  return entry ? entry->size : E_DOES_NOT_EXIST;
+}
+
+bool persist_read_bool(const uint32_t key) {
+  return persist_read_int(key) != 0;
+}
+
+int32_t persist_read_int(const uint32_t key) {
+  int32_t value = 0;
+  persist_read_data(key, &value, sizeof(value));
+  return value;
+}
+
+int persist_read_data(const uint32_t key, void *buffer, const size_t buffer_size) {
+  PersistEntry *entry = persist_find(key);
+  if (!entry) {
+    return E_DOES_NOT_EXIST;
+  }
+
+  size_t size = entry->size < buffer_size ? entry->size : buffer_size;
+  memcpy(buffer, entry->data, size);
+  s_counters.persist_reads++;
+  return size;
+}
+
+int persist_read_string(const uint32_t key, char *buffer, const size_t buffer_size) {
+  int size = persist_read_data(key, buffer, buffer_size);
+  if (size > 0) {
+    buffer[(size_t)size < buffer_size ? (size_t)size : buffer_size - 1] = '\0';
+  }
+  return size;
+}
+
+StatusCode persist_write_bool(const uint32_t key, const bool value) {
+  return persist_write_int(key, value);
+}
+
+StatusCode persist_write_int(const uint32_t key, const int32_t value) {
+  int result = persist_write_data(key, &value, sizeof(value));
+  return result < 0 ? (StatusCode)result : S_SUCCESS;
+}
+
+int persist_write_data(const uint32_t key, const void *data, const size_t size) {
+  size_t length = size < PERSIST_DATA_MAX_LENGTH ? size : PERSIST_DATA_MAX_LENGTH;
+
+  // Storage is limited to FAKE_PERSIST_SIZE bytes, as on the watch
+  PersistEntry *entry = persist_find(key);
+  size_t stored = fake_persist_bytes() - (entry ? entry->size : 0);
+  if (stored + length > FAKE_PERSIST_SIZE) {
+    return E_OUT_OF_STORAGE;
+  }
+
+  if (!entry) {
+    for (int i = 0; i < MAX_PERSIST_KEYS && !entry; i++) {
+      if (!s_persist[i].used) {
+        entry = &s_persist[i];
+      }
+    }
+    if (!entry) {
+      return E_OUT_OF_STORAGE;
+    }
+  }
+
+  entry->used = true;
+  entry->key = key;
+  entry->size = length;
+  memcpy(entry->data, data, length);
+  s_counters.persist_writes++;
+  s_counters.persist_write_bytes += length;
+  return length;
+}
+
+int persist_write_string(const uint32_t key, const char *cstring) {
+  return persist_write_data(key, cstring, strlen(cstring) + 1);
+}
+
+StatusCode persist_delete(const uint32_t key) {
+  PersistEntry *entry = persist_find(key);
+  if (!entry) {
+    return E_DOES_NOT_EXIST;
+  }
+  entry->used = false;
+  return S_SUCCESS;
+}
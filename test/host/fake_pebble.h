@@ -0,0 +1,169 @@
+#pragma once
+#include <pebble.h>
+
+/**
+ * Fake Pebble
+ *
+ * Controls and counters of the host stand-in for the SDK (fake_pebble.c).
+ * Time is simulated: timers only fire when a test advances the clock, so
+ * runs are deterministic. Outgoing AppMessages are acked after
+ * FAKE_OUTBOX_ACK_DELAY simulated milliseconds unless a test says otherwise.
+ */
+
+#define FAKE_SCREEN_WIDTH 144
+#define FAKE_SCREEN_HEIGHT 168
+
+#ifdef LOW_MEMORY_PROFILE
+// App heap of aplite (24 KB in all), less what the app binary and statics
+// take (about 18 KB, estimated from the size of the host objects)
+#define FAKE_HEAP_SIZE 6144
+#else
+// App heap of basalt, less what the app binary and statics take
+#define FAKE_HEAP_SIZE 48000
+#endif
+
+#define FAKE_OUTBOX_ACK_DELAY 20
+
+// Persistent storage of an app
+#define FAKE_PERSIST_SIZE 4096
+
+// Operations that cost time or memory on the watch
+typedef struct {
+  int mallocs;
+  int frees;
+  size_t heap_used;
+  size_t heap_peak;
+  int failed_mallocs;
+  int layers_created;
+  int layers_alive;
+  int text_measures;
+  size_t text_measure_bytes;
+  int text_draws;
+  size_t text_draw_bytes;
+  int rect_fills;
+  int layer_redraws;
+  int persist_reads;
+  int persist_writes;
+  size_t persist_write_bytes;
+  int outbox_sends;
+  size_t outbox_bytes;
+  int timers_fired;
+  int logs;
+} FakeCounters;
+
+/**
+ * Reset all fake state (heap, layers, windows, timers, storage, counters).
+ * Anything the app allocated before becomes invalid.
+ */
+void fake_reset(void);
+
+/**
+ * Get the operation counters.
+ * @return Counters since the last fake_reset or fake_counters_clear
+ */
+FakeCounters fake_counters(void);
+
+/**
+ * Zero the operation counters (the heap in use is kept and the peak
+ * restarts from it).
+ */
+void fake_counters_clear(void);
+
+/**
+ * Limit the app heap (allocations fail beyond it).
+ * @param size Heap size in bytes
+ */
+void fake_set_heap_size(size_t size);
+
+/**
+ * Print app logs to stderr (they are only counted by default).
+ * @param enabled true to print
+ */
+void fake_set_log_output(bool enabled);
+
+/**
+ * Get the simulated time.
+ * @return Milliseconds since fake_reset
+ */
+uint32_t fake_now_ms(void);
+
+/**
+ * Advance the simulated clock, firing timers and outbox acks as they come due.
+ * @param ms Milliseconds to advance
+ */
+void fake_advance(uint32_t ms);
+
+/**
+ * Draw the top window's layer tree (every layer, as on a full-screen redraw).
+ * Text drawn is counted and, if requested, collected.
+ * @param text Buffer for the text shown, one line per draw call: its screen
+ *             y coordinate, then the text with newlines as spaces (or NULL)
+ * @param size Size of the buffer
+ */
+void fake_render(char *text, size_t size);
+
+/**
+ * Press a button on the top window.
+ * @param button_id The button
+ * @param repeating true for a repeat of a held button
+ * @param clicks Number of clicks counted (1 for a single click)
+ */
+void fake_click(ButtonId button_id, bool repeating, uint8_t clicks);
+
+/**
+ * Hold a button on the top window long enough for a long click.
+ * @param button_id The button
+ */
+void fake_long_click(ButtonId button_id);
+
+/**
+ * Check whether the app is running a dictation session.
+ * @return true while a session is listening
+ */
+bool fake_dictation_is_running(void);
+
+/**
+ * Finish the running dictation session with a transcription.
+ * @param transcription The text, or NULL for a failed dictation
+ * @return false if no session was started
+ */
+bool fake_dictation_finish(const char *transcription);
+
+/**
+ * Get the Bluetooth sniff interval the app asked for.
+ * @return SNIFF_INTERVAL_NORMAL unless the app reduced it
+ */
+SniffInterval fake_sniff_interval(void);
+
+/**
+ * Set the phone connection, calling the connection handler if it changes.
+ * @param connected true if the phone app is connected
+ */
+void fake_set_connected(bool connected);
+
+/**
+ * Choose whether outgoing messages are acked or nacked. Nacked messages
+ * go to the outbox failed callback.
+ * @param delivered true to ack
+ */
+void fake_outbox_set_delivered(bool delivered);
+
+/**
+ * Get the last message the app sent (valid until the next send).
+ * @return The message, or NULL if nothing was sent
+ */
+DictionaryIterator* fake_outbox_last(void);
+
+/**
+ * Start building a message to the app.
+ * @param iter Iterator to set up
+ * @param buffer Storage for the message
+ * @param size Size of the storage
+ */
+void fake_dict_begin(DictionaryIterator *iter, uint8_t *buffer, size_t size);
+
+/**
+ * Get how much persistent storage the app uses.
+ * @return Total bytes in persistent storage
+ */
+size_t fake_persist_bytes(void);
@@ -0,0 +1,454 @@
+#pragma once
+
+/**
+ * Host stand-in for the Pebble SDK header
+ *
+ * Declares the part of the SDK the app uses so the watch code builds and
+ * runs on a plain Linux host. The implementations in fake_pebble.c keep
+ * just enough state to drive the app (layers, timers, AppMessage,
+ * persistent storage) and count the operations that cost time or memory
+ * on the watch; fake_pebble.h has the calls tests use to drive them.
+ *
+ * Platform: a color, rectangular watch with a microphone (basalt).
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// Heap allocations go through the fake heap, which has the size of the
+// app heap on the watch and counts what is allocated
+void* fake_malloc(size_t size);
+void* fake_calloc(size_t count, size_t size);
+void fake_free(void *ptr);
+#define malloc(size) fake_malloc(size)
+#define calloc(count, size) fake_calloc(count, size)
+#define free(ptr) fake_free(ptr)
+
+// Platform
+#define PBL_COLOR
+#define PBL_RECT
+#define PBL_MICROPHONE
+#define PBL_IF_COLOR_ELSE(if_true, if_false) (if_true)
+#define PBL_IF_ROUND_ELSE(if_true, if_false) (if_false)
+#define PBL_IF_MICROPHONE_ELSE(if_true, if_false) (if_true)
+
+#define ARRAY_LENGTH(array) (sizeof(array) / sizeof((array)[0]))
+
+// Logging
+typedef enum {
+  APP_LOG_LEVEL_ERROR = 1,
+  APP_LOG_LEVEL_WARNING = 50,
+  APP_LOG_LEVEL_INFO = 100,
+  APP_LOG_LEVEL_DEBUG = 200,
+} AppLogLevel;
+
+void app_log(uint8_t log_level, const char *src_filename, int src_line_number, const char *fmt, ...)
+  __attribute__((format(printf, 4, 5)));
+#define APP_LOG(level, fmt, args...) app_log(level, __FILE__, __LINE__, fmt, ## args)
+
+// Geometry and graphics
+typedef struct {
+  int16_t x;
+  int16_t y;
+} GPoint;
+
+typedef struct {
+  int16_t w;
+  int16_t h;
+} GSize;
+
+typedef struct {
+  GPoint origin;
+  GSize size;
+} GRect;
+
+#define GPoint(x, y) ((GPoint){ (x), (y) })
+#define GSize(w, h) ((GSize){ (w), (h) })
+#define GRect(x, y, w, h) ((GRect){ { (x), (y) }, { (w), (h) } })
+#define GRectZero GRect(0, 0, 0, 0)
+
+typedef union {
+  uint8_t argb;
+} GColor;
+
+#define GColorClear ((GColor){ .argb = 0x00 })
+#define GColorBlack ((GColor){ .argb = 0xC0 })
+#define GColorWhite ((GColor){ .argb = 0xFF })
+#define GColorDarkGray ((GColor){ .argb = 0xD5 })
+#define GColorLightGray ((GColor){ .argb = 0xEA })
+#define GColorRajah ((GColor){ .argb = 0xF9 })
+
+typedef enum { GCornerNone = 0 } GCornerMask;
+typedef enum { GTextOverflowModeWordWrap, GTextOverflowModeTrailingEllipsis, GTextOverflowModeFill } GTextOverflowMode;
+typedef enum { GTextAlignmentLeft, GTextAlignmentCenter, GTextAlignmentRight } GTextAlignment;
+typedef enum { GAlignCenter, GAlignTopLeft, GAlignTopRight, GAlignTop, GAlignLeft, GAlignBottom, GAlignRight, GAlignBottomRight, GAlignBottomLeft } GAlign;
+typedef enum { GOvalScaleModeFitCircle, GOvalScaleModeFillCircle } GOvalScaleMode;
+
+typedef struct GContext GContext;
+typedef struct GTextAttributes GTextAttributes;
+typedef struct FakeFont *GFont;
+typedef struct GBitmap GBitmap;
+
+#define FONT_KEY_GOTHIC_14 "RESOURCE_ID_GOTHIC_14"
+#define FONT_KEY_GOTHIC_14_BOLD "RESOURCE_ID_GOTHIC_14_BOLD"
+#define FONT_KEY_GOTHIC_18 "RESOURCE_ID_GOTHIC_18"
+#define FONT_KEY_GOTHIC_18_BOLD "RESOURCE_ID_GOTHIC_18_BOLD"
+#define FONT_KEY_GOTHIC_24_BOLD "RESOURCE_ID_GOTHIC_24_BOLD"
+
+GFont fonts_get_system_font(const char *font_key);
+GSize graphics_text_layout_get_content_size(const char *text, GFont font, GRect box,
+                                            GTextOverflowMode overflow_mode, GTextAlignment alignment);
+void graphics_draw_text(GContext *ctx, const char *text, GFont font, GRect box,
+                        GTextOverflowMode overflow_mode, GTextAlignment alignment, GTextAttributes *text_attributes);
+void graphics_context_set_fill_color(GContext *ctx, GColor color);
+void graphics_context_set_stroke_color(GContext *ctx, GColor color);
+void graphics_context_set_text_color(GContext *ctx, GColor color);
+void graphics_fill_rect(GContext *ctx, GRect rect, uint16_t corner_radius, GCornerMask corner_mask);
+void graphics_draw_line(GContext *ctx, GPoint p0, GPoint p1);
+void graphics_fill_radial(GContext *ctx, GRect rect, GOvalScaleMode scale_mode, uint16_t inset,
+                          int32_t angle_start, int32_t angle_end);
+GPoint grect_center_point(const GRect *rect);
+void grect_align(GRect *rect, const GRect *inside_rect, const GAlign alignment, const bool clip);
+
+#define TRIG_MAX_RATIO 0xffff
+#define TRIG_MAX_ANGLE 0x10000
+#define DEG_TO_TRIGANGLE(angle) (((angle) * TRIG_MAX_ANGLE) / 360)
+int32_t sin_lookup(int32_t angle);
+int32_t cos_lookup(int32_t angle);
+
+// Resources and draw commands
+#define RESOURCE_ID_IMAGE_MENU_ICON 1
+#define RESOURCE_ID_ACTION_ICON_DICTATION 2
+#define RESOURCE_ID_CLAUDE_L 3
+#define RESOURCE_ID_CLAUDE_S 4
+
+GBitmap* gbitmap_create_with_resource(uint32_t resource_id);
+void gbitmap_destroy(GBitmap *bitmap);
+
+typedef struct GDrawCommandSequence GDrawCommandSequence;
+typedef struct GDrawCommandFrame GDrawCommandFrame;
+typedef struct GDrawCommandList GDrawCommandList;
+typedef struct GDrawCommand GDrawCommand;
+
+GDrawCommandSequence* gdraw_command_sequence_create_with_resource(uint32_t resource_id);
+void gdraw_command_sequence_destroy(GDrawCommandSequence *sequence);
+GSize gdraw_command_sequence_get_bounds_size(GDrawCommandSequence *sequence);
+uint32_t gdraw_command_sequence_get_num_frames(GDrawCommandSequence *sequence);
+GDrawCommandFrame* gdraw_command_sequence_get_frame_by_index(GDrawCommandSequence *sequence, uint32_t index);
+uint32_t gdraw_command_frame_get_duration(GDrawCommandFrame *frame);
+void gdraw_command_frame_draw(GContext *ctx, GDrawCommandSequence *sequence, GDrawCommandFrame *frame, GPoint offset);
+GDrawCommandList* gdraw_command_frame_get_command_list(GDrawCommandFrame *frame);
+uint32_t gdraw_command_list_get_num_commands(GDrawCommandList *command_list);
+GDrawCommand* gdraw_command_list_get_command(GDrawCommandList *command_list, uint16_t command_idx);
+void gdraw_command_set_fill_color(GDrawCommand *command, GColor fill_color);
+
+// Layers
+typedef struct Layer Layer;
+typedef void (*LayerUpdateProc)(Layer *layer, GContext *ctx);
+
+Layer* layer_create(GRect frame);
+Layer* layer_create_with_data(GRect frame, size_t data_size);
+void layer_destroy(Layer *layer);
+void* layer_get_data(const Layer *layer);
+void layer_set_update_proc(Layer *layer, LayerUpdateProc update_proc);
+void layer_mark_dirty(Layer *layer);
+void layer_add_child(Layer *parent, Layer *child);
+void layer_remove_from_parent(Layer *child);
+GRect layer_get_frame(const Layer *layer);
+void layer_set_frame(Layer *layer, GRect frame);
+GRect layer_get_bounds(const Layer *layer);
+void layer_set_bounds(Layer *layer, GRect bounds);
+void layer_set_hidden(Layer *layer, bool hidden);
+
+typedef struct TextLayer TextLayer;
+TextLayer* text_layer_create(GRect frame);
+void text_layer_destroy(TextLayer *text_layer);
+Layer* text_layer_get_layer(TextLayer *text_layer);
+void text_layer_set_text(TextLayer *text_layer, const char *text);
+const char* text_layer_get_text(TextLayer *text_layer);
+void text_layer_set_font(TextLayer *text_layer, GFont font);
+void text_layer_set_text_color(TextLayer *text_layer, GColor color);
+void text_layer_set_background_color(TextLayer *text_layer, GColor color);
+void text_layer_set_text_alignment(TextLayer *text_layer, GTextAlignment text_alignment);
+void text_layer_set_overflow_mode(TextLayer *text_layer, GTextOverflowMode line_mode);
+GSize text_layer_get_content_size(TextLayer *text_layer);
+
+typedef struct ScrollLayer ScrollLayer;
+ScrollLayer* scroll_layer_create(GRect frame);
+void scroll_layer_destroy(ScrollLayer *scroll_layer);
+Layer* scroll_layer_get_layer(const ScrollLayer *scroll_layer);
+void scroll_layer_add_child(ScrollLayer *scroll_layer, Layer *child);
+void scroll_layer_set_content_size(ScrollLayer *scroll_layer, GSize size);
+GSize scroll_layer_get_content_size(const ScrollLayer *scroll_layer);
+void scroll_layer_set_content_offset(ScrollLayer *scroll_layer, GPoint offset, bool animated);
+GPoint scroll_layer_get_content_offset(ScrollLayer *scroll_layer);
+void scroll_layer_set_shadow_hidden(ScrollLayer *scroll_layer, bool hidden);
+
+#define STATUS_BAR_LAYER_HEIGHT 16
+typedef struct StatusBarLayer StatusBarLayer;
+StatusBarLayer* status_bar_layer_create(void);
+void status_bar_layer_destroy(StatusBarLayer *status_bar_layer);
+Layer* status_bar_layer_get_layer(StatusBarLayer *status_bar_layer);
+void status_bar_layer_set_colors(StatusBarLayer *status_bar_layer, GColor background, GColor foreground);
+
+// Windows and clicks
+typedef struct Window Window;
+typedef void (*WindowHandler)(Window *window);
+typedef struct {
+  WindowHandler load;
+  WindowHandler appear;
+  WindowHandler disappear;
+  WindowHandler unload;
+} WindowHandlers;
+
+typedef enum {
+  BUTTON_ID_BACK,
+  BUTTON_ID_UP,
+  BUTTON_ID_SELECT,
+  BUTTON_ID_DOWN,
+  NUM_BUTTONS,
+} ButtonId;
+
+typedef void *ClickRecognizerRef;
+typedef void (*ClickHandler)(ClickRecognizerRef recognizer, void *context);
+typedef void (*ClickConfigProvider)(void *context);
+
+Window* window_create(void);
+void window_destroy(Window *window);
+void window_set_window_handlers(Window *window, WindowHandlers handlers);
+void window_set_background_color(Window *window, GColor background_color);
+Layer* window_get_root_layer(const Window *window);
+void window_set_click_config_provider(Window *window, ClickConfigProvider click_config_provider);
+void window_set_click_config_provider_with_context(Window *window, ClickConfigProvider click_config_provider, void *context);
+void window_single_click_subscribe(ButtonId button_id, ClickHandler handler);
+void window_single_repeating_click_subscribe(ButtonId button_id, uint16_t repeat_interval_ms, ClickHandler handler);
+void window_multi_click_subscribe(ButtonId button_id, uint8_t min_clicks, uint8_t max_clicks, uint16_t timeout,
+                                  bool last_click_only, ClickHandler handler);
+void window_long_click_subscribe(ButtonId button_id, uint16_t delay_ms, ClickHandler down_handler, ClickHandler up_handler);
+uint8_t click_number_of_clicks_counted(ClickRecognizerRef recognizer);
+ButtonId click_recognizer_get_button_id(ClickRecognizerRef recognizer);
+bool click_recognizer_is_repeating(ClickRecognizerRef recognizer);
+
+void window_stack_push(Window *window, bool animated);
+Window* window_stack_pop(bool animated);
+void window_stack_pop_all(const bool animated);
+bool window_stack_remove(Window *window, bool animated);
+Window* window_stack_get_top_window(void);
+bool window_stack_contains_window(Window *window);
+
+// Menus and action bars
+typedef struct MenuLayer MenuLayer;
+typedef struct {
+  uint16_t section;
+  uint16_t row;
+} MenuIndex;
+
+typedef struct {
+  uint16_t (*get_num_sections)(MenuLayer *menu_layer, void *callback_context);
+  uint16_t (*get_num_rows)(MenuLayer *menu_layer, uint16_t section_index, void *callback_context);
+  int16_t (*get_cell_height)(MenuLayer *menu_layer, MenuIndex *cell_index, void *callback_context);
+  int16_t (*get_header_height)(MenuLayer *menu_layer, uint16_t section_index, void *callback_context);
+  void (*draw_row)(GContext *ctx, const Layer *cell_layer, MenuIndex *cell_index, void *callback_context);
+  void (*draw_header)(GContext *ctx, const Layer *cell_layer, uint16_t section_index, void *callback_context);
+  void (*select_click)(MenuLayer *menu_layer, MenuIndex *cell_index, void *callback_context);
+} MenuLayerCallbacks;
+
+MenuLayer* menu_layer_create(GRect frame);
+void menu_layer_destroy(MenuLayer *menu_layer);
+Layer* menu_layer_get_layer(const MenuLayer *menu_layer);
+void menu_layer_set_callbacks(MenuLayer *menu_layer, void *callback_context, MenuLayerCallbacks callbacks);
+void menu_layer_set_click_config_onto_window(MenuLayer *menu_layer, Window *window);
+void menu_layer_reload_data(MenuLayer *menu_layer);
+void menu_layer_set_highlight_colors(MenuLayer *menu_layer, GColor background, GColor foreground);
+void menu_cell_basic_draw(GContext *ctx, const Layer *cell_layer, const char *title, const char *subtitle, GBitmap *icon);
+
+#define ACTION_BAR_WIDTH 30
+typedef struct ActionBarLayer ActionBarLayer;
+ActionBarLayer* action_bar_layer_create(void);
+void action_bar_layer_destroy(ActionBarLayer *action_bar);
+void action_bar_layer_add_to_window(ActionBarLayer *action_bar, struct Window *window);
+void action_bar_layer_set_click_config_provider(ActionBarLayer *action_bar, ClickConfigProvider click_config_provider);
+void action_bar_layer_set_icon(ActionBarLayer *action_bar, ButtonId button_id, const GBitmap *icon);
+
+// Timers, time and the event loop
+typedef struct AppTimer AppTimer;
+typedef void (*AppTimerCallback)(void *data);
+AppTimer* app_timer_register(uint32_t timeout_ms, AppTimerCallback callback, void *callback_data);
+bool app_timer_reschedule(AppTimer *timer_handle, uint32_t new_timeout_ms);
+void app_timer_cancel(AppTimer *timer_handle);
+
+uint16_t time_ms(time_t *tloc, uint16_t *out_ms);
+
+// Wall-clock time follows the simulated clock
+time_t fake_time(time_t *tloc);
+#define time(tloc) fake_time(tloc)
+
+typedef enum {
+  APP_LAUNCH_SYSTEM,
+  APP_LAUNCH_USER,
+  APP_LAUNCH_PHONE,
+  APP_LAUNCH_WAKEUP,
+  APP_LAUNCH_WORKER,
+  APP_LAUNCH_QUICK_LAUNCH,
+  APP_LAUNCH_TIMELINE_ACTION,
+  APP_LAUNCH_SMARTSTRAP,
+} AppLaunchReason;
+AppLaunchReason launch_reason(void);
+void app_event_loop(void);
+
+size_t heap_bytes_free(void);
+size_t heap_bytes_used(void);
+
+// Dictation
+typedef struct DictationSession DictationSession;
+typedef enum {
+  DictationSessionStatusSuccess,
+  DictationSessionStatusFailureTranscriptionRejected,
+  DictationSessionStatusFailureTranscriptionRejectedWithError,
+  DictationSessionStatusFailureSystemAborted,
+  DictationSessionStatusFailureNoSpeechDetected,
+  DictationSessionStatusFailureConnectivityError,
+  DictationSessionStatusFailureDisabled,
+  DictationSessionStatusFailureInternalError,
+  DictationSessionStatusFailureRecognizerError,
+} DictationSessionStatus;
+typedef void (*DictationSessionStatusCallback)(DictationSession *session, DictationSessionStatus status,
+                                               char *transcription, void *context);
+
+DictationSession* dictation_session_create(uint32_t buffer_size, DictationSessionStatusCallback callback, void *callback_context);
+void dictation_session_destroy(DictationSession *session);
+void dictation_session_enable_confirmation(DictationSession *session, bool is_enabled);
+int dictation_session_start(DictationSession *session);
+int dictation_session_stop(DictationSession *session);
+
+// Dictionaries and AppMessage
+typedef enum {
+  TUPLE_BYTE_ARRAY = 0,
+  TUPLE_CSTRING = 1,
+  TUPLE_UINT = 2,
+  TUPLE_INT = 3,
+} TupleType;
+
+typedef struct __attribute__((__packed__)) {
+  uint32_t key;
+  TupleType type:8;
+  uint16_t length;
+  union {
+    uint8_t data[0];
+    char cstring[0];
+    uint8_t uint8;
+    uint16_t uint16;
+    uint32_t uint32;
+    int8_t int8;
+    int16_t int16;
+    int32_t int32;
+  } value[];
+} Tuple;
+
+typedef struct {
+  uint8_t *buffer;
+  size_t size;
+  size_t length;
+  Tuple *cursor;
+} DictionaryIterator;
+
+typedef enum {
+  DICT_OK = 0,
+  DICT_NOT_ENOUGH_STORAGE = 1 << 1,
+  DICT_INVALID_ARGS = 1 << 2,
+} DictionaryResult;
+
+Tuple* dict_find(const DictionaryIterator *iter, const uint32_t key);
+Tuple* dict_read_first(DictionaryIterator *iter);
+Tuple* dict_read_next(DictionaryIterator *iter);
+DictionaryResult dict_write_data(DictionaryIterator *iter, const uint32_t key, const uint8_t * const data, const uint16_t size);
+DictionaryResult dict_write_cstring(DictionaryIterator *iter, const uint32_t key, const char * const cstring);
+DictionaryResult dict_write_uint8(DictionaryIterator *iter, const uint32_t key, const uint8_t value);
+DictionaryResult dict_write_uint32(DictionaryIterator *iter, const uint32_t key, const uint32_t value);
+DictionaryResult dict_write_int32(DictionaryIterator *iter, const uint32_t key, const int32_t value);
+
+typedef enum {
+  APP_MSG_OK = 0,
+  APP_MSG_SEND_TIMEOUT = 1 << 1,
+  APP_MSG_SEND_REJECTED = 1 << 2,
+  APP_MSG_NOT_CONNECTED = 1 << 3,
+  APP_MSG_APP_NOT_RUNNING = 1 << 4,
+  APP_MSG_INVALID_ARGS = 1 << 5,
+  APP_MSG_BUSY = 1 << 6,
+  APP_MSG_BUFFER_OVERFLOW = 1 << 7,
+  APP_MSG_OUT_OF_MEMORY = 1 << 10,
+  APP_MSG_CLOSED = 1 << 11,
+  APP_MSG_INTERNAL_ERROR = 1 << 12,
+} AppMessageResult;
+
+typedef void (*AppMessageInboxReceived)(DictionaryIterator *iterator, void *context);
+typedef void (*AppMessageInboxDropped)(AppMessageResult reason, void *context);
+typedef void (*AppMessageOutboxSent)(DictionaryIterator *iterator, void *context);
+typedef void (*AppMessageOutboxFailed)(DictionaryIterator *iterator, AppMessageResult reason, void *context);
+
+AppMessageResult app_message_open(const uint32_t size_inbound, const uint32_t size_outbound);
+AppMessageInboxReceived app_message_register_inbox_received(AppMessageInboxReceived received_callback);
+AppMessageInboxDropped app_message_register_inbox_dropped(AppMessageInboxDropped dropped_callback);
+AppMessageOutboxSent app_message_register_outbox_sent(AppMessageOutboxSent sent_callback);
+AppMessageOutboxFailed app_message_register_outbox_failed(AppMessageOutboxFailed failed_callback);
+AppMessageResult app_message_outbox_begin(DictionaryIterator **iterator);
+AppMessageResult app_message_outbox_send(void);
+
+typedef enum {
+  SNIFF_INTERVAL_NORMAL = 0,
+  SNIFF_INTERVAL_REDUCED = 1,
+} SniffInterval;
+void app_comm_set_sniff_interval(const SniffInterval interval);
+
+typedef void (*ConnectionHandler)(bool connected);
+typedef struct {
+  ConnectionHandler pebble_app_connection_handler;
+  ConnectionHandler pebblekit_connection_handler;
+} ConnectionHandlers;
+void connection_service_subscribe(ConnectionHandlers conn_handlers);
+void connection_service_unsubscribe(void);
+bool connection_service_peek_pebble_app_connection(void);
+
+// Message keys from package.json (generated by the SDK build)
+extern uint32_t MESSAGE_KEY_REQUEST_CHAT;
+extern uint32_t MESSAGE_KEY_RESPONSE_TEXT;
+extern uint32_t MESSAGE_KEY_RESPONSE_END;
+extern uint32_t MESSAGE_KEY_READY_STATUS;
+extern uint32_t MESSAGE_KEY_THREAD_ID;
+extern uint32_t MESSAGE_KEY_THREAD_REQUEST;
+extern uint32_t MESSAGE_KEY_THREAD_DATA;
+extern uint32_t MESSAGE_KEY_REQUEST_ID;
+extern uint32_t MESSAGE_KEY_SUGGESTIONS;
+extern uint32_t MESSAGE_KEY_PREWARM;
+extern uint32_t MESSAGE_KEY_DICTATION_CONFIRM;
+extern uint32_t MESSAGE_KEY_INBOX_SIZE;
+extern uint32_t MESSAGE_KEY_STATUS_TEXT;
+
+// Persistent storage
+#define PERSIST_DATA_MAX_LENGTH 256
+#define PERSIST_STRING_MAX_LENGTH PERSIST_DATA_MAX_LENGTH
+
+typedef enum {
+  S_SUCCESS = 0,
+  E_ERROR = -1,
+  E_INVALID_ARGUMENT = -3,
+  E_OUT_OF_STORAGE = -8,
+  E_DOES_NOT_EXIST = -10,
+} StatusCode;
+
+bool persist_exists(const uint32_t key);
+int persist_get_size(const uint32_t key);
+bool persist_read_bool(const uint32_t key);
+int32_t persist_read_int(const uint32_t key);
+int persist_read_data(const uint32_t key, void *buffer, const size_t buffer_size);
+int persist_read_string(const uint32_t key, char *buffer, const size_t buffer_size);
+StatusCode persist_write_bool(const uint32_t key, const bool value);
+StatusCode persist_write_int(const uint32_t key, const int32_t value);
+int persist_write_data(const uint32_t key, const void *data, const size_t size);
+int persist_write_string(const uint32_t key, const char *cstring);
+StatusCode persist_delete(const uint32_t key);
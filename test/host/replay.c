@@ -0,0 +1,444 @@
+#include "replay.h"
+#include "chat_driver.h"
+#include "chat_window.h"
+#include "conversation_codec.h"
+#include <stdarg.h>
+#include <stdlib.h>
+
+// A REQUEST_CHAT of a full outbox takes about 4 characters per byte
+#define REPLAY_LINE_SIZE 65536
+#define REPLAY_VALUE_SIZE 8192
+#define REPLAY_DICT_SIZE (REPLAY_VALUE_SIZE + 256)
+#define REPLAY_SUMMARY_SIZE 256
+#define REPLAY_PREVIEW_LENGTH 32
+
+typedef struct {
+  const char *name;
+  const uint32_t *key;
+} ReplayKey;
+
+static const ReplayKey s_keys[] = {
+  { "REQUEST_CHAT", &MESSAGE_KEY_REQUEST_CHAT },
+  { "RESPONSE_TEXT", &MESSAGE_KEY_RESPONSE_TEXT },
+  { "RESPONSE_END", &MESSAGE_KEY_RESPONSE_END },
+  { "READY_STATUS", &MESSAGE_KEY_READY_STATUS },
+  { "THREAD_ID", &MESSAGE_KEY_THREAD_ID },
+  { "THREAD_REQUEST", &MESSAGE_KEY_THREAD_REQUEST },
+  { "THREAD_DATA", &MESSAGE_KEY_THREAD_DATA },
+  { "REQUEST_ID", &MESSAGE_KEY_REQUEST_ID },
+  { "SUGGESTIONS", &MESSAGE_KEY_SUGGESTIONS },
+  { "PREWARM", &MESSAGE_KEY_PREWARM },
+  { "DICTATION_CONFIRM", &MESSAGE_KEY_DICTATION_CONFIRM },
+  { "INBOX_SIZE", &MESSAGE_KEY_INBOX_SIZE },
+  { "STATUS_TEXT", &MESSAGE_KEY_STATUS_TEXT },
+};
+
+static char s_line[REPLAY_LINE_SIZE];
+static uint8_t s_dict_buffer[REPLAY_DICT_SIZE];
+static uint8_t s_value[REPLAY_VALUE_SIZE];
+static char s_question[REPLAY_VALUE_SIZE];
+static char s_summary[REPLAY_SUMMARY_SIZE];
+
+// Private helper functions
+
+static const uint32_t* find_key(const char *name) {
+  for (size_t i = 0; i < ARRAY_LENGTH(s_keys); i++) {
+    if (strcmp(s_keys[i].name, name) == 0) {
+      return s_keys[i].key;
+    }
+  }
+  return NULL;
+}
+
+static const char* skip_space(const char *json) {
+  while (*json == ' ' || *json == '\t' || *json == '\r' || *json == '\n') {
+    json++;
+  }
+  return json;
+}
+
+static bool append_utf8(uint32_t code, uint8_t *out, size_t size, size_t *length) {
+  uint8_t bytes[4];
+  size_t count;
+  if (code < 0x80) {
+    bytes[0] = code;
+    count = 1;
+  } else if (code < 0x800) {
+    bytes[0] = 0xC0 | (code >> 6);
+    bytes[1] = 0x80 | (code & 0x3F);
+    count = 2;
+  } else if (code < 0x10000) {
+    bytes[0] = 0xE0 | (code >> 12);
+    bytes[1] = 0x80 | ((code >> 6) & 0x3F);
+    bytes[2] = 0x80 | (code & 0x3F);
+    count = 3;
+  } else {
+    bytes[0] = 0xF0 | (code >> 18);
+    bytes[1] = 0x80 | ((code >> 12) & 0x3F);
+    bytes[2] = 0x80 | ((code >> 6) & 0x3F);
+    bytes[3] = 0x80 | (code & 0x3F);
+    count = 4;
+  }
+
+  if (*length + count > size) {
+    return false;
+  }
+  memcpy(out + *length, bytes, count);
+  *length += count;
+  return true;
+}
+
+static bool parse_hex4(const char *json, uint32_t *code) {
+  char digits[5] = { 0 };
+  for (int i = 0; i < 4; i++) {
+    if (!json[i]) {
+      return false;
+    }
+    digits[i] = json[i];
+  }
+  char *end;
+  *code = strtoul(digits, &end, 16);
+  return end == digits + 4;
+}
+
+// Parse a JSON string starting after its opening quote into UTF-8.
+// Returns the position after the closing quote, or NULL if it is malformed.
+static const char* parse_string(const char *json, uint8_t *out, size_t size, size_t *length) {
+  *length = 0;
+  while (*json && *json != '"') {
+    if (*json != '\\') {
+      if (*length >= size) {
+        return NULL;
+      }
+      out[(*length)++] = (uint8_t)*json++;
+      continue;
+    }
+
+    json++;
+    uint32_t code;
+    switch (*json) {
+      case '"': code = '"'; break;
+      case '\\': code = '\\'; break;
+      case '/': code = '/'; break;
+      case 'b': code = '\b'; break;
+      case 'f': code = '\f'; break;
+      case 'n': code = '\n'; break;
+      case 'r': code = '\r'; break;
+      case 't': code = '\t'; break;
+      case 'u': {
+        if (!parse_hex4(json + 1, &code)) {
+          return NULL;
+        }
+        json += 4;
+        // Characters outside the BMP are escaped as a surrogate pair
+        uint32_t low;
+        if (code >= 0xD800 && code < 0xDC00 && json[1] == '\\' && json[2] == 'u' &&
+            parse_hex4(json + 3, &low) && low >= 0xDC00 && low < 0xE000) {
+          code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+          json += 6;
+        }
+        break;
+      }
+      default:
+        return NULL;
+    }
+    json++;
+    if (!append_utf8(code, out, size, length)) {
+      return NULL;
+    }
+  }
+  return *json == '"' ? json + 1 : NULL;
+}
+
+static const char* parse_bytes(const char *json, uint8_t *out, size_t size, size_t *length) {
+  *length = 0;
+  json = skip_space(json);
+  while (*json && *json != ']') {
+    char *end;
+    long value = strtol(json, &end, 10);
+    if (end == json || value < 0 || value > 255 || *length >= size) {
+      return NULL;
+    }
+    out[(*length)++] = (uint8_t)value;
+    json = skip_space(end);
+    if (*json == ',') {
+      json = skip_space(json + 1);
+    }
+  }
+  return *json == ']' ? json + 1 : NULL;
+}
+
+static void append_summary(const char *format, ...) {
+  size_t used = strlen(s_summary);
+  if (used > 0 && used < sizeof(s_summary) - 1) {
+    s_summary[used++] = ' ';
+    s_summary[used] = '\0';
+  }
+
+  va_list args;
+  va_start(args, format);
+  vsnprintf(s_summary + used, sizeof(s_summary) - used, format, args);
+  va_end(args);
+}
+
+// Start of a text for the transcript, on one line
+static const char* preview(const uint8_t *text, size_t length) {
+  static char s_preview[REPLAY_PREVIEW_LENGTH + 1];
+  size_t preview_length = length < REPLAY_PREVIEW_LENGTH ? length : REPLAY_PREVIEW_LENGTH;
+  for (size_t i = 0; i < preview_length; i++) {
+    s_preview[i] = text[i] == '\n' ? ' ' : (char)text[i];
+  }
+  s_preview[preview_length] = '\0';
+  return s_preview;
+}
+
+// Turn a captured payload (a flat JSON object keyed by message key names)
+// into a dictionary. Keys the app does not know are left out.
+static bool payload_to_dict(const char *json, DictionaryIterator *iter) {
+  fake_dict_begin(iter, s_dict_buffer, sizeof(s_dict_buffer));
+  s_summary[0] = '\0';
+
+  json = skip_space(json);
+  if (*json++ != '{') {
+    return false;
+  }
+
+  json = skip_space(json);
+  while (*json == '"') {
+    char name[32];
+    size_t length;
+    json = parse_string(json + 1, (uint8_t *)name, sizeof(name) - 1, &length);
+    if (!json) {
+      return false;
+    }
+    name[length] = '\0';
+
+    json = skip_space(json);
+    if (*json++ != ':') {
+      return false;
+    }
+    json = skip_space(json);
+
+    const uint32_t *key = find_key(name);
+    if (*json == '"') {
+      json = parse_string(json + 1, s_value, sizeof(s_value) - 1, &length);
+      if (!json) {
+        return false;
+      }
+      s_value[length] = '\0';
+      if (key) {
+        dict_write_cstring(iter, *key, (const char *)s_value);
+      }
+      append_summary("%s \"%s\" (%d B)", name, preview(s_value, length), (int)length);
+    } else if (*json == '[') {
+      json = parse_bytes(json + 1, s_value, sizeof(s_value), &length);
+      if (!json) {
+        return false;
+      }
+      if (key) {
+        dict_write_data(iter, *key, s_value, length);
+      }
+      append_summary("%s (%d B)", name, (int)length);
+    } else {
+      char *end;
+      long value = strtol(json, &end, 10);
+      if (end == json) {
+        return false;
+      }
+      json = end;
+      if (key) {
+        dict_write_int32(iter, *key, (int32_t)value);
+      }
+      append_summary("%s=%ld", name, value);
+    }
+
+    json = skip_space(json);
+    if (*json == ',') {
+      json = skip_space(json + 1);
+    }
+  }
+  return *json == '}';
+}
+
+// Copy the last user message of a conversation (the question being asked)
+static bool find_question(const Tuple *request) {
+  ConversationDecoder decoder;
+  if (request->type != TUPLE_BYTE_ARRAY ||
+      !conversation_decoder_init(&decoder, request->value->data, request->length)) {
+    return false;
+  }
+
+  bool found = false;
+  bool is_user;
+  const char *text;
+  size_t length;
+  while (conversation_decoder_next(&decoder, &is_user, &text, &length)) {
+    if (is_user && length < sizeof(s_question)) {
+      memcpy(s_question, text, length);
+      s_question[length] = '\0';
+      found = true;
+    }
+  }
+  return found;
+}
+
+// Compare the messages of two conversations (request IDs differ between runs)
+static bool same_conversation(const Tuple *a, const Tuple *b) {
+  ConversationDecoder decoder_a, decoder_b;
+  if (!conversation_decoder_init(&decoder_a, a->value->data, a->length) ||
+      !conversation_decoder_init(&decoder_b, b->value->data, b->length)) {
+    return false;
+  }
+
+  bool is_user_a, is_user_b;
+  const char *text_a, *text_b;
+  size_t length_a, length_b;
+  while (true) {
+    bool more_a = conversation_decoder_next(&decoder_a, &is_user_a, &text_a, &length_a);
+    bool more_b = conversation_decoder_next(&decoder_b, &is_user_b, &text_b, &length_b);
+    if (more_a != more_b) {
+      return false;
+    }
+    if (!more_a) {
+      return true;
+    }
+    if (is_user_a != is_user_b || length_a != length_b || memcmp(text_a, text_b, length_a) != 0) {
+      return false;
+    }
+  }
+}
+
+// Dictate the captured question so the window sends its own request
+static void replay_request(const Tuple *captured, FILE *transcript, ReplayStats *stats) {
+  if (!find_question(captured)) {
+    stats->errors++;
+    if (transcript) {
+      fprintf(transcript, "          no question in the captured request\n");
+    }
+    return;
+  }
+
+  uint32_t request_id = chat_driver_say(s_question);
+  if (!request_id) {
+    stats->requests_missing++;
+    if (transcript) {
+      fprintf(transcript, "          said \"%.*s\", no request sent\n", REPLAY_PREVIEW_LENGTH, s_question);
+    }
+    return;
+  }
+
+  stats->requests++;
+  Tuple *sent = dict_find(fake_outbox_last(), MESSAGE_KEY_REQUEST_CHAT);
+  bool matches = sent && same_conversation(captured, sent);
+  if (!matches) {
+    stats->requests_mismatched++;
+  }
+  if (transcript) {
+    fprintf(transcript, "          said \"%.*s\", sent request %08x (%d B)%s\n", REPLAY_PREVIEW_LENGTH, s_question,
+            (unsigned)request_id, sent ? (int)sent->length : 0, matches ? "" : ", differs from the capture");
+  }
+}
+
+// Public API
+
+bool replay_capture(const char *path, FILE *transcript, ReplayStats *stats) {
+  FILE *file = fopen(path, "r");
+  if (!file) {
+    return false;
+  }
+  memset(stats, 0, sizeof(*stats));
+
+  // Capture times restart at each launch of the phone app; time the replay
+  // spends dictating is added so responses keep their delay after a request
+  uint32_t launch_ms = fake_now_ms();
+  uint32_t added_ms = 0;
+  bool launched = false;
+
+  while (fgets(s_line, sizeof(s_line), file)) {
+    size_t line_length = strlen(s_line);
+    if (line_length == sizeof(s_line) - 1 && s_line[line_length - 1] != '\n') {
+      // Longer than any capture line, skip the rest of it
+      stats->errors++;
+      int c;
+      while ((c = fgetc(file)) != EOF && c != '\n') {
+      }
+      continue;
+    }
+
+    const char *line = strstr(s_line, "CAPTURE\t");
+    line = line ? line + strlen("CAPTURE\t") : s_line;
+    if (*line == '\n' || *line == '\0') {
+      continue;
+    }
+
+    char *end;
+    uint32_t time_ms = strtoul(line, &end, 10);
+    if (end == line || end[0] != '\t' || !end[1] || end[2] != '\t') {
+      stats->errors++;
+      continue;
+    }
+    char event = end[1];
+    const char *json = strchr(end + 3, '\t');
+    if (!json) {
+      stats->errors++;
+      continue;
+    }
+    stats->events++;
+
+    if (event == '#') {
+      if (launched) {
+        launch_ms = fake_now_ms();
+        added_ms = 0;
+      }
+      launched = true;
+    }
+
+    uint32_t due_ms = launch_ms + time_ms + added_ms;
+    if (due_ms > fake_now_ms()) {
+      fake_advance(due_ms - fake_now_ms());
+    }
+
+    DictionaryIterator iter;
+    if (!payload_to_dict(json + 1, &iter)) {
+      stats->errors++;
+      if (transcript) {
+        fprintf(transcript, "%7u %c malformed payload\n", (unsigned)fake_now_ms(), event);
+      }
+      continue;
+    }
+    if (transcript) {
+      fprintf(transcript, "%7u %c %s\n", (unsigned)fake_now_ms(), event, s_summary);
+    }
+
+    switch (event) {
+      case '<': {
+        // Messages from the watch: only requests are made to happen again
+        Tuple *request = dict_find(&iter, MESSAGE_KEY_REQUEST_CHAT);
+        if (request) {
+          uint32_t start_ms = fake_now_ms();
+          replay_request(request, transcript, stats);
+          added_ms += fake_now_ms() - start_ms;
+        } else if (!dict_find(&iter, MESSAGE_KEY_PREWARM)) {
+          stats->skipped++;
+        }
+        break;
+      }
+      case '+':
+        chat_window_handle_inbox(&iter);
+        stats->delivered++;
+        break;
+      case '!':
+        stats->dropped++;
+        break;
+      case '#':
+      case '>':
+        break;
+      default:
+        stats->errors++;
+        break;
+    }
+  }
+
+  fclose(file);
+  return true;
+}
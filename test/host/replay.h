@@ -0,0 +1,41 @@
+#pragma once
+#include <stdio.h>
+#include "fake_pebble.h"
+
+/**
+ * Replay
+ *
+ * Replays AppMessage traffic captured by PebbleKit JS (the "Record Message
+ * Traffic" setting, see captureEvent in src/pkjs/index.js) against the chat
+ * window on the fake SDK, keeping the captured timing.
+ *
+ * A capture has one event per line: "<ms since launch>\t<event>\t<size>\t<payload JSON>",
+ * optionally after a "CAPTURE\t" log prefix. Messages to the watch (">") are
+ * delivered when the capture saw them acked ("+"); nacked ones ("!") are
+ * dropped. For each request from the watch ("<" with REQUEST_CHAT) the user's
+ * question is dictated, so the window sends its own request, which is
+ * checked against the captured one. Other messages from the watch are sent
+ * by the window itself (PREWARM) or need the history window (THREAD_REQUEST)
+ * and are not reproduced.
+ */
+
+typedef struct {
+  int events;
+  int delivered;
+  int dropped;
+  int requests;
+  int requests_missing;
+  int requests_mismatched;
+  int skipped;
+  int errors;
+} ReplayStats;
+
+/**
+ * Replay a capture against the chat window, which must be on top (see
+ * chat_driver_launch).
+ * @param path The capture file
+ * @param transcript Where to print each event as it is replayed (or NULL)
+ * @param stats Filled with what was replayed
+ * @return false if the file cannot be read
+ */
+bool replay_capture(const char *path, FILE *transcript, ReplayStats *stats);
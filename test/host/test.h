@@ -0,0 +1,45 @@
+#pragma once
+#include "fake_pebble.h"
+
+/**
+ * Minimal test helpers: a failed check prints where it failed and counts
+ * toward the exit status of the test program.
+ */
+
+static int s_test_failures = 0;
+
+#define CHECK(condition) do { \
+    if (!(condition)) { \
+      fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+      s_test_failures++; \
+    } \
+  } while (0)
+
+#define CHECK_EQ_INT(actual, expected) do { \
+    long long actual_value = (long long)(actual); \
+    long long expected_value = (long long)(expected); \
+    if (actual_value != expected_value) { \
+      fprintf(stderr, "%s:%d: %s is %lld, expected %lld\n", __FILE__, __LINE__, #actual, actual_value, expected_value); \
+      s_test_failures++; \
+    } \
+  } while (0)
+
+#define CHECK_EQ_STR(actual, expected) do { \
+    const char *actual_value = (actual); \
+    const char *expected_value = (expected); \
+    if (!actual_value || strcmp(actual_value, expected_value) != 0) { \
+      fprintf(stderr, "%s:%d: %s is \"%s\", expected \"%s\"\n", __FILE__, __LINE__, #actual, \
+              actual_value ? actual_value : "(null)", expected_value); \
+      s_test_failures++; \
+    } \
+  } while (0)
+
+#define RUN_TEST(test) do { \
+    fake_reset(); \
+    int failures_before = s_test_failures; \
+    test(); \
+    printf("%s %s\n", s_test_failures == failures_before ? "ok  " : "FAIL", #test); \
+    fflush(stdout); \
+  } while (0)
+
+#define TEST_EXIT_STATUS() (s_test_failures == 0 ? 0 : 1)
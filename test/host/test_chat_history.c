@@ -0,0 +1,102 @@
+#include "test.h"
+#include "chat_driver.h"
+#include "text_pool.h"
+#include "memory_profile.h"
+
+#define TURN_COUNT 5000
+#define WINDOW_TURNS 1000
+#define WARMUP_TURNS 1000
+#define SMALL_POOL_SIZE 2048
+
+static unsigned s_seed = 1;
+static char s_screen[4096];
+
+static int random_length(int min, int max) {
+  s_seed = s_seed * 1103515245 + 12345;
+  return min + (s_seed >> 16) % (max - min + 1);
+}
+
+static void make_text(char *text, int length, char letter, int word_length) {
+  memset(text, letter, length);
+  for (int i = word_length; i < length; i += word_length + 1) {
+    text[i] = ' ';
+  }
+  text[length] = '\0';
+}
+
+// Thousands of messages are added (responses streamed in chunks, so their
+// text grows in the pool) and evicted: the heap must not move, every
+// response must be kept whole, and the free space of the text pool must stay as
+// contiguous at the end as it was once the pool first filled up
+static void run_history(const char *name) {
+  chat_driver_launch();
+  chat_driver_say("warm up");
+  chat_driver_respond("ready", 0, 0);
+  FakeCounters start = fake_counters();
+  printf("     %s: %d bytes\n", name, (int)text_pool_get_stats().total_bytes);
+
+  char text[700];
+  double fragmentation = 0;
+  double first_window = -1;
+  double worst_window = 0;
+  for (int turn = 1; turn <= TURN_COUNT; turn++) {
+    make_text(text, random_length(5, 120), 'u', 7);
+    chat_driver_say(text);
+    int length = random_length(1, 640);
+    make_text(text, length, 'a', 5);
+    char ending[16];
+    snprintf(ending, sizeof(ending), " turn%d", turn);
+    strcat(text, ending);
+    chat_driver_respond(text, 48, 30);
+
+    // The end of the response shows at the bottom of the screen
+    fake_render(s_screen, sizeof(s_screen));
+    CHECK(strstr(s_screen, ending) != NULL);
+
+    // Share of the free pool that is not in the largest free run
+    TextPoolStats stats = text_pool_get_stats();
+    fragmentation += stats.free_bytes ? 1.0 - (double)stats.largest_free_bytes / stats.free_bytes : 0;
+    if (turn % WINDOW_TURNS == 0) {
+      double average = fragmentation / WINDOW_TURNS;
+      printf("     %s, turns %4d-%4d: pool fragmentation %.2f, heap %zu bytes\n",
+             name, turn - WINDOW_TURNS + 1, turn, average, fake_counters().heap_used);
+      if (turn > WARMUP_TURNS && first_window < 0) {
+        first_window = average;
+      }
+      if (turn > WARMUP_TURNS && average > worst_window) {
+        worst_window = average;
+      }
+      fragmentation = 0;
+    }
+  }
+
+  FakeCounters end = fake_counters();
+  CHECK_EQ_INT(end.heap_used, start.heap_used);
+  CHECK_EQ_INT(end.failed_mallocs, 0);
+  CHECK(worst_window < first_window + 0.1);
+  chat_driver_close();
+}
+
+static void test_pool_does_not_fragment_over_time(void) {
+  run_history("large pool");
+}
+
+// With less heap the pool holds only a few messages, so it is evicted from
+// on almost every turn
+static void test_small_pool_does_not_fragment_over_time(void) {
+  // Find the heap free when the pool is sized, then shrink the heap so
+  // that about 2 KB is left for the pool
+  chat_driver_launch();
+  size_t heap_free = heap_bytes_free() + text_pool_get_stats().total_bytes;
+  chat_driver_close();
+  fake_reset();
+  fake_set_heap_size(FAKE_HEAP_SIZE - (heap_free - HEAP_SAFETY_MARGIN - SMALL_POOL_SIZE));
+
+  run_history("small pool");
+}
+
+int main(void) {
+  RUN_TEST(test_pool_does_not_fragment_over_time);
+  RUN_TEST(test_small_pool_does_not_fragment_over_time);
+  return TEST_EXIT_STATUS();
+}
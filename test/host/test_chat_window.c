@@ -0,0 +1,209 @@
+#include "test.h"
+#include "chat_driver.h"
+#include "conversation_codec.h"
+#include "memory_profile.h"
+#include "message_pages.h"
+
+static char s_screen[4096];
+
+static void test_turn_shows_on_screen(void) {
+  chat_driver_launch();
+  CHECK(fake_dictation_is_running());
+
+  uint32_t request_id = chat_driver_say("What is the tallest mountain?");
+  CHECK(request_id != 0);
+  chat_driver_respond("Mount Everest, at 8849 meters.", 8, 50);
+
+  // The response is shown at the bottom, the question above it
+  fake_render(s_screen, sizeof(s_screen));
+  CHECK(strstr(s_screen, "Mount Everest, at 8849 meters.") != NULL);
+  fake_click(BUTTON_ID_UP, false, 1);
+  fake_click(BUTTON_ID_UP, false, 1);
+  fake_render(s_screen, sizeof(s_screen));
+  CHECK(strstr(s_screen, "What is the tallest mountain?") != NULL);
+  chat_driver_close();
+  CHECK_EQ_INT(fake_counters().layers_alive, 0);
+}
+
+static void test_conversation_survives_relaunch(void) {
+  chat_driver_launch();
+  chat_driver_say("Remember this");
+  chat_driver_respond("I will.", 0, 0);
+  chat_driver_close();
+
+  chat_driver_launch();
+  fake_advance(1000);
+  fake_render(s_screen, sizeof(s_screen));
+  CHECK(strstr(s_screen, "Remember this") != NULL);
+  CHECK(strstr(s_screen, "I will.") != NULL);
+  chat_driver_close();
+  CHECK(fake_persist_bytes() <= FAKE_PERSIST_SIZE);
+}
+
+static void test_request_waits_for_connection(void) {
+  chat_driver_launch();
+  fake_set_connected(false);
+  CHECK_EQ_INT(chat_driver_say("Are you there?"), 0);
+
+  fake_render(s_screen, sizeof(s_screen));
+  CHECK(strstr(s_screen, "Queued") != NULL);
+
+  fake_set_connected(true);
+  fake_advance(FAKE_OUTBOX_ACK_DELAY);
+  DictionaryIterator *sent = fake_outbox_last();
+  CHECK(sent && dict_find(sent, MESSAGE_KEY_REQUEST_CHAT));
+
+  // Answered, so the queue is empty for the next test
+  chat_driver_respond("Yes.", 0, 0);
+  chat_driver_close();
+}
+
+// Count the occurrences of text in the screen
+static int count_on_screen(const char *text) {
+  int count = 0;
+  for (const char *found = strstr(s_screen, text); found; found = strstr(found + 1, text)) {
+    count++;
+  }
+  return count;
+}
+
+static void test_disconnect_mid_response(void) {
+  chat_driver_launch();
+  uint32_t request_id = chat_driver_say("Say hello");
+  CHECK(request_id != 0);
+
+  // The link drops after the first chunk of the response
+  chat_driver_send_cstring(MESSAGE_KEY_RESPONSE_TEXT, "Hello ");
+  fake_advance(200);
+  fake_set_connected(false);
+  fake_set_connected(true);
+  fake_advance(FAKE_OUTBOX_ACK_DELAY);
+
+  // The request is sent again, ending with the question (not the partial answer)
+  DictionaryIterator *sent = fake_outbox_last();
+  Tuple *request = sent ? dict_find(sent, MESSAGE_KEY_REQUEST_CHAT) : NULL;
+  CHECK(request != NULL);
+  ConversationDecoder decoder;
+  CHECK(request && conversation_decoder_init(&decoder, request->value->data, request->length));
+  CHECK_EQ_INT(decoder.request_id, request_id);
+  bool is_user = false;
+  const char *text = NULL;
+  size_t length = 0;
+  int messages = 0;
+  while (request && conversation_decoder_next(&decoder, &is_user, &text, &length)) {
+    messages++;
+  }
+  CHECK_EQ_INT(messages, 1);
+  CHECK(is_user);
+  CHECK(text && length == strlen("Say hello") && memcmp(text, "Say hello", length) == 0);
+
+  // The phone answers the retry with the whole response, shown once
+  chat_driver_respond("Hello ANSWER.", 0, 0);
+  fake_advance(1000);
+  fake_render(s_screen, sizeof(s_screen));
+  CHECK_EQ_INT(count_on_screen("Hello"), 1);
+  CHECK_EQ_INT(count_on_screen("Hello ANSWER."), 1);
+  chat_driver_close();
+}
+
+// Fill buffer with numbered sentences, about length bytes in all
+static void make_long_answer(char *buffer, size_t length) {
+  size_t used = 0;
+  buffer[0] = '\0';
+  for (int part = 1; used + 64 < length; part++) {
+    used += snprintf(buffer + used, length - used, "Sentence %d of a long answer. ", part);
+  }
+  snprintf(buffer + used, length - used, "THE END.");
+}
+
+static void test_long_response_keeps_its_end(void) {
+  static char answer[4800];
+  make_long_answer(answer, sizeof(answer));
+
+  chat_driver_launch();
+  chat_driver_say("Tell me everything");
+  chat_driver_respond(answer, 64, 20);
+  fake_advance(1000);
+
+  // The answer does not fit the page ring: its end is shown, with a marker
+  // where the middle was skipped
+  fake_render(s_screen, sizeof(s_screen));
+  CHECK(strstr(s_screen, "THE END.") != NULL);
+  for (int i = 0; i < 200; i++) {
+    fake_click(BUTTON_ID_UP, true, 1);
+  }
+  fake_advance(1000);
+  fake_render(s_screen, sizeof(s_screen));
+  CHECK(strstr(s_screen, "Sentence 1 of a long answer.") != NULL);
+  CHECK(strstr(s_screen, "...") != NULL);
+  chat_driver_close();
+}
+
+static void test_streaming_persists_pages_once(void) {
+  static char answer[2048];
+  make_long_answer(answer, sizeof(answer));
+
+  chat_driver_launch();
+  chat_driver_say("Tell me more");
+  int writes_before = fake_counters().persist_writes;
+  chat_driver_respond(answer, 24, 20);
+
+  // Each overflow page is persisted when it is complete, not on every chunk
+  // (a few more writes save the conversation at the end of the turn)
+  int writes = fake_counters().persist_writes - writes_before;
+  CHECK(writes <= MESSAGE_PAGE_COUNT + 8);
+  chat_driver_close();
+}
+
+static void test_session_keeps_heap_margin(void) {
+  static char answer[3000];
+  make_long_answer(answer, sizeof(answer));
+
+  chat_driver_launch();
+  for (int turn = 0; turn < 6; turn++) {
+    chat_driver_say("Tell me everything again");
+    chat_driver_respond(turn % 2 ? answer : "Short answer.", 64, 20);
+  }
+
+  // Windows opened later come out of the heap the text pool left free
+  fake_long_click(BUTTON_ID_SELECT);
+  fake_click(BUTTON_ID_BACK, false, 1);
+
+  // The heap (aplite's with LOW_MEMORY=1) never runs out, and at least half
+  // the safety margin stays free for the SDK's own allocations
+  FakeCounters counters = fake_counters();
+  CHECK_EQ_INT(counters.failed_mallocs, 0);
+  CHECK(counters.heap_peak + HEAP_SAFETY_MARGIN / 2 <= FAKE_HEAP_SIZE);
+  printf("     heap peak %zu of %d bytes\n", counters.heap_peak, FAKE_HEAP_SIZE);
+  chat_driver_close();
+}
+
+static void test_long_search_keeps_reduced_sniff(void) {
+  chat_driver_launch();
+  chat_driver_say("What happened today?");
+  CHECK_EQ_INT(fake_sniff_interval(), SNIFF_INTERVAL_REDUCED);
+
+  // A web search reports progress for longer than a plain request takes
+  for (int step = 0; step < 4; step++) {
+    fake_advance(15000);
+    chat_driver_send_cstring(MESSAGE_KEY_STATUS_TEXT, "Searching: news");
+  }
+  fake_advance(15000);
+  CHECK_EQ_INT(fake_sniff_interval(), SNIFF_INTERVAL_REDUCED);
+
+  chat_driver_respond("Nothing much.", 0, 0);
+  CHECK_EQ_INT(fake_sniff_interval(), SNIFF_INTERVAL_NORMAL);
+  chat_driver_close();
+}
+
+int main(void) {
+  RUN_TEST(test_turn_shows_on_screen);
+  RUN_TEST(test_conversation_survives_relaunch);
+  RUN_TEST(test_request_waits_for_connection);
+  RUN_TEST(test_disconnect_mid_response);
+  RUN_TEST(test_long_response_keeps_its_end);
+  RUN_TEST(test_streaming_persists_pages_once);
+  RUN_TEST(test_session_keeps_heap_margin);
+  RUN_TEST(test_long_search_keeps_reduced_sniff);
+  return TEST_EXIT_STATUS();
+}
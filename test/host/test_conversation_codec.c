@@ -0,0 +1,112 @@
+#include "test.h"
+#include "conversation_codec.h"
+
+#define LONG_TEXT "0123456789012345678901234567890123456789012345678901234567890123456789" \
+                  "012345678901234567890123456789012345678901234567890123456789"
+
+static size_t encode(uint8_t *buffer, size_t size, uint32_t request_id, bool is_user, const char *text) {
+  ConversationEncoder encoder;
+  CHECK(conversation_encoder_init(&encoder, buffer, size, request_id));
+  char *dest = conversation_encoder_begin_message(&encoder);
+  CHECK(strlen(text) <= conversation_encoder_get_available(&encoder));
+  memcpy(dest, text, strlen(text));
+  conversation_encoder_end_message(&encoder, is_user, strlen(text));
+  return encoder.length;
+}
+
+// Bytes of encodeConversation in src/pkjs/index.js for the same messages,
+// so both ends agree on the framing
+static void test_matches_phone_encoding(void) {
+  static const uint8_t expected_header[] = {
+    0x01, 0x01, 0x04, 0x03, 0x02, 0x01,              // version, flags, request ID
+    0x00, 0x09, 'H', 'i', ' ', '[', 'A', ']', ' ', 0xc3, 0xa9,  // user, 9 bytes
+    0x01, 0x82, 0x01,                                // Claude, 130 bytes
+  };
+
+  uint8_t buffer[256];
+  ConversationEncoder encoder;
+  CHECK(conversation_encoder_init(&encoder, buffer, sizeof(buffer), 0x01020304));
+  const char *texts[] = { "Hi [A] \xc3\xa9", LONG_TEXT };
+  for (int i = 0; i < 2; i++) {
+    char *dest = conversation_encoder_begin_message(&encoder);
+    memcpy(dest, texts[i], strlen(texts[i]));
+    conversation_encoder_end_message(&encoder, i == 0, strlen(texts[i]));
+  }
+
+  CHECK_EQ_INT(encoder.length, 150);
+  CHECK(memcmp(buffer, expected_header, sizeof(expected_header)) == 0);
+  CHECK(memcmp(buffer + sizeof(expected_header), LONG_TEXT, 130) == 0);
+}
+
+static void test_round_trip(void) {
+  uint8_t buffer[512];
+  ConversationEncoder encoder;
+  CHECK(conversation_encoder_init(&encoder, buffer, sizeof(buffer), 0));
+  CHECK_EQ_INT(encoder.length, conversation_codec_header_size(0));
+
+  const char *texts[] = { "", "[U]not a marker[A]", LONG_TEXT, "x" };
+  for (int i = 0; i < 4; i++) {
+    char *dest = conversation_encoder_begin_message(&encoder);
+    memcpy(dest, texts[i], strlen(texts[i]));
+    conversation_encoder_end_message(&encoder, i % 2 == 0, strlen(texts[i]));
+  }
+
+  ConversationDecoder decoder;
+  CHECK(conversation_decoder_init(&decoder, buffer, encoder.length));
+  CHECK_EQ_INT(decoder.request_id, 0);
+
+  bool is_user;
+  const char *text;
+  size_t length;
+  for (int i = 0; i < 4; i++) {
+    CHECK(conversation_decoder_next(&decoder, &is_user, &text, &length));
+    CHECK_EQ_INT(is_user, i % 2 == 0);
+    CHECK_EQ_INT(length, strlen(texts[i]));
+    CHECK(memcmp(text, texts[i], length) == 0);
+  }
+  CHECK(!conversation_decoder_next(&decoder, &is_user, &text, &length));
+}
+
+static void test_available_space(void) {
+  uint8_t buffer[32];
+  ConversationEncoder encoder;
+  CHECK(conversation_encoder_init(&encoder, buffer, sizeof(buffer), 7));
+  conversation_encoder_begin_message(&encoder);
+  CHECK_EQ_INT(conversation_encoder_get_available(&encoder),
+               sizeof(buffer) - conversation_codec_header_size(7) - CONVERSATION_CODEC_MESSAGE_OVERHEAD);
+
+  CHECK(!conversation_encoder_init(&encoder, buffer, 3, 7));
+}
+
+static void test_rejects_bad_input(void) {
+  uint8_t buffer[64];
+  ConversationDecoder decoder;
+
+  // Unknown version, and a request ID flag without the ID
+  const uint8_t newer[] = { 2, 0 };
+  const uint8_t short_id[] = { 1, CONVERSATION_CODEC_FLAG_REQUEST_ID, 1, 2 };
+  CHECK(!conversation_decoder_init(&decoder, newer, sizeof(newer)));
+  CHECK(!conversation_decoder_init(&decoder, short_id, sizeof(short_id)));
+
+  // A message longer than the data stops decoding
+  size_t length = encode(buffer, sizeof(buffer), 0, true, "hello");
+  CHECK(conversation_decoder_init(&decoder, buffer, length - 1));
+  bool is_user;
+  const char *text;
+  size_t text_length;
+  CHECK(!conversation_decoder_next(&decoder, &is_user, &text, &text_length));
+
+  // Unknown flags are ignored
+  buffer[1] |= 0x80;
+  CHECK(conversation_decoder_init(&decoder, buffer, length));
+  CHECK(conversation_decoder_next(&decoder, &is_user, &text, &text_length));
+  CHECK_EQ_INT(text_length, 5);
+}
+
+int main(void) {
+  RUN_TEST(test_matches_phone_encoding);
+  RUN_TEST(test_round_trip);
+  RUN_TEST(test_available_space);
+  RUN_TEST(test_rejects_bad_input);
+  return TEST_EXIT_STATUS();
+}
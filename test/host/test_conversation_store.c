@@ -0,0 +1,108 @@
+#include "test.h"
+#include "conversation_store.h"
+
+#define TURN_COUNT 40
+#define KEPT_MAX 64
+
+// Messages of the simulated conversation, oldest first
+static char s_texts[TURN_COUNT * 2][160];
+static int s_text_count = 0;
+
+// Messages read back by conversation_store_load
+static char s_loaded[KEPT_MAX][160];
+static int s_loaded_count = 0;
+
+static void add_message(int turn, bool is_user) {
+  snprintf(s_texts[s_text_count], sizeof(s_texts[0]), "%s %d: %.*s", is_user ? "Question" : "Answer", turn,
+           is_user ? 40 : 120, "The quick brown fox jumps over the lazy dog and keeps on running "
+           "past the river, the hill and the old mill until the sun goes down.");
+  s_text_count++;
+}
+
+// Save the newest messages that fit, as chat_window.c does
+static void save(void) {
+  size_t budget = conversation_store_capacity();
+  int first = s_text_count;
+  while (first > 0 && conversation_store_encoded_size(strlen(s_texts[first - 1])) <= budget) {
+    budget -= conversation_store_encoded_size(strlen(s_texts[first - 1]));
+    first--;
+  }
+
+  conversation_store_save_begin(42);
+  for (int i = first; i < s_text_count; i++) {
+    CHECK(conversation_store_save_message(s_texts[i], i % 2 == 0, 0, 0));
+  }
+  conversation_store_save_end();
+}
+
+static void loaded_handler(const char *text, bool is_user, uint8_t first_page, uint8_t page_count,
+                           void *context) {
+  if (s_loaded_count < KEPT_MAX) {
+    snprintf(s_loaded[s_loaded_count++], sizeof(s_loaded[0]), "%s", text);
+  }
+}
+
+static void check_loads_newest(void) {
+  uint32_t thread_id = 0;
+  s_loaded_count = 0;
+  int count = conversation_store_load(&thread_id, loaded_handler, NULL);
+  CHECK_EQ_INT(thread_id, 42);
+  CHECK(count > 0);
+  CHECK_EQ_INT(s_loaded_count, count);
+  for (int i = 0; i < count; i++) {
+    CHECK_EQ_STR(s_loaded[i], s_texts[s_text_count - count + i]);
+  }
+}
+
+static void test_ring_round_trip(void) {
+  s_text_count = 0;
+  conversation_store_load(&(uint32_t){ 0 }, loaded_handler, NULL);
+
+  for (int turn = 0; turn < TURN_COUNT; turn++) {
+    add_message(turn, true);
+    add_message(turn, false);
+    save();
+    if (turn % 7 == 6) {
+      // A relaunch in the middle of the conversation
+      check_loads_newest();
+    }
+  }
+  check_loads_newest();
+}
+
+// Once the store is full, every turn evicts the oldest messages; that must
+// not rewrite the records of the messages that stay
+static void test_turn_writes_only_its_records(void) {
+  s_text_count = 0;
+  conversation_store_load(&(uint32_t){ 0 }, loaded_handler, NULL);
+
+  int most_writes = 0;
+  for (int turn = 0; turn < TURN_COUNT; turn++) {
+    add_message(turn, true);
+    add_message(turn, false);
+    fake_counters_clear();
+    save();
+    if (turn >= 10) {
+      int writes = fake_counters().persist_writes;
+      if (writes > most_writes) {
+        most_writes = writes;
+      }
+    }
+  }
+
+  // The two new messages span at most two records, plus the header
+  CHECK(most_writes <= 3);
+  CHECK(most_writes > 0);
+
+  // Saving again without changes writes nothing
+  fake_counters_clear();
+  save();
+  CHECK_EQ_INT(fake_counters().persist_writes, 0);
+  check_loads_newest();
+}
+
+int main(void) {
+  RUN_TEST(test_ring_round_trip);
+  RUN_TEST(test_turn_writes_only_its_records);
+  return TEST_EXIT_STATUS();
+}
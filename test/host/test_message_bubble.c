@@ -0,0 +1,128 @@
+#include "test.h"
+#include "message_bubble.h"
+
+#define WIDTH 144
+
+static void test_measure_wraps_text(void) {
+  CHECK_EQ_INT(message_bubble_measure_text_height("", WIDTH), 0);
+  int one_line = message_bubble_measure_text_height("Hello", WIDTH);
+  CHECK(one_line > 0);
+  CHECK_EQ_INT(message_bubble_measure_text_height("Hello\nthere", WIDTH), 2 * one_line);
+}
+
+static void test_layout_measures_only_the_last_line(void) {
+  char text[1024] = "";
+  MessageBubbleLayout layout;
+  message_bubble_layout_reset(&layout);
+
+  // Grow the text a word at a time, as a streamed response does
+  size_t full_bytes = 0;
+  size_t layout_bytes = 0;
+  for (int i = 0; i < 120; i++) {
+    strcat(text, i % 9 == 8 ? "wrapping\n" : "word ");
+
+    size_t before = fake_counters().text_measure_bytes;
+    int height = message_bubble_layout_measure(&layout, text, WIDTH);
+    layout_bytes += fake_counters().text_measure_bytes - before;
+
+    before = fake_counters().text_measure_bytes;
+    CHECK_EQ_INT(height, message_bubble_measure_text_height(text, WIDTH));
+    full_bytes += fake_counters().text_measure_bytes - before;
+  }
+
+  CHECK(layout.anchor > 0);
+  CHECK(layout_bytes * 4 < full_bytes);
+}
+
+// Random texts grown by random appends (words, spaces, newlines, and runs
+// longer than a line) at random bubble widths from 130 px up to emery's
+// 200: the layout must always give the height of measuring the whole text
+static void test_layout_matches_full_measure(void) {
+  srand(1);
+  size_t full_bytes = 0;
+  size_t layout_bytes = 0;
+  int mismatches = 0;
+
+  for (int trial = 0; trial < 3000 && mismatches < 5; trial++) {
+    char text[600] = "";
+    MessageBubbleLayout layout;
+    message_bubble_layout_reset(&layout);
+    int width = 130 + rand() % 71;
+
+    size_t length = 0;
+    while (length < 500) {
+      int count = 1 + rand() % 30;
+      bool long_run = rand() % 40 == 0;
+      for (int i = 0; i < count; i++) {
+        int kind = rand() % 10;
+        char c = 'a' + rand() % 26;
+        if (kind == 0 || rand() % 7 == 0) {
+          c = ' ';
+        } else if (kind == 1 && rand() % 5 == 0) {
+          c = '\n';
+        }
+        text[length + i] = long_run ? 'z' : c;
+      }
+      length += count;
+      text[length] = '\0';
+
+      size_t before = fake_counters().text_measure_bytes;
+      int height = message_bubble_layout_measure(&layout, text, width);
+      layout_bytes += fake_counters().text_measure_bytes - before;
+
+      before = fake_counters().text_measure_bytes;
+      int expected = message_bubble_measure_text_height(text, width);
+      full_bytes += fake_counters().text_measure_bytes - before;
+
+      if (height != expected) {
+        fprintf(stderr, "trial %d: height %d, expected %d (length %d, anchor %d, width %d)\n",
+                trial, height, expected, (int)length, layout.anchor, width);
+        mismatches++;
+        break;
+      }
+    }
+  }
+
+  CHECK_EQ_INT(mismatches, 0);
+  printf("     measured %zu bytes for layouts, %zu bytes for whole texts\n", layout_bytes, full_bytes);
+  CHECK(layout_bytes < full_bytes);
+}
+
+static void test_layout_starts_over(void) {
+  char text[512] = "";
+  for (int i = 0; i < 20; i++) {
+    strcat(text, "several words ");
+  }
+  MessageBubbleLayout layout;
+  message_bubble_layout_reset(&layout);
+  message_bubble_layout_measure(&layout, text, WIDTH);
+  strcat(text, "more");
+  message_bubble_layout_measure(&layout, text, WIDTH);
+
+  // A new width lays out everything again
+  CHECK_EQ_INT(message_bubble_layout_measure(&layout, text, WIDTH / 2),
+               message_bubble_measure_text_height(text, WIDTH / 2));
+  CHECK_EQ_INT(layout.anchor, 0);
+
+  // So does text that got shorter
+  text[20] = '\0';
+  CHECK_EQ_INT(message_bubble_layout_measure(&layout, text, WIDTH / 2),
+               message_bubble_measure_text_height(text, WIDTH / 2));
+  CHECK_EQ_INT(layout.anchor, 0);
+}
+
+static void test_only_user_bubbles_have_a_background(void) {
+  message_bubble_draw_background(NULL, GRect(0, 0, WIDTH, 40), false);
+  CHECK_EQ_INT(fake_counters().rect_fills, 0);
+  message_bubble_draw_background(NULL, GRect(0, 0, WIDTH, 40), true);
+  CHECK_EQ_INT(fake_counters().rect_fills, 1);
+}
+
+int main(void) {
+  RUN_TEST(test_measure_wraps_text);
+  RUN_TEST(test_layout_measures_only_the_last_line);
+  RUN_TEST(test_layout_matches_full_measure);
+  RUN_TEST(test_layout_starts_over);
+  RUN_TEST(test_only_user_bubbles_have_a_background);
+  return TEST_EXIT_STATUS();
+}
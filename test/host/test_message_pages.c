@@ -0,0 +1,35 @@
+#include "test.h"
+#include "message_pages.h"
+
+// "é" is two bytes in UTF-8, so a cut at an odd length would split one
+static const char *ACCENTS = "\xC3\xA9\xC3\xA9\xC3\xA9\xC3\xA9\xC3\xA9";
+
+static void test_split_keeps_characters_whole(void) {
+  CHECK_EQ_INT(message_pages_split_length(ACCENTS, 10, 10), 10);
+  CHECK_EQ_INT(message_pages_split_length(ACCENTS, 10, 5), 4);
+  CHECK_EQ_INT(message_pages_split_length(ACCENTS, 10, 1), 0);
+  CHECK_EQ_INT(message_pages_split_length("one two three", 13, 9), 8);
+}
+
+static void test_copy_cuts_on_a_character(void) {
+  char dest[8];
+
+  // From a resident page
+  message_pages_write(0, ACCENTS, 10);
+  CHECK_EQ_INT(message_pages_copy(0, dest, 6), 4);
+  CHECK_EQ_STR(dest, "\xC3\xA9\xC3\xA9");
+
+  // From storage
+  message_pages_flush();
+  message_pages_reset();
+  CHECK_EQ_INT(message_pages_copy(0, dest, 6), 4);
+  CHECK_EQ_STR(dest, "\xC3\xA9\xC3\xA9");
+  CHECK_EQ_INT(message_pages_copy(0, dest, sizeof(dest)), 6);
+  message_pages_reset();
+}
+
+int main(void) {
+  RUN_TEST(test_split_keeps_characters_whole);
+  RUN_TEST(test_copy_cuts_on_a_character);
+  return TEST_EXIT_STATUS();
+}
@@ -0,0 +1,65 @@
+#include "test.h"
+#include "chat_driver.h"
+#include "replay.h"
+
+// Captured with "Record Message Traffic": two turns, the second answered in
+// two RESPONSE_TEXT chunks, each answer with suggestions
+#define TWO_TURNS_CAPTURE "captures/two_turns.tsv"
+
+static char s_screen[4096];
+
+static void test_capture_replays_both_turns(void) {
+  chat_driver_launch();
+  ReplayStats stats;
+  CHECK(replay_capture(TWO_TURNS_CAPTURE, NULL, &stats));
+
+  CHECK_EQ_INT(stats.events, 17);
+  CHECK_EQ_INT(stats.errors, 0);
+  CHECK_EQ_INT(stats.delivered, 6);
+  CHECK_EQ_INT(stats.dropped, 0);
+  CHECK_EQ_INT(stats.skipped, 0);
+
+  // The window sent the same conversation as in the capture both times
+  CHECK_EQ_INT(stats.requests, 2);
+  CHECK_EQ_INT(stats.requests_missing, 0);
+  CHECK_EQ_INT(stats.requests_mismatched, 0);
+
+  // The end of the second answer (36 numbered parts, longer than the page
+  // ring) is shown rather than truncated
+  fake_render(s_screen, sizeof(s_screen));
+  CHECK(strstr(s_screen, "(part 36)") != NULL);
+  CHECK_EQ_INT(fake_counters().failed_mallocs, 0);
+  chat_driver_close();
+  CHECK_EQ_INT(fake_counters().layers_alive, 0);
+}
+
+static void test_replay_is_deterministic(void) {
+  char first[sizeof(s_screen)];
+  ReplayStats stats;
+
+  chat_driver_launch();
+  replay_capture(TWO_TURNS_CAPTURE, NULL, &stats);
+  fake_render(first, sizeof(first));
+  uint32_t first_end_ms = fake_now_ms();
+  chat_driver_close();
+
+  fake_reset();
+  chat_driver_launch();
+  replay_capture(TWO_TURNS_CAPTURE, NULL, &stats);
+  fake_render(s_screen, sizeof(s_screen));
+  CHECK_EQ_STR(s_screen, first);
+  CHECK_EQ_INT(fake_now_ms(), first_end_ms);
+  chat_driver_close();
+}
+
+static void test_missing_capture_fails(void) {
+  ReplayStats stats;
+  CHECK(!replay_capture("captures/missing.tsv", NULL, &stats));
+}
+
+int main(void) {
+  RUN_TEST(test_capture_replays_both_turns);
+  RUN_TEST(test_replay_is_deterministic);
+  RUN_TEST(test_missing_capture_fails);
+  return TEST_EXIT_STATUS();
+}
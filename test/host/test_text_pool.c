@@ -0,0 +1,67 @@
+#include "test.h"
+#include "text_pool.h"
+
+static void test_alloc_takes_whole_slabs(void) {
+  CHECK(text_pool_init(10 * TEXT_POOL_SLAB_SIZE + 5));
+  CHECK_EQ_INT(text_pool_get_stats().total_bytes, 10 * TEXT_POOL_SLAB_SIZE);
+
+  char *a = text_pool_alloc(1);
+  char *b = text_pool_alloc(TEXT_POOL_SLAB_SIZE + 1);
+  CHECK(a && b);
+  CHECK_EQ_INT(b - a, TEXT_POOL_SLAB_SIZE);
+  CHECK_EQ_INT(text_pool_get_stats().free_bytes, 7 * TEXT_POOL_SLAB_SIZE);
+
+  CHECK(text_pool_alloc(0) == NULL);
+  text_pool_deinit();
+}
+
+static void test_free_reuses_space(void) {
+  CHECK(text_pool_init(4 * TEXT_POOL_SLAB_SIZE));
+  char *a = text_pool_alloc(2 * TEXT_POOL_SLAB_SIZE);
+  char *b = text_pool_alloc(2 * TEXT_POOL_SLAB_SIZE);
+  CHECK(a && b);
+  CHECK(text_pool_alloc(1) == NULL);
+
+  text_pool_free(a);
+  CHECK(text_pool_alloc(2 * TEXT_POOL_SLAB_SIZE) == a);
+
+  text_pool_free(NULL);
+  text_pool_deinit();
+}
+
+static void test_stats_report_fragmentation(void) {
+  CHECK(text_pool_init(6 * TEXT_POOL_SLAB_SIZE));
+  char *texts[6];
+  for (int i = 0; i < 6; i++) {
+    texts[i] = text_pool_alloc(TEXT_POOL_SLAB_SIZE);
+  }
+
+  // Free every other slab: half the pool is free, but only in single slabs
+  for (int i = 0; i < 6; i += 2) {
+    text_pool_free(texts[i]);
+  }
+  TextPoolStats stats = text_pool_get_stats();
+  CHECK_EQ_INT(stats.free_bytes, 3 * TEXT_POOL_SLAB_SIZE);
+  CHECK_EQ_INT(stats.largest_free_bytes, TEXT_POOL_SLAB_SIZE);
+  CHECK(text_pool_alloc(2 * TEXT_POOL_SLAB_SIZE) == NULL);
+
+  text_pool_free(texts[1]);
+  CHECK_EQ_INT(text_pool_get_stats().largest_free_bytes, 3 * TEXT_POOL_SLAB_SIZE);
+  text_pool_deinit();
+}
+
+static void test_init_fails_without_heap(void) {
+  fake_set_heap_size(1024);
+  CHECK(!text_pool_init(2048));
+  CHECK_EQ_INT(text_pool_get_stats().total_bytes, 0);
+  CHECK(text_pool_alloc(1) == NULL);
+  CHECK_EQ_INT(heap_bytes_used(), 0);
+}
+
+int main(void) {
+  RUN_TEST(test_alloc_takes_whole_slabs);
+  RUN_TEST(test_free_reuses_space);
+  RUN_TEST(test_stats_report_fragmentation);
+  RUN_TEST(test_init_fails_without_heap);
+  return TEST_EXIT_STATUS();
+}
@@ -0,0 +1,39 @@
+#include "conversation_codec.h"
+#include <stdio.h>
+
+// Decodes a conversation read from stdin with the watch's codec and encodes
+// it again to stdout, so the phone-side tests can check both ends agree
+// (test/pkjs/codec.test.js). Exits with 2 on a bad header and 3 on overflow.
+
+#define ROUNDTRIP_MAX_BYTES 65536
+
+int main(void) {
+  static uint8_t input[ROUNDTRIP_MAX_BYTES];
+  static uint8_t output[ROUNDTRIP_MAX_BYTES];
+  size_t length = fread(input, 1, sizeof(input), stdin);
+
+  ConversationDecoder decoder;
+  if (!conversation_decoder_init(&decoder, input, length)) {
+    fprintf(stderr, "Unsupported conversation header\n");
+    return 2;
+  }
+
+  ConversationEncoder encoder;
+  conversation_encoder_init(&encoder, output, sizeof(output), decoder.request_id);
+
+  bool is_user;
+  const char *text;
+  size_t text_length;
+  while (conversation_decoder_next(&decoder, &is_user, &text, &text_length)) {
+    char *destination = conversation_encoder_begin_message(&encoder);
+    if (text_length > conversation_encoder_get_available(&encoder)) {
+      fprintf(stderr, "Conversation does not fit\n");
+      return 3;
+    }
+    memcpy(destination, text, text_length);
+    conversation_encoder_end_message(&encoder, is_user, text_length);
+  }
+
+  fwrite(output, 1, encoder.length, stdout);
+  return 0;
+}
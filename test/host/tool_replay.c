@@ -0,0 +1,36 @@
+#include "chat_driver.h"
+#include "replay.h"
+
+// Replays a capture of AppMessage traffic (see replay.h) against the chat
+// window and prints each event, what the window sent, and the screen at the end:
+//   test/host/build/tool_replay capture.tsv
+
+static char s_screen[8192];
+
+int main(int argc, char **argv) {
+  if (argc != 2) {
+    fprintf(stderr, "Usage: %s <capture>\n", argv[0]);
+    return 2;
+  }
+
+  fake_reset();
+  chat_driver_launch();
+
+  ReplayStats stats;
+  if (!replay_capture(argv[1], stdout, &stats)) {
+    fprintf(stderr, "Cannot read %s\n", argv[1]);
+    return 2;
+  }
+
+  fake_render(s_screen, sizeof(s_screen));
+  FakeCounters counters = fake_counters();
+  printf("\nScreen:\n%s\n", s_screen);
+  printf("%d events: %d messages delivered, %d dropped, %d requests (%d missing, %d different), "
+         "%d skipped, %d errors\n", stats.events, stats.delivered, stats.dropped, stats.requests,
+         stats.requests_missing, stats.requests_mismatched, stats.skipped, stats.errors);
+  printf("Heap peak %d B, %d text measures, %d persist writes, %d failed mallocs\n",
+         (int)counters.heap_peak, counters.text_measures, counters.persist_writes, counters.failed_mallocs);
+
+  chat_driver_close();
+  return stats.errors || stats.requests_missing || stats.requests_mismatched ? 1 : 0;
+}
@@ -0,0 +1,159 @@
+// Round trips of the conversation codec (REQUEST_CHAT and THREAD_DATA byte
+// arrays) between the phone's encoder and decoder and, when it is built with
+// `make -C test/host tools`, the watch's codec.
+var test = require('node:test');
+var assert = require('node:assert');
+var fs = require('fs');
+var path = require('path');
+var childProcess = require('child_process');
+var harness = require('./harness');
+
+var ROUNDTRIP_TOOL = path.join(__dirname, '..', 'host', 'build', 'tool_conversation_roundtrip');
+var FUZZ_TRIALS = 500;
+
+// Text that would break the old "[U]...[A]..." framing, multi-byte UTF-8
+// (including surrogate pairs) and NUL
+var ALPHABET = ['a', 'b', ' ', '[U]', '[A]', '\n', 'é', '中', '😀', '\u0000', '\\'];
+
+// Seeded so a failure can be reproduced
+function createRandom(seed) {
+  var state = seed >>> 0;
+  return function (limit) {
+    state = (Math.imul(state, 1664525) + 1013904223) >>> 0;
+    return state % limit;
+  };
+}
+
+function randomText(random) {
+  var count = random(3) ? random(40) : random(400);
+  var text = '';
+  for (var i = 0; i < count; i++) {
+    text += ALPHABET[random(ALPHABET.length)];
+  }
+  return text;
+}
+
+function randomConversation(random) {
+  var messages = [];
+  var count = random(8);
+  for (var i = 0; i < count; i++) {
+    messages.push({ role: random(2) ? 'user' : 'assistant', content: randomText(random) });
+  }
+  return messages;
+}
+
+// Copy values out of the sandbox so they compare with this realm's objects
+function plain(value) {
+  return JSON.parse(JSON.stringify(value));
+}
+
+var app = harness.loadApp();
+var codec = app.context;
+
+test('phone encoder and decoder round trip any text', function () {
+  var random = createRandom(1);
+  for (var trial = 0; trial < FUZZ_TRIALS; trial++) {
+    var messages = randomConversation(random);
+    var requestId = random(2) ? random(0xFFFFFFFF) + 1 : 0;
+    var decoded = codec.decodeConversation(codec.encodeConversation(messages, requestId, 100000));
+
+    assert.strictEqual(decoded.requestId, requestId, 'trial ' + trial);
+    assert.deepStrictEqual(plain(decoded.messages), messages, 'trial ' + trial);
+  }
+});
+
+test('watch codec re-encodes phone conversations byte for byte', { skip: !fs.existsSync(ROUNDTRIP_TOOL) && 'run make -C test/host tools' }, function () {
+  var random = createRandom(2);
+  for (var trial = 0; trial < FUZZ_TRIALS; trial++) {
+    var messages = randomConversation(random);
+    var requestId = random(2) ? random(0xFFFFFFFF) + 1 : 0;
+    var encoded = Buffer.from(codec.encodeConversation(messages, requestId, 100000));
+    var reencoded = childProcess.execFileSync(ROUNDTRIP_TOOL, { input: encoded });
+
+    assert.ok(reencoded.equals(encoded), 'trial ' + trial);
+    assert.deepStrictEqual(plain(codec.decodeConversation(Array.from(reencoded)).messages), messages, 'trial ' + trial);
+  }
+});
+
+test('truncated conversations decode to whole messages only', function () {
+  var random = createRandom(3);
+  for (var trial = 0; trial < FUZZ_TRIALS; trial++) {
+    var messages = randomConversation(random);
+    var encoded = codec.encodeConversation(messages, random(2) ? trial + 1 : 0, 100000);
+    var decoded = codec.decodeConversation(encoded.slice(0, random(encoded.length + 1)));
+    if (!decoded) {
+      continue;
+    }
+
+    var kept = plain(decoded.messages);
+    assert.deepStrictEqual(kept, messages.slice(0, kept.length), 'trial ' + trial);
+  }
+});
+
+test('encoding keeps the newest messages that fit', function () {
+  var messages = [];
+  for (var i = 0; i < 50; i++) {
+    messages.push({ role: i % 2 ? 'assistant' : 'user', content: 'Message ' + i + ' ' + 'x'.repeat(200) });
+  }
+
+  var encoded = codec.encodeConversation(messages, 7, 4032);
+  assert.ok(encoded.length <= 4032);
+  assert.ok(encoded.length > 4032 - 250);
+
+  var decoded = plain(codec.decodeConversation(encoded).messages);
+  assert.deepStrictEqual(decoded, messages.slice(messages.length - decoded.length));
+});
+
+// Best time per call over a few rounds (the first rounds warm up the JIT)
+function timeCall(iterations, call) {
+  var best = Infinity;
+  for (var round = 0; round < 7; round++) {
+    var start = process.hrtime.bigint();
+    for (var i = 0; i < iterations; i++) {
+      call(i);
+    }
+    best = Math.min(best, Number(process.hrtime.bigint() - start) / iterations);
+  }
+  return best;
+}
+
+test('decoding is no slower than parsing the text framing', function (t) {
+  var messages = [];
+  for (var i = 0; i < 20; i++) {
+    messages.push({
+      role: i % 2 ? 'assistant' : 'user',
+      content: 'Hello there, this is message number ' + i + ' é 中 '.repeat(5)
+    });
+  }
+  var encoded = Array.from(codec.encodeConversation(messages, 1, 100000));
+  var legacy = messages.map(function (message) {
+    return (message.role === 'user' ? '[U]' : '[A]') + message.content;
+  }).join('');
+
+  // Both start from the bytes sent by the watch: the text framing came as a
+  // cstring, which is decoded from UTF-8 (here by the same decoder) before
+  // the regex runs
+  var legacyBytes = Array.from(Buffer.from(legacy));
+  var iterations = 2000;
+  var binaryNs = timeCall(iterations, function () {
+    codec.decodeConversation(encoded);
+  });
+  var legacyNs = timeCall(iterations, function () {
+    var units = new Array(legacyBytes.length);
+    units.length = codec.writeUtf16(units, 0, legacyBytes, 0, legacyBytes.length);
+    codec.parseConversation(codec.unitsText(units));
+  });
+  var parseNs = timeCall(iterations, function () {
+    codec.parseConversation(legacy);
+  });
+
+  t.diagnostic('binary decode ' + (binaryNs / 1000).toFixed(1) + ' us/op, ' + encoded.length + ' bytes');
+  t.diagnostic('text decode and parse ' + (legacyNs / 1000).toFixed(1) + ' us/op (parse alone ' +
+    (parseNs / 1000).toFixed(1) + ' us), ' + legacyBytes.length + ' bytes');
+
+  assert.deepStrictEqual(plain(codec.decodeConversation(encoded).messages), plain(codec.parseConversation(legacy)));
+  assert.ok(binaryNs <= legacyNs, 'decoding is slower than the text framing');
+
+  // Length prefixes cost about what the markers did
+  assert.ok(encoded.length <= legacyBytes.length + 6 + messages.length);
+});
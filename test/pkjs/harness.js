@@ -0,0 +1,124 @@
+// Loads src/pkjs/index.js into a sandbox with stand-ins for the PebbleKit JS
+// environment (Pebble, localStorage, XMLHttpRequest), so tests can call its
+// functions and play the watch and the API against it.
+var fs = require('fs');
+var path = require('path');
+var vm = require('vm');
+
+var PKJS_DIR = path.join(__dirname, '..', '..', 'src', 'pkjs');
+var INDEX_PATH = path.join(PKJS_DIR, 'index.js');
+
+function createLocalStorage(initial) {
+  var items = {};
+  Object.keys(initial || {}).forEach(function (key) {
+    items[key] = String(initial[key]);
+  });
+
+  return {
+    items: items,
+    getItem: function (key) {
+      return Object.prototype.hasOwnProperty.call(items, key) ? items[key] : null;
+    },
+    setItem: function (key, value) {
+      items[key] = String(value);
+    },
+    removeItem: function (key) {
+      delete items[key];
+    }
+  };
+}
+
+// A request is answered by the test with respond(status, body)
+function createXhrClass(requests) {
+  function FakeXMLHttpRequest() {
+    this.headers = {};
+    this.readyState = 0;
+    this.status = 0;
+    this.responseText = '';
+    requests.push(this);
+  }
+
+  FakeXMLHttpRequest.prototype.open = function (method, url) {
+    this.method = method;
+    this.url = url;
+    this.readyState = 1;
+  };
+  FakeXMLHttpRequest.prototype.setRequestHeader = function (name, value) {
+    this.headers[name] = value;
+  };
+  FakeXMLHttpRequest.prototype.send = function (body) {
+    this.body = body;
+  };
+  FakeXMLHttpRequest.prototype.json = function () {
+    return JSON.parse(this.body);
+  };
+  FakeXMLHttpRequest.prototype.respond = function (status, body) {
+    this.status = status;
+    this.responseText = typeof body === 'string' ? body : JSON.stringify(body);
+    this.readyState = 4;
+    if (this.onreadystatechange) {
+      this.onreadystatechange();
+    }
+    if (this.onload) {
+      this.onload();
+    }
+  };
+
+  return FakeXMLHttpRequest;
+}
+
+// Load index.js. Options: storage (initial localStorage items), log (print
+// the app's console output).
+function loadApp(options) {
+  options = options || {};
+  var handlers = {};
+  var sent = [];
+  var requests = [];
+  var localStorage = createLocalStorage(options.storage);
+
+  var context = {
+    console: { log: options.log ? console.log : function () {} },
+    localStorage: localStorage,
+    XMLHttpRequest: createXhrClass(requests),
+    Pebble: {
+      addEventListener: function (name, handler) {
+        handlers[name] = handler;
+      },
+      // Messages to the watch are acked right away
+      sendAppMessage: function (dict, success) {
+        sent.push(dict);
+        if (success) {
+          success();
+        }
+      },
+      openURL: function (url) {
+        app.openedUrl = url;
+      }
+    },
+    require: function (name) {
+      return require(path.join(PKJS_DIR, name));
+    }
+  };
+  vm.createContext(context);
+  vm.runInContext(fs.readFileSync(INDEX_PATH, 'utf8'), context, { filename: INDEX_PATH });
+
+  var app = {
+    // Top-level functions and variables of index.js
+    context: context,
+    localStorage: localStorage,
+    sent: sent,
+    requests: requests,
+    emit: function (name, event) {
+      handlers[name](event || {});
+    },
+    // Send a message from the watch
+    receive: function (payload) {
+      handlers.appmessage({ payload: payload });
+    }
+  };
+  return app;
+}
+
+module.exports = {
+  loadApp: loadApp
+};
@@ -0,0 +1,178 @@
+// Rolling summary of long threads: the watch only sends one outbox of
+// history, so compaction has to run on the transcript kept on the phone.
+var test = require('node:test');
+var assert = require('node:assert');
+var harness = require('./harness');
+
+var THREAD_ID = 5;
+var WATCH_OUTBOX_BYTES = 4096 - 64;
+
+function loadApp() {
+  return harness.loadApp({ storage: { api_key: 'test-key' } });
+}
+
+// Summary requests are the ones without a system prompt
+function isSummaryRequest(request) {
+  return request.json().system === undefined;
+}
+
+// Play one turn: the watch sends its newest messages, the API answers and,
+// if the phone asks for a summary, the summary model answers too
+function playTurn(app, history, turn) {
+  history.push({ role: 'user', content: 'Question ' + turn + ': ' + 'tell me more about it, '.repeat(10) });
+  var sentBefore = app.requests.length;
+  app.receive({
+    REQUEST_CHAT: app.context.encodeConversation(history, turn + 1, WATCH_OUTBOX_BYTES),
+    THREAD_ID: THREAD_ID
+  });
+
+  var chat = app.requests[sentBefore];
+  assert.ok(!isSummaryRequest(chat));
+  var answer = 'Answer ' + turn + ': ' + 'here is a longer explanation. '.repeat(12).trim();
+  chat.respond(200, { content: [{ type: 'text', text: answer }] });
+  history.push({ role: 'assistant', content: answer });
+
+  var summary = app.requests.slice(sentBefore + 1).filter(function (request) {
+    return isSummaryRequest(request);
+  })[0];
+  if (summary) {
+    summary.respond(200, { content: [{ type: 'text', text: 'Summary up to turn ' + turn + '.' }] });
+  }
+
+  return { chat: chat.json(), summarized: !!summary };
+}
+
+test('the watch alone never sends enough history to summarize', function () {
+  var app = loadApp();
+  var history = [];
+  for (var turn = 0; turn < 40; turn++) {
+    history.push({ role: turn % 2 ? 'assistant' : 'user', content: 'word '.repeat(100) });
+    var sent = app.context.decodeConversation(app.context.encodeConversation(history, turn + 1, WATCH_OUTBOX_BYTES));
+    assert.ok(app.context.estimateTokens(sent.messages) < app.context.SUMMARY_THRESHOLD_TOKENS);
+  }
+});
+
+test('a long thread is summarized and the summary replaces older turns', function (t) {
+  var app = loadApp();
+  var history = [];
+  var summarizedAt = -1;
+  var result;
+
+  for (var turn = 0; turn < 30 && summarizedAt < 0; turn++) {
+    result = playTurn(app, history, turn);
+    if (result.summarized) {
+      summarizedAt = turn;
+    }
+  }
+  assert.ok(summarizedAt > 0, 'no summary was made');
+  t.diagnostic('summarized after turn ' + summarizedAt);
+
+  var summary = JSON.parse(app.localStorage.getItem('summary_' + THREAD_ID));
+  assert.strictEqual(summary.text, 'Summary up to turn ' + summarizedAt + '.');
+
+  // The next request carries the summary and only the turns after it
+  result = playTurn(app, history, summarizedAt + 1);
+  assert.ok(result.chat.system.indexOf('Summary of the earlier conversation: ' + summary.text) >= 0);
+  assert.strictEqual(result.chat.messages[0].role, 'user');
+  assert.ok(result.chat.messages.length <= app.context.SUMMARY_KEEP_MESSAGES + 2);
+  assert.deepStrictEqual(result.chat.messages, history.slice(history.length - 1 - result.chat.messages.length, -1));
+  assert.ok(result.chat.messages.every(function (message) {
+    return !(message.role === summary.lastRole && message.content === summary.lastContent);
+  }));
+});
+
+test('requests stay flat however long the thread runs', function () {
+  var app = loadApp();
+  var history = [];
+  var sizes = [];
+  for (var turn = 0; turn < 60; turn++) {
+    var result = playTurn(app, history, turn);
+    sizes.push(JSON.stringify(result.chat).length);
+  }
+
+  var transcript = JSON.parse(app.localStorage.getItem('thread_' + THREAD_ID));
+  assert.strictEqual(transcript.length, history.length);
+  assert.ok(Math.max.apply(null, sizes.slice(30)) <= Math.max.apply(null, sizes.slice(0, 30)));
+});
+
+test('only messages that overlap the end of a thread extend it', function () {
+  var app = loadApp();
+  var stored = [{ role: 'user', content: 'a' }, { role: 'assistant', content: 'b' }];
+  var overlapping = [{ role: 'assistant', content: 'b' }, { role: 'user', content: 'c' }];
+  var unrelated = [{ role: 'user', content: 'x' }];
+
+  assert.deepStrictEqual(JSON.parse(JSON.stringify(app.context.mergeThread(stored, overlapping))),
+    [stored[0], stored[1], overlapping[1]]);
+  assert.strictEqual(app.context.mergeThread(stored, unrelated), null);
+  assert.deepStrictEqual(JSON.parse(JSON.stringify(app.context.mergeThread(null, unrelated))), unrelated);
+});
+
+test('a thread the watch does not overlap starts over without its summary', function () {
+  var app = loadApp();
+  var history = [];
+  for (var turn = 0; turn < 20; turn++) {
+    playTurn(app, history, turn);
+  }
+  assert.ok(app.localStorage.getItem('summary_' + THREAD_ID), 'no summary was made');
+
+  // The watch lost its conversation but kept the thread
+  var fresh = [];
+  var result = playTurn(app, fresh, 100);
+  assert.strictEqual(result.chat.system.indexOf('Summary of the earlier conversation'), -1);
+  assert.deepStrictEqual(result.chat.messages, fresh.slice(0, 1));
+  assert.strictEqual(app.localStorage.getItem('summary_' + THREAD_ID), null);
+  assert.deepStrictEqual(JSON.parse(app.localStorage.getItem('thread_' + THREAD_ID)), fresh);
+
+  // and goes on from there
+  result = playTurn(app, fresh, 101);
+  assert.deepStrictEqual(result.chat.messages, fresh.slice(0, 3));
+});
+
+test('a summary whose last message is not in the thread is not sent', function () {
+  var stored = [{ role: 'user', content: 'a' }, { role: 'assistant', content: 'b' }];
+  var app = harness.loadApp({
+    storage: {
+      api_key: 'test-key',
+      thread_index: JSON.stringify({ 5: { used: 1, size: 10 } }),
+      thread_5: JSON.stringify(stored),
+      summary_5: JSON.stringify({ text: 'Another conversation.', lastRole: 'user', lastContent: 'z' })
+    }
+  });
+
+  var history = stored.slice();
+  var result = playTurn(app, history, 0);
+  assert.strictEqual(result.chat.system.indexOf('Another conversation.'), -1);
+  assert.deepStrictEqual(result.chat.messages, history.slice(0, 3));
+});
+
+test('a request in an open thread reads nothing from storage before it is sent', function () {
+  var app = loadApp();
+  var history = [];
+  for (var turn = 0; turn < 20; turn++) {
+    playTurn(app, history, turn);
+  }
+  assert.ok(app.localStorage.getItem('summary_' + THREAD_ID), 'no summary was made');
+
+  // Count storage calls from the message until the request is sent
+  var calls = [];
+  ['getItem', 'setItem', 'removeItem'].forEach(function (name) {
+    var original = app.localStorage[name];
+    app.localStorage[name] = function (key) {
+      calls.push(name + ' ' + key);
+      return original.apply(this, arguments);
+    };
+  });
+  var callsAtSend = -1;
+  var send = app.context.XMLHttpRequest.prototype.send;
+  app.context.XMLHttpRequest.prototype.send = function (body) {
+    if (callsAtSend < 0) {
+      callsAtSend = calls.length;
+    }
+    send.call(this, body);
+  };
+
+  var result = playTurn(app, history, 20);
+  assert.deepStrictEqual(calls.slice(0, callsAtSend), []);
+  assert.ok(result.chat.system.indexOf('Summary of the earlier conversation: ') >= 0);
+  assert.strictEqual(result.chat.messages[result.chat.messages.length - 1].content, history[history.length - 2].content);
+});